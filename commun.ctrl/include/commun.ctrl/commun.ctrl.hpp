@@ -1,12 +1,14 @@
 #pragma once
 #include <commun/upsert.hpp>
 #include <commun/config.hpp>
+#include <commun/math.hpp>
 #include <commun/dispatchers.hpp>
 
 #include <eosio/time.hpp>
 //#include <eosiolib/eosio.hpp>
 #include <eosio/asset.hpp>
 #include <eosio/transaction.hpp>
+#include <eosio/crypto.hpp>
 #include <eosio/binary_extension.hpp>
 //#include <eosio/public_key.hpp>
 #include <commun.list/commun.list.hpp>
@@ -31,7 +33,11 @@ struct leader_info {
     uint64_t total_weight;  //!< total \a weight of the leader taking into account the votes cast for him/her
     uint64_t counter_votes; //!< counter of votes cast for the leader
     
-    int64_t unclaimed_points = 0; //!< the points accumulated from emission and not yet claimed by leader via \ref control::claim
+    int64_t unclaimed_points = 0; //!< the points accumulated from emission and not yet claimed by leader via \ref control::claim; the reward since \a reward_checkpoint is added to it only when the leader is changed
+
+    // the fields below are absent in the rows created before the reward accumulator, they are set by \ref control::settle_reward
+    eosio::binary_extension<bool> in_top = false;             //!< \a true if the leader gets a share of emission
+    eosio::binary_extension<uint128_t> reward_checkpoint = 0; //!< the reward per weight accumulator of the community when \a unclaimed_points was updated last time
 
     uint64_t primary_key() const {
         return name.value;
@@ -67,6 +73,22 @@ using leadervote_byleader_idx [[using eosio: order("leader","asc"), order("voter
 
 using leader_vote_tbl [[using eosio: scope_type("symbol_code"), order("id","asc"), contract("commun.ctrl")]] = eosio::multi_index<"leadervote"_n, leader_voter, leadervote_byvoter_idx, leadervote_byleader_idx>;
 
+/**
+  \brief A summary of the votes cast by a voter, so that a new vote can be checked without walking all the voter's \a leadervote records. The record is removed when the voter has no votes.
+
+  \ingroup control_tables
+ */
+// DOCS_TABLE: voter_info
+struct voter_info {
+    name voter;         //!< a voter name
+    uint8_t votes_num;  //!< number of votes cast by the voter
+    uint16_t pct_sum;   //!< total share (in percent) of strength cast by the voter
+
+    uint64_t primary_key() const { return voter.value; }
+};
+
+using voter_tbl [[using eosio: scope_type("symbol_code"), order("voter","asc"), contract("commun.ctrl")]] = eosio::multi_index<"voter"_n, voter_info>;
+
 /**
   \brief DB record containing information about a proposed transaction which needs to be signed by the accounts specified in this transaction.
   \ingroup control_tables
@@ -77,8 +99,18 @@ struct proposal {
     symbol_code commun_code; //!< symbol of the community whose leaders have to sign the transaction. It may be a company name whose representatives are entitled to sign the transaction
     name permission; //!< a level of permission required to sign the transaction. A person signing the transaction should have a permission level not lower than specified one
     std::vector<char> packed_transaction; //!< the proposed transaction
+    eosio::binary_extension<time_point_sec> expiration; //!< expiration time taken from the transaction header when the proposal is created; empty for older proposals
+    eosio::binary_extension<checksum256> trx_hash; //!< sha256 of \a packed_transaction, calculated once when the proposal is created; empty for older proposals
 
     uint64_t primary_key()const { return proposal_name.value; }
+
+    // proposals created before the fields were added are read from the packed transaction
+    time_point_sec get_expiration()const {
+        return expiration.has_value() ? expiration.value() : eosio::unpack<eosio::transaction_header>(packed_transaction).expiration;
+    }
+    checksum256 get_trx_hash()const {
+        return trx_hash.has_value() ? trx_hash.value() : eosio::sha256(packed_transaction.data(), packed_transaction.size());
+    }
 };
 
 using proposals [[using eosio: order("proposal_name","asc"), contract("commun.ctrl")]] = eosio::multi_index< "proposal"_n, proposal>;
@@ -132,6 +164,32 @@ control: public contract {
     struct stat_struct {
         uint64_t id;
         int64_t retained = 0;
+
+        // the fields below are absent in the rows created before the reward accumulator, init_reward sets them;
+        // such a row has leaders_num 0, so the first emission counts the top
+        eosio::binary_extension<uint128_t> reward_per_weight = 0; //!< the leaders reward per unit of weight accumulated since the start, see \ref math::reward_per_weight
+        eosio::binary_extension<uint64_t> top_weight = 0;          //!< total weight of the leaders getting reward (with \a in_top flag)
+        eosio::binary_extension<uint8_t> top_num = 0;              //!< number of the leaders getting reward
+        eosio::binary_extension<uint8_t> leaders_num = 0;          //!< \a leaders_num parameter of the community when the top was updated
+        eosio::binary_extension<int128_t> reward_dust = 0;         //!< remainders of the leaders shares less the excesses of the rounded up \a reward_per_weight in 1/\ref math::reward_per_weight_scale of a point, negative until the shares are accrued, whole points are moved to \a retained
+
+        void init_reward() {
+            reward_per_weight = reward_per_weight.value_or();
+            top_weight = top_weight.value_or();
+            top_num = top_num.value_or();
+            leaders_num = leaders_num.value_or();
+            reward_dust = reward_dust.value_or();
+        }
+        void add_reward_dust(int128_t dust) {
+            init_reward();
+            const int128_t scale = math::reward_per_weight_scale;
+            auto total = reward_dust.value() + dust;
+            if (total >= scale) {
+                retained += static_cast<int64_t>(total / scale);
+                total %= scale;
+            }
+            reward_dust = total;
+        }
         uint64_t primary_key() const { return id; }
     };
 
@@ -312,6 +370,7 @@ public:
     */
     [[eosio::action]] void changepoints(name who, asset diff);
     ON_TRANSFER(COMMUN_POINT) void on_points_transfer(name from, name to, asset quantity, std::string memo);
+    ON_MINT(COMMUN_POINT) void on_points_mint(name receiver, asset quantity);
 
     /**
         \brief The \ref propose action is used to create a multi-signature transaction offer (proposed transaction) requiring permission from leaders.
@@ -432,13 +491,26 @@ private:
     };
 
     void send_leader_event(symbol_code commun_code, const leader_info& wi);
+    void settle_reward(symbol_code commun_code, leader_info& wi);
+    void recount_top(symbol_code commun_code);
+    void update_top(symbol_code commun_code, name leader, uint64_t prev_weight);
     void active_leader(symbol_code commun_code, name leader, bool flag);
     int64_t get_power(symbol_code commun_code, name voter, uint16_t pct);
+    voter_info get_voter_summary(symbol_code commun_code, name voter);
+    void set_voter_summary(symbol_code commun_code, const voter_info& summary);
 
 public:
     static inline bool in_the_top(symbol_code commun_code, name account) {
         const auto l = commun_list::get_control_param(commun_code).leaders_num;
         leader_tbl leader(config::control_name, commun_code.raw());
+        stats stats_table(config::control_name, commun_code.raw());
+        auto stat = stats_table.find(commun_code.raw());
+        if (stat != stats_table.end() && stat->leaders_num.value_or() == l) {   // the in_top flags are kept for the current leaders_num
+            auto itr = leader.find(account.value);
+            return itr != leader.end() && itr->in_top.value_or();
+        }
+
+        // leaders of the dApp, or the top is not counted since leaders_num was changed
         auto idx = leader.get_index<"byweight"_n>();    // this index ordered descending
         size_t i = 0;
         for (auto itr = idx.begin(); itr != idx.end() && i < l; ++itr) {
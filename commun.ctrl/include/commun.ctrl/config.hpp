@@ -1,6 +1,9 @@
 #pragma once
+#include <commun/defaults.hpp>
+
 namespace commun { namespace config {
 
 static const auto leader_max_url_size = 256;
 static const uint16_t max_clearvotes_count = 100;
+static constexpr uint16_t vote_pct_step = 10 * _1percent; // pct of a leader vote is a multiple of it
 } } // commun::config
@@ -38,36 +38,36 @@ void control::on_points_transfer(name from, name to, asset quantity, std::string
     
     auto commun_code = quantity.symbol.code();
     const auto l = commun_list::get_control_param(commun_code).leaders_num;
-    leader_tbl leader_table(_self, commun_code.raw());
-    auto idx = leader_table.get_index<"byweight"_n>();
-    
-    stats stats_table(_self, commun_code.raw());
-    const auto& stat = stats_table.get(commun_code.raw(), "stat does not exists");
-    
-    uint64_t weight_sum = 0;
-    size_t i = 0;
-    for (auto itr = idx.begin(); itr != idx.end() && i < l; ++itr) {
-        if (itr->active && itr->total_weight > 0) {
-            weight_sum += itr->total_weight;
-            ++i;
-        }
+    if (stats(_self, commun_code.raw()).get(commun_code.raw(), "stat does not exists").leaders_num.value_or() != l) {
+        recount_top(commun_code);   // leaders_num was changed or the top was never counted
     }
-    
+
+    stats stats_table(_self, commun_code.raw());
+    const auto& stat = stats_table.get(commun_code.raw());
+
+    // leaders get their shares lazily, see settle_reward; the accumulator is rounded up, so the shares are the same
+    // as with the eager distribution, the remainders of the shares less the excess are collected in reward_dust
     auto left_reward = quantity.amount + stat.retained;
-    if (weight_sum) {
-        int64_t reward_sum = safe_prop(left_reward, i, l);
-        i = 0;
-        for (auto itr = idx.begin(); itr != idx.end() && i < l; ++itr) {
-            if (itr->active && itr->total_weight > 0) {
-                auto leader_reward = safe_prop(reward_sum, itr->total_weight, weight_sum);
-                idx.modify(itr, eosio::same_payer, [&](auto& w) { w.unclaimed_points += leader_reward; });
-                left_reward -= leader_reward;
-                ++i;
-            }
-        }
+    uint128_t reward_per_weight = 0;
+    uint128_t excess = 0;
+    auto top_weight = stat.top_weight.value_or();
+    if (top_weight) {
+        int64_t reward_sum = math::leaders_reward_pool(left_reward, stat.top_num.value_or(), l);
+        reward_per_weight = math::reward_per_weight(reward_sum, top_weight);
+        excess = math::reward_per_weight_excess(reward_sum, top_weight);
+        left_reward -= reward_sum;
     }
-    
-    stats_table.modify(stat, name(), [&]( auto& s) { s.retained = left_reward; });
+
+    stats_table.modify(stat, name(), [&]( auto& s) {
+        s.init_reward();
+        s.retained = left_reward;
+        s.reward_per_weight = s.reward_per_weight.value() + reward_per_weight;
+        s.add_reward_dust(-static_cast<int128_t>(excess));
+    });
+}
+
+void control::on_points_mint(name receiver, asset quantity) {
+    on_points_transfer(config::point_name, receiver, quantity, string());
 }
 
 void control::regleader(symbol_code commun_code, name leader, string url) {
@@ -75,12 +75,17 @@ void control::regleader(symbol_code commun_code, name leader, string url) {
     eosio::check(url.length() <= config::leader_max_url_size, "url too long");
     require_auth(leader);
 
+    bool activated = false;
     upsert_tbl<leader_tbl>(_self, commun_code.raw(), leader, leader.value, [&](bool exists) {
         return [&,exists](leader_info& w) {
+            activated = exists && !w.active;
             w.name = leader;
             w.active = true;
         };
     });
+    if (activated) {
+        update_top(commun_code, leader, leader_tbl(_self, commun_code.raw()).get(leader.value).total_weight);
+    }
 }
 
 void control::clearvotes(symbol_code commun_code, name leader, std::optional<uint16_t> count) {
@@ -97,13 +102,27 @@ void control::clearvotes(symbol_code commun_code, name leader, std::optional<uin
     int64_t diff_weight = 0;
     leader_vote_tbl tbl(_self, commun_code.raw());
     auto idx = tbl.get_index<"byleader"_n>();
+    voter_tbl voters(_self, commun_code.raw());
     uint16_t i = 0;
     for (auto itr = idx.lower_bound(std::make_tuple(leader, name())); itr != idx.end() && itr->leader == leader && i < actual_count;) {
         diff_weight += get_power(commun_code, itr->voter, itr->pct);
+        auto summary = voters.find(itr->voter.value);
+        if (summary != voters.end()) {
+            if (summary->votes_num > 1) {
+                voters.modify(summary, eosio::same_payer, [&](auto& v) {
+                    --v.votes_num;
+                    v.pct_sum -= itr->pct;
+                });
+            } else {
+                voters.erase(summary);
+            }
+        }
         itr = idx.erase(itr);
         i++;
     }
+    // the leader is inactive, so it isn't in the top and the top is not changed
     leader_table.modify(leader_it, eosio::same_payer, [&](auto& w) {
+        settle_reward(commun_code, w);
         w.counter_votes -= i;
         w.total_weight -= diff_weight;
         send_leader_event(commun_code, w);
@@ -138,22 +157,20 @@ void control::voteleader(symbol_code commun_code, name voter, name leader, std::
     require_auth(voter);
     eosio::check(!pct.has_value() || *pct, "pct can't be 0");
     eosio::check(!pct.has_value() || *pct <= config::_100percent, "pct can't be greater than 100%");
-    eosio::check(!pct.has_value() || *pct % (10 * config::_1percent) == 0, "incorrect pct");
+    eosio::check(!pct.has_value() || *pct % config::vote_pct_step == 0, "incorrect pct");
 
     leader_tbl leader_table(_self, commun_code.raw());
     auto leader_it = leader_table.find(leader.value);
     eosio::check(leader_it != leader_table.end(), "leader not found");
     eosio::check(leader_it->active, "leader not active");
     
-    uint16_t prev_votes_sum = 0;
-    uint8_t votes_num = 0;
     leader_vote_tbl tbl(_self, commun_code.raw());
     auto idx = tbl.get_index<"byvoter"_n>();
-    for (auto itr = idx.lower_bound(std::make_tuple(voter, name())); itr != idx.end() && itr->voter == voter; itr++) {
-        eosio::check(itr->leader != leader, "already voted");
-        prev_votes_sum += itr->pct;
-        votes_num++;
-    }
+    eosio::check(idx.find(std::make_tuple(voter, leader)) == idx.end(), "already voted");
+
+    auto summary = get_voter_summary(commun_code, voter);
+    uint16_t prev_votes_sum = summary.pct_sum;
+    uint8_t votes_num = summary.votes_num;
     
     eosio::check(votes_num < commun_list::get_control_param(commun_code).max_votes, "all allowed votes already casted");
     eosio::check(prev_votes_sum <= config::_100percent, "SYSTEM: incorrect prev_votes_sum");
@@ -168,12 +185,18 @@ void control::voteleader(symbol_code commun_code, name voter, name leader, std::
         .leader = leader,
         .pct = actual_pct
     };});
+    ++summary.votes_num;
+    summary.pct_sum += actual_pct;
+    set_voter_summary(commun_code, summary);
     
+    auto prev_weight = leader_it->total_weight;
     leader_table.modify(leader_it, eosio::same_payer, [&](auto& w) {
+        settle_reward(commun_code, w);
         ++w.counter_votes;
         w.total_weight += get_power(commun_code, voter, actual_pct);
         send_leader_event(commun_code, w);
     });
+    update_top(commun_code, leader, prev_weight);
     
     if (commun_code) {
         emit::maybe_issue_reward(commun_code, _self);
@@ -193,12 +216,19 @@ void control::unvotelead(symbol_code commun_code, name voter, name leader) {
     auto itr = idx.find(std::make_tuple(voter, leader));
     eosio::check(itr != idx.end(), "there is no vote for this leader");
     
+    auto prev_weight = leader_it->total_weight;
     leader_table.modify(leader_it, eosio::same_payer, [&](auto& w) {
+        settle_reward(commun_code, w);
         --w.counter_votes;
         w.total_weight -= get_power(commun_code, voter, itr->pct);
         send_leader_event(commun_code, w);
     });
+    update_top(commun_code, leader, prev_weight);
     
+    auto summary = get_voter_summary(commun_code, voter);
+    --summary.votes_num;
+    summary.pct_sum -= itr->pct;
+    set_voter_summary(commun_code, summary);
     idx.erase(itr);
     
     if (commun_code) {
@@ -213,15 +243,18 @@ void control::claim(symbol_code commun_code, name leader) {
     leader_tbl leader_table(_self, commun_code.raw());
     auto leader_it = leader_table.find(leader.value);
     eosio::check(leader_it != leader_table.end(), "leader not found");
-    eosio::check(leader_it->unclaimed_points >= 0, "SYSTEM: incorrect unclaimed_points");
-    eosio::check(leader_it->unclaimed_points, "nothing to claim");
-    
-    INLINE_ACTION_SENDER(point, transfer)(config::point_name, {_self, config::transfer_permission},
-        {_self, leader, asset(leader_it->unclaimed_points, point::get_supply(commun_code).symbol), "claimed points"});
     
+    int64_t amount = 0;
     leader_table.modify(leader_it, eosio::same_payer, [&](auto& w) {
+        settle_reward(commun_code, w);
+        amount = w.unclaimed_points;
         w.unclaimed_points = 0;
     });
+    eosio::check(amount >= 0, "SYSTEM: incorrect unclaimed_points");
+    eosio::check(amount, "nothing to claim");
+    
+    INLINE_ACTION_SENDER(point, transfer)(config::point_name, {_self, config::transfer_permission},
+        {_self, leader, asset(amount, point::get_supply(commun_code).symbol), "claimed points"});
 }
 
 void control::emit(symbol_code commun_code) {
@@ -237,6 +270,38 @@ int64_t control::get_power(symbol_code commun_code, name voter, uint16_t pct = c
         point::get_assigned_reserve_amount(voter));
 }
 
+voter_info control::get_voter_summary(symbol_code commun_code, name voter) {
+    voter_tbl voters(_self, commun_code.raw());
+    auto itr = voters.find(voter.value);
+    if (itr != voters.end()) {
+        return *itr;
+    }
+
+    // no summary yet: the voter has no votes or cast them before summaries were introduced
+    voter_info summary{voter, 0, 0};
+    leader_vote_tbl tbl(_self, commun_code.raw());
+    auto idx = tbl.get_index<"byvoter"_n>();
+    for (auto vote = idx.lower_bound(std::make_tuple(voter, name())); vote != idx.end() && vote->voter == voter; vote++) {
+        summary.votes_num++;
+        summary.pct_sum += vote->pct;
+    }
+    return summary;
+}
+
+void control::set_voter_summary(symbol_code commun_code, const voter_info& summary) {
+    voter_tbl voters(_self, commun_code.raw());
+    auto itr = voters.find(summary.voter.value);
+    if (!summary.votes_num) {
+        if (itr != voters.end()) {
+            voters.erase(itr);
+        }
+    } else if (itr == voters.end()) {
+        voters.emplace(summary.voter, [&](auto& v) { v = summary; });
+    } else {
+        voters.modify(itr, eosio::same_payer, [&](auto& v) { v = summary; });
+    }
+}
+
 void control::changepoints(name who, asset diff) {
     symbol_code commun_code = diff.symbol.code();
     require_auth(_self);
@@ -248,12 +313,18 @@ void control::changepoints(name who, asset diff) {
     auto idx = tbl.get_index<"byvoter"_n>();
     for (auto itr = idx.lower_bound(std::make_tuple(who, name())); itr != idx.end() && itr->voter == who; itr++) {
         auto diff_weight = safe_pct(itr->pct, total_power) - safe_pct(itr->pct, total_power - diff.amount);
+        if (!diff_weight) {
+            continue;
+        }
         auto leader_it = leader_table.find(itr->leader.value);
         eosio::check(leader_it != leader_table.end(), "SYSTEM: leader not found: " + itr->leader.to_string());
+        auto prev_weight = leader_it->total_weight;
         leader_table.modify(leader_it, eosio::same_payer, [&](auto& w) {
+            settle_reward(commun_code, w);
             w.total_weight += diff_weight;
             send_leader_event(commun_code, w);
         });
+        update_top(commun_code, itr->leader, prev_weight);
     }
 }
 
@@ -267,12 +338,190 @@ void control::active_leader(symbol_code commun_code, name leader, bool flag) {
     bool exists = upsert_tbl<leader_tbl>(_self, commun_code.raw(), _self, leader.value, [&](bool) {
         return [&](leader_info& w) {
             eosio::check(flag != w.active, "active flag not updated");
+            settle_reward(commun_code, w);
             w.active = flag;
 
             send_leader_event(commun_code, w);
         };
     }, false);
     eosio::check(exists, "leader not found");
+    update_top(commun_code, leader, leader_tbl(_self, commun_code.raw()).get(leader.value).total_weight);  // the weight is not changed
+}
+
+void control::settle_reward(symbol_code commun_code, leader_info& wi) {
+    stats stats_table(_self, commun_code.raw());
+    auto stat = stats_table.find(commun_code.raw());
+    if (stat == stats_table.end()) {
+        return;
+    }
+    auto acc = stat->reward_per_weight.value_or();
+    if (wi.in_top.value_or()) {
+        auto checkpoint = wi.reward_checkpoint.value_or();
+        wi.unclaimed_points += math::accrued_reward(wi.total_weight, acc, checkpoint);
+        auto dust = math::accrued_remainder(wi.total_weight, acc, checkpoint);
+        if (dust) {
+            stats_table.modify(stat, eosio::same_payer, [&](auto& s) { s.add_reward_dust(dust); });
+        }
+    }
+    wi.in_top = wi.in_top.value_or();
+    wi.reward_checkpoint = acc;
+}
+
+void control::recount_top(symbol_code commun_code) {
+    stats stats_table(_self, commun_code.raw());
+    auto stat = stats_table.find(commun_code.raw());
+    if (stat == stats_table.end()) {
+        return; // leaders of the dApp don't get reward
+    }
+    const auto l = commun_list::get_control_param(commun_code).leaders_num;
+    leader_tbl leader_table(_self, commun_code.raw());
+    auto idx = leader_table.get_index<"byweight"_n>();    // this index ordered descending
+
+    uint64_t top_weight = 0;
+    uint8_t top_num = 0;
+    auto prev_num = stat->top_num.value_or();  // leaders of the previous top not visited yet
+    for (auto itr = idx.begin(); itr != idx.end() && (top_num < l || prev_num); ++itr) {
+        bool in_top = top_num < l && itr->active && itr->total_weight > 0;
+        bool was_in_top = itr->in_top.value_or();
+        if (was_in_top) {
+            eosio::check(prev_num, "SYSTEM: incorrect top_num");
+            --prev_num;
+        }
+        if (in_top) {
+            top_weight += itr->total_weight;
+            ++top_num;
+        }
+        if (in_top != was_in_top) {
+            idx.modify(itr, eosio::same_payer, [&](auto& w) {
+                settle_reward(commun_code, w);
+                w.in_top = in_top;
+            });
+        }
+    }
+    eosio::check(!prev_num, "SYSTEM: incorrect top_num");
+
+    stats updated_stats(_self, commun_code.raw());    // settle_reward could modify the row
+    const auto& updated = updated_stats.get(commun_code.raw());
+    if (updated.top_weight.value_or() == top_weight && updated.top_num.value_or() == top_num && updated.leaders_num.value_or() == l) {
+        return;
+    }
+    updated_stats.modify(updated, eosio::same_payer, [&](auto& s) {
+        s.init_reward();
+        s.top_weight = top_weight;
+        s.top_num = top_num;
+        s.leaders_num = l;
+    });
+}
+
+// the top is kept not lighter than any active leader outside of it, so a change of one leader
+// moves at most one leader across the boundary, only the leaders near the boundary are visited
+void control::update_top(symbol_code commun_code, name leader, uint64_t prev_weight) {
+    stats stats_table(_self, commun_code.raw());
+    auto stat = stats_table.find(commun_code.raw());
+    if (stat == stats_table.end()) {
+        return; // leaders of the dApp don't get reward
+    }
+    const auto l = commun_list::get_control_param(commun_code).leaders_num;
+    if (stat->leaders_num.value_or() != l) {
+        recount_top(commun_code);
+        return;
+    }
+    auto top_num = stat->top_num.value_or();
+
+    leader_tbl leader_table(_self, commun_code.raw());
+    auto idx = leader_table.get_index<"byweight"_n>();    // this index ordered descending, lower_bound finds the first not heavier leader
+    const auto& changed = leader_table.get(leader.value, "SYSTEM: leader not found");
+    auto weight = changed.total_weight;
+    bool eligible = changed.active && weight > 0;
+    bool was_in_top = changed.in_top.value_or();
+
+    auto is_outsider = [&](const leader_info& w) {
+        return w.name != leader && !w.in_top.value_or() && w.active && w.total_weight > 0;
+    };
+    auto set_in_top = [&](name account, bool in_top) {
+        leader_table.modify(leader_table.get(account.value), eosio::same_payer, [&](auto& w) {
+            settle_reward(commun_code, w);
+            w.in_top = in_top;
+        });
+    };
+
+    uint64_t added = 0;
+    uint64_t removed = 0;
+    if (was_in_top) {
+        removed += prev_weight;
+        if (eligible) {
+            added += weight;
+        }
+        if (!eligible || weight < prev_weight) {
+            // no outsider is heavier than the leader was, the heaviest one replaces it if the leader became lighter
+            name heaviest;
+            uint64_t heaviest_weight = 0;
+            for (auto itr = idx.lower_bound(prev_weight); itr != idx.end() && itr->total_weight > (eligible ? weight : 0); ++itr) {
+                if (is_outsider(*itr)) {
+                    heaviest = itr->name;
+                    heaviest_weight = itr->total_weight;
+                    break;
+                }
+            }
+            if (heaviest != name()) {
+                set_in_top(heaviest, true);
+                set_in_top(leader, false);
+                added += heaviest_weight;
+                if (eligible) {
+                    added -= weight;
+                }
+            }
+            else if (!eligible) {
+                set_in_top(leader, false);
+                --top_num;
+            }
+        }
+    }
+    else if (eligible) {
+        if (top_num < l) {  // all the active leaders are in the top
+            set_in_top(leader, true);
+            added += weight;
+            ++top_num;
+        }
+        else {
+            // the lightest leader of the top is not lighter than the outsiders, so the search stops after the first of them
+            name lightest;
+            uint64_t lightest_weight = 0;
+            std::optional<uint64_t> outsider_weight;
+            for (auto itr = idx.lower_bound(weight); itr != idx.end() && itr->total_weight > 0; ++itr) {
+                if (outsider_weight && itr->total_weight < *outsider_weight) {
+                    break;
+                }
+                if (itr->in_top.value_or()) {
+                    if (itr->total_weight < weight) {
+                        lightest = itr->name;
+                        lightest_weight = itr->total_weight;
+                    }
+                }
+                else if (!outsider_weight && is_outsider(*itr)) {
+                    outsider_weight = itr->total_weight;
+                }
+            }
+            if (lightest != name()) {
+                set_in_top(lightest, false);
+                set_in_top(leader, true);
+                removed += lightest_weight;
+                added += weight;
+            }
+        }
+    }
+
+    stats updated_stats(_self, commun_code.raw());    // settle_reward could modify the row
+    const auto& updated = updated_stats.get(commun_code.raw());
+    auto top_weight = updated.top_weight.value_or() + added - removed;
+    if (updated.top_weight.value_or() == top_weight && updated.top_num.value_or() == top_num) {
+        return;
+    }
+    updated_stats.modify(updated, eosio::same_payer, [&](auto& s) {
+        s.init_reward();
+        s.top_weight = top_weight;
+        s.top_num = top_num;
+    });
 }
 
 vector<leader_info> control::top_leader_info(symbol_code commun_code) {
@@ -366,6 +615,8 @@ void control::propose(ignore<symbol_code> commun_code,
         prop.commun_code         = _commun_code;
         prop.permission          = _permission;
         prop.packed_transaction  = pkd_trans;
+        prop.expiration          = _trx_header.expiration;
+        prop.trx_hash            = eosio::sha256(trx_pos, size);
     });
 
     approvals apptable(_self, _proposer.value);
@@ -382,7 +633,7 @@ void control::approve(name proposer, name proposal_name, name approver, const eo
     eosio::check(in_the_top(prop.commun_code, approver), approver.to_string() + " is not a leader");
 
     if(proposal_hash) {
-        assert_sha256(prop.packed_transaction.data(), prop.packed_transaction.size(), *proposal_hash);
+        eosio::check(*proposal_hash == prop.get_trx_hash(), "hash mismatch");
     }
 
     approvals apptable(_self, proposer.value);
@@ -412,7 +663,7 @@ void control::cancel(name proposer, name proposal_name, name canceler) {
     auto& prop = proptable.get( proposal_name.value, "proposal not found" );
 
     if(canceler != proposer) {
-        eosio::check(unpack<transaction_header>( prop.packed_transaction ).expiration < current_time_point(), "cannot cancel until expiration");
+        eosio::check(prop.get_expiration() < current_time_point(), "cannot cancel until expiration");
     }
     proptable.erase(prop);
 
@@ -427,10 +678,7 @@ void control::exec(name proposer, name proposal_name, name executer) {
 
     proposals proptable(_self, proposer.value);
     auto& prop = proptable.get(proposal_name.value, "proposal not found");
-    transaction trx;
-    datastream<const char*> ds(prop.packed_transaction.data(), prop.packed_transaction.size());
-    ds >> trx;
-    eosio::check(trx.expiration >= current_time_point(), "transaction expired");
+    eosio::check(prop.get_expiration() >= current_time_point(), "transaction expired");
     
     auto governance = prop.commun_code ? point::get_issuer(prop.commun_code) : config::dapp_name;
     
@@ -465,10 +713,22 @@ void control::exec(name proposer, name proposal_name, name executer) {
     eosio::check(approvals_num >= required, "transaction authorization failed");
     apptable.erase(apps);
     
-    for (const auto& a : trx.context_free_actions) {
+    // actions are read one by one from the stored bytes, the whole transaction is never unpacked
+    datastream<const char*> ds(prop.packed_transaction.data(), prop.packed_transaction.size());
+    transaction_header trx_header;
+    ds >> trx_header;
+
+    unsigned_int actions_num;
+    ds >> actions_num;
+    for (uint32_t i = 0; i < actions_num.value; ++i) {
+        action a;
+        ds >> a;
         a.send_context_free();
     }
-    for (const auto& a : trx.actions) {
+    ds >> actions_num;
+    for (uint32_t i = 0; i < actions_num.value; ++i) {
+        action a;
+        ds >> a;
         a.send();
     }
 
@@ -77,7 +77,7 @@ public:
      *
      * Funds issued due to emission are divided between the top mosaics. Mosaics for reward are selected from among the candidates included in the top list. The number of candidates in this list is determined by the \a default_comm_grades parameter. It is set by leaders and defaults to 20. The number of most rated mosaics submitted for reward is also set by leaders and defaults to 10.
 
-     * Distribution of rewards between mosaics is carried out by \a c.gallery and \a c.ctrl contracts. The \a c.emit contract only issues requested amount of points and transfers them to those contracts.
+     * Distribution of rewards between mosaics is carried out by \a c.gallery and \a c.ctrl contracts. The \a c.emit contract only issues requested amount of points directly to those contracts (see \ref point::mintto).
      
      * Presence and location of a mosaic in the top list is determined by the \a comm_rating parameter. This parameter means total amount of rating points (hereinafter — ratings) obtained by a mosaic during collection of user opinions taking into account the sign of vote (positive or negative). The more ratings, the higher position of a mosaic in the list.
      
@@ -103,7 +103,7 @@ public:
     [[eosio::action]] void init(symbol_code commun_code);
 
     /**
-     * \brief The \ref issuereward action is called by other contracts to issue next batch of points to be used by these contracts for rewarding. This action checks if it is time to reward. If so, this action transfers points to contract that called it.
+     * \brief The \ref issuereward action is called by other contracts to issue next batch of points to be used by these contracts for rewarding. This action checks if it is time to reward. If so, this action issues points directly to contract that called it.
      
      * \param commun_code point symbol to be issued
      * \param to_contract name of contract that is a recipient and for which points are issued.
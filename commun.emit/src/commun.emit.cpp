@@ -26,9 +26,7 @@ void emit::init(symbol_code commun_code) {
 }
 
 int64_t emit::get_continuous_rate(int64_t annual_rate) {
-    static auto constexpr real_100percent = static_cast<double>(config::_100percent);
-    auto real_rate = static_cast<double>(annual_rate);
-    return static_cast<int64_t>(std::log(1.0 + (real_rate / real_100percent)) * real_100percent); 
+    return math::continuous_rate(annual_rate);
 }
 
 void emit::issuereward(symbol_code commun_code, name to_contract) {
@@ -46,28 +44,15 @@ void emit::issuereward(symbol_code commun_code, name to_contract) {
     eosio::check(is_account(to_contract), to_contract.to_string() + " contract does not exists");
 
     auto supply = point::get_supply(commun_code);
-    auto cont_emission = safe_pct(supply.amount, get_continuous_rate(community.emission_rate));
-
-    static constexpr int64_t seconds_per_year = int64_t(365)*24*60*60;
-    auto period_emission = safe_prop(cont_emission, passed_seconds, seconds_per_year);
-    auto amount = safe_pct(period_emission, community.get_emission_receiver(to_contract).percent);
+    auto amount = math::emission_amount(supply.amount, community.emission_rate, passed_seconds,
+        community.get_emission_receiver(to_contract).percent);
 
     if (amount) {
-        auto issuer = point::get_issuer(commun_code);
-        asset quantity(amount, supply.symbol);
-
         action(
             permission_level{config::point_name, config::issue_permission},
             config::point_name,
-            "issue"_n,
-            std::make_tuple(issuer, quantity, string())
-        ).send();
-
-        action(
-            permission_level{issuer, config::transfer_permission},
-            config::point_name,
-            "transfer"_n,
-            std::make_tuple(issuer, to_contract, quantity, string())
+            "mintto"_n,
+            std::make_tuple(to_contract, asset(amount, supply.symbol))
         ).send();
     }
 
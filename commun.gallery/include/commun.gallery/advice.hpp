@@ -0,0 +1,46 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <utility>
+#include <vector>
+
+// lead ratings of the advised mosaics, it doesn't depend on eosio types, so the unit tests use it directly
+namespace commun { namespace advice {
+
+// each favorite of a leader adds the same weight, which depends on the number of the favorites
+template<std::size_t N>
+int64_t favorite_weight(const std::array<int64_t, N>& weights, std::size_t favorites_num) {
+    return favorites_num ? weights.at(favorites_num - 1) : 0;
+}
+
+// changes of lead ratings when the favorites of a leader are replaced, sorted by tracery;
+// a mosaic is only in the result if its rating changes
+template<std::size_t N>
+std::vector<std::pair<uint64_t, int64_t> > rating_deltas(const std::array<int64_t, N>& weights,
+                                                          const std::set<uint64_t>& prev_favorites, const std::set<uint64_t>& favorites) {
+    auto prev_weight = favorite_weight(weights, prev_favorites.size());
+    auto weight = favorite_weight(weights, favorites.size());
+    std::vector<std::pair<uint64_t, int64_t> > deltas;
+    auto prev_itr = prev_favorites.begin();
+    auto itr = favorites.begin();
+    while (prev_itr != prev_favorites.end() || itr != favorites.end()) {
+        if (itr == favorites.end() || (prev_itr != prev_favorites.end() && *prev_itr < *itr)) {
+            deltas.emplace_back(*prev_itr++, -prev_weight);
+        }
+        else if (prev_itr == prev_favorites.end() || *itr < *prev_itr) {
+            deltas.emplace_back(*itr++, weight);
+        }
+        else {
+            if (weight != prev_weight) {
+                deltas.emplace_back(*itr, weight - prev_weight);
+            }
+            ++prev_itr;
+            ++itr;
+        }
+    }
+    return deltas;
+}
+
+} } // commun::advice
@@ -19,283 +19,31 @@
 #include <commun.emit/config.hpp>
 #include <commun.list/commun.list.hpp>
 #include <eosio/event.hpp>
+#include "objects.hpp"
+#include "advice.hpp"
 
 namespace commun {
 
 using std::string;
 using structures::opus_info;
 
-#define GALLERY_LIBRARY contract("commun.gallery"), contract("commun.publication")
-
-namespace gallery_types {
-    using providers_t = std::vector<std::pair<name, int64_t> >;
-
-    /**
-     * \brief The structure represents mosaic data table in DB.
-     * \ingroup gallery_tables
-     *
-     * \details The table contains data that uniquely identifies and represents a mosaic.
-     *
-     * <b>The states which a mosaic may exist in:</b>
-     * - ACTIVE — Active state of the mosaic, collecting user opinions (sympathy). Once a mosaic is created, it is assigned ACTIVE status;
-     * - MODERATE — Collection of user opinions has been completed. The leaders decide whether to pay reward to author of the mosaic and users who voted;
-     * - ARCHIVED — Mosaic is in archiving state; user opinions collection has been completed;
-     * - LOCKED — Collection of user opinions is temporarily blocked by leaders (i.e. due to complaints from users about the post). Leaders can put it back in the ACTIVE state to continue collecting users' opinions. The time spent by the mosaic in LOCKED state is determined using the lock_date parameter. The period of collecting opinions (collection_period parameter) is increased by this value. The author can improve content of unlocked mosaic. In this case, the lock_date parameter will be reset to zero. Leaders can lock the mosaic again if the author’s work still does not suit users;
-     * - BANNED — Post has been locked by leaders. Collected reward to the author of the post and voted users will not be paid;
-     * - HIDDEN — Post has been removed by the author. Mosaic of the post may still exist, since it takes some time to destroy the gems. If the post has collected the sympathy of users, then rewards to these users will be paid;
-     * - BANNED_AND_HIDDEN — Post has been removed and blocked by leaders (no rewards will be paid).
-     */
-    struct mosaic_struct {
-
-        mosaic_struct() = default;
-        uint64_t tracery; //!< The mosaic tracery, used as primary key
-        name creator;     //!< The mosaic creator
-        
-        name opus;        //!< Mosaic description type. The parameter indicates what the mosaic describes, such as a post or comment.
-        uint16_t royalty; //!< Share (in percent) of royalties to the author for creating the mosaic. When creating a mosaic, its first gem belongs to the author. Part of weight of other gems created by other members is added to the gem of mosaic author. So, part of funds invested in gem is allocated to the mosaic author. 
-
-        time_point lock_date = time_point();   //!< Mosaic lock date. The mosaic is blocked by the leaders if any frauds with the mosaic are detected. After blocking, the collection of gems inside this mosaic is suspended.
-        time_point collection_end_date;        //!< Gem collection period
-        uint16_t gem_count;   //!< Current number of gems inside the mosaic
-        
-        int64_t points;   //!< Number of points collected inside this mosaic. Points are added to the mosaic when users vote.
-        int64_t shares;   //!< Mosaic weight (post weight) calculated via «bancor» function. Weight of vote depends on the voting time. The earlier vote carries more weight.
-        int64_t damn_points = 0;   //!< Number of points related to negative votes
-        int64_t damn_shares = 0;   //!< Number of shares related to negative votes
-        int64_t pledge_points = 0; //!< Number of tokens pledged. A number of points is invested in creating a mosaic and thereby limits the number of mosaics created by author. These points are «frozen» and cannot be part of the reward.
-        
-        int64_t reward = 0;   //!< Total reward amount. The reward is formed not at the end of the mosaic collection, but with a certain periodicity. Rewards are allocated to top mosaics which have become the most popular among users. Number of these mosaics is determined by the \a rewarded_mosaic_num parameter in the \a c.list. The \a c.ctrl contract allocates tokens as a share of the annual emission to \a c.gallery contract. The funds received are converted into points and then distributed among worthy mosaics.
-        
-        int64_t comm_rating = 0;
-        int64_t lead_rating = 0;
-        
-        enum status_t: uint8_t { ACTIVE, MODERATE, ARCHIVED, LOCKED, BANNED, HIDDEN, BANNED_AND_HIDDEN };
-        uint8_t status = ACTIVE;   //!< Field indicating a mosaic status. Once a mosaic is created, it is assigned ACTIVE status.
-        time_point last_top_date = time_point();
-        bool deactivated_xor_locked = false;   //!< Flag indicating the post is inactive or blocked. \a true — post blocked by leaders or archived.
-        
-        bool banned()const { return status == BANNED || status == BANNED_AND_HIDDEN; }
-        bool hidden()const { return status == HIDDEN || status == BANNED_AND_HIDDEN; }
-        bool deactivated()const { return deactivated_xor_locked && status != LOCKED; }
-
-        void lock() {
-            check(status == ACTIVE, "mosaic is inactive");
-            check(lock_date == time_point(), "Mosaic should be modified to lock again.");
-            check(!deactivated_xor_locked, "SYSTEM: lock, incorrect deactivated_xor_locked value");
-            status = LOCKED;
-            lock_date = eosio::current_time_point();
-            deactivated_xor_locked = true;
-        }
-
-        void unlock(int64_t moderation_period) {
-            check(status == LOCKED, "mosaic not locked");
-            check(deactivated_xor_locked, "SYSTEM: unlock, incorrect deactivated_xor_locked value");
-            auto now = eosio::current_time_point();
-            eosio::check(now <= collection_end_date + eosio::seconds(moderation_period), "cannot unlock mosaic after moderation period");
-            status = ACTIVE;
-            collection_end_date += now - lock_date;
-            deactivated_xor_locked = false;
-        }
-
-        uint64_t primary_key() const { return tracery; }
-        using by_comm_rating_t = std::tuple<uint8_t, int64_t, int64_t>;
-        by_comm_rating_t by_comm_rating()const { return std::make_tuple(status, comm_rating, lead_rating); }
-        using by_lead_rating_t = std::tuple<int64_t, int64_t>;
-        by_lead_rating_t by_lead_rating()const { return std::make_tuple(lead_rating, comm_rating); }
-        using by_date_t = std::tuple<bool, time_point>;
-        by_date_t by_date()const { return std::make_tuple(deactivated_xor_locked, collection_end_date); }
-        using by_status_t = std::tuple<uint8_t, time_point>;
-        by_status_t by_status() const { return std::make_tuple(status, collection_end_date); }
-    };
-    
-    /**
-     * \brief The structure represents gem data table in DB.
-     * \ingroup gallery_tables
-     *
-     * The table contains data that uniquely identifies and represents a gem in mosaic.
-     */
-    struct gem_struct {
-        uint64_t id; //!< Unique gem identifier
-        uint64_t tracery; //!< Mosaic tracery containing the gem
-        time_point claim_date; //!< Date when the gem can be broken down. The gem cannot be destroyed until this date. Also, points spent on voting for the mosaic cannot be returned back until this date(such implementation excludes voting for another mosaic with the same points).
-        
-        int64_t points; //!< Number of points that were frozen during voting
-        int64_t shares; //!< Number of shares calculated by the «shares» function
-        
-        int64_t pledge_points; //!< Number of points pledged to create the gem (this is implemented to limit a number of gems created in community. The parameter is set in \a c.list contract).
-        
-        name owner; //!< Gem owner
-        name creator;
-        
-        uint64_t primary_key() const { return id; }
-        using key_t = std::tuple<uint64_t, name, name>;
-        key_t by_key()const { return std::make_tuple(tracery, owner, creator); }
-        key_t by_creator()const { return std::make_tuple(tracery, creator, owner); }
-        using by_claim_t = std::tuple<name, time_point>;
-        by_claim_t by_claim()const { return std::make_tuple(owner, claim_date); }
-        time_point by_claim_joint()const { return claim_date; }
-    };
-    
-    /**
-     * \brief The structure represents the table in DB containing total number of all «frozen» points for a user.
-     * \ingroup gallery_tables
-     *
-     * The user account name can be found in the scope field of the table. Each created table has two additional fields — code of the table and scope indicating the owner of points.
-     */
-    struct inclusion_struct {
-        asset quantity; //!< Total number of «frozen» user points
-            // just an idea:
-            // use as inclusion not only points, but also other gems. 
-            // this will allow to buy shares in the mosaics without liquid points, creating more sophisticated collectables
-            // (pntinclusion / geminclusion)
-        
-        uint64_t primary_key()const { return quantity.symbol.code().raw(); }
-    };
-    
-    /**
-     * \brief The structure represents the mosaic statictic data table in DB.
-     * \ingroup gallery_tables
-     *
-     * The table contains statistic information about total number of unclaimed (blocked) points for all users related to a mosaic.
-     */
-    struct stat_struct {
-        uint64_t id; //!< Mosaic identifier
-        int64_t unclaimed = 0; //!< Total number of unclaimed points for all users related to the mosaic
-        int64_t retained = 0; //!< Total amount of retained reward related to unclaimed points
-        time_point last_reward_date = time_point();
-
-        uint64_t primary_key()const { return id; }
-    };
-    
-    struct provision_struct {
-        uint64_t id;
-        name grantor;
-        name recipient;
-        uint16_t fee;
-        int64_t total  = 0;
-        int64_t frozen = 0;
-        int64_t available()const { return total - frozen; };
-        
-        uint64_t primary_key()const { return id; }
-        using key_t = std::tuple<name, name>;
-        key_t by_key()const { return std::make_tuple(grantor, recipient); }
-    };
-    
-    struct advice_struct {
-        name leader;
-        std::set<uint64_t> favorites;
-        uint64_t primary_key()const { return leader.value; }
-    };
-    
-    using mosaic_comm_index [[using eosio: non_unique, order("status","asc"), order("comm_rating","desc"), order("lead_rating","desc")]] =
-        eosio::indexed_by<"bycommrating"_n, eosio::const_mem_fun<gallery_types::mosaic_struct, gallery_types::mosaic_struct::by_comm_rating_t, &gallery_types::mosaic_struct::by_comm_rating> >;
-    using mosaic_lead_index [[using eosio: non_unique, order("lead_rating","desc"), order("comm_rating","desc")]] =
-        eosio::indexed_by<"byleadrating"_n, eosio::const_mem_fun<gallery_types::mosaic_struct, gallery_types::mosaic_struct::by_lead_rating_t, &gallery_types::mosaic_struct::by_lead_rating> >;
-    using mosaic_coll_end_index [[using eosio: non_unique, order("deactivated_xor_locked","desc"), order("collection_end_date","asc")]] =
-        eosio::indexed_by<"bydate"_n, eosio::const_mem_fun<gallery_types::mosaic_struct, gallery_types::mosaic_struct::by_date_t, &gallery_types::mosaic_struct::by_date> >;
-    using mosaic_status_index [[using eosio: non_unique, order("status","desc"), order("collection_end_date","asc")]] =
-        eosio::indexed_by<"bystatus"_n, eosio::const_mem_fun<gallery_types::mosaic_struct, gallery_types::mosaic_struct::by_status_t, &gallery_types::mosaic_struct::by_status> >;
-
-    using mosaics [[using eosio: order("tracery","asc"), scope_type("symbol_code"), GALLERY_LIBRARY]] = eosio::multi_index<"mosaic"_n, gallery_types::mosaic_struct, mosaic_comm_index, mosaic_lead_index, mosaic_coll_end_index, mosaic_status_index>;
-    
-    using gem_key_index [[using eosio: order("tracery","asc"), order("owner","asc"), order("creator","asc")]] =
-        eosio::indexed_by<"bykey"_n, eosio::const_mem_fun<gallery_types::gem_struct, gallery_types::gem_struct::key_t, &gallery_types::gem_struct::by_key> >;
-    using gem_creator_index [[using eosio: order("tracery","asc"), order("creator","asc"), order("owner","asc")]] =
-        eosio::indexed_by<"bycreator"_n, eosio::const_mem_fun<gallery_types::gem_struct, gallery_types::gem_struct::key_t, &gallery_types::gem_struct::by_creator> >;
-    using gem_claim_index [[using eosio: non_unique, order("owner","asc"), order("claim_date","asc")]] =
-        eosio::indexed_by<"byclaim"_n, eosio::const_mem_fun<gallery_types::gem_struct, gallery_types::gem_struct::by_claim_t, &gallery_types::gem_struct::by_claim> >;
-    using gem_claim_joint_index [[using eosio: non_unique, order("claim_date","asc")]] =
-        eosio::indexed_by<"byclaimjoint"_n, eosio::const_mem_fun<gallery_types::gem_struct, time_point, &gallery_types::gem_struct::by_claim_joint> >;
-
-    using gems [[using eosio: order("id","asc"), scope_type("symbol_code"), GALLERY_LIBRARY]] = eosio::multi_index<"gem"_n, gallery_types::gem_struct, gem_key_index, gem_creator_index, gem_claim_index, gem_claim_joint_index>;
-    
-    using inclusions [[using eosio: order("quantity._sym","asc"), GALLERY_LIBRARY]] = eosio::multi_index<"inclusion"_n, gallery_types::inclusion_struct>;
-    
-    using prov_key_index [[using eosio: order("grantor","asc"), order("recipient","asc")]] = eosio::indexed_by<"bykey"_n, eosio::const_mem_fun<gallery_types::provision_struct, gallery_types::provision_struct::key_t, &gallery_types::provision_struct::by_key> >;
-    using provs [[using eosio: order("id","asc"), scope_type("symbol_code"), GALLERY_LIBRARY]] = eosio::multi_index<"provision"_n, gallery_types::provision_struct, prov_key_index>;
-
-    using advices [[using eosio: scope_type("symbol_code"), order("leader","asc"), GALLERY_LIBRARY]] = eosio::multi_index<"advice"_n, gallery_types::advice_struct>;
+/**
+ * \brief Logic of the gallery shared by \a c.gallery and \a c.publication
+ * \ingroup gallery_class
+ *
+ * \details The class isn't a template, so its code is compiled once in a module. The contracts differ only in what
+ * happens to a deactivated mosaic, the hook is passed to the constructor by \ref gallery_base.
+ */
+class gallery_engine {
+public:
+    using deactivate_hook = void (*)(name self, symbol_code commun_code, const gallery_types::mosaic_struct& mosaic);
 
-    using stats [[using eosio: scope_type("symbol_code"), order("id","asc"), GALLERY_LIBRARY]] = eosio::multi_index<"stat"_n, gallery_types::stat_struct>;
-    
-namespace events {
-    
-    /**
-     * \brief The structure represents a mosaic destruction event. The mosaic is destroyed after destruction of the last gem belonging to this mosaic.
-     * \ingroup gallery_events
-     */
-    struct [[using eosio: event("mosaicchop"), GALLERY_LIBRARY]] mosaic_chop_event {
-        symbol_code commun_code; //!< Point symbol
-        uint64_t tracery; //!< Tracery that breaks down
-    };
-    
-    /**
-     * \brief The structure represents a mosaic state change event. Such event is sent when a mosaic state changes.
-     * \ingroup gallery_events
-     */
-    struct [[using eosio: event("mosaicstate"), GALLERY_LIBRARY]] mosaic_state_event {
-        uint64_t tracery; //!< Mosaic tracery
-        name creator; //!< Mosaic creator
-        time_point collection_end_date; //!< End date of collecting user opinions
-        uint16_t gem_count; //!< Number of gems inside the mosaic
-        int64_t shares; //!< Mosaic weight
-        int64_t damn_shares; //!< Weight of gems with negative votes
-        asset reward; //!< Amount of currently collected rewards
-        bool banned; //!< Flag indicating the blocking of reward at the initiative of community leaders
-    };
-    
-    /**
-     * \brief The structure represents a gem state change event. Gem for a mosaic is automatically created when an author creates the mosaic. A state of the gem changes when a user votes.
-     * \ingroup gallery_events
-     */
-    struct [[using eosio: event("gemstate"), GALLERY_LIBRARY]] gem_state_event {
-        uint64_t tracery; //!< Mosaic tracery
-        name owner; //!< Mosaic owner
-        name creator;
-        asset points; //!< Number of «frozen» points in the gem
-        asset pledge_points; //!< Number of pledged points in the gem
-        bool damn; //!< Flag indicating a negative or positive user opinion. \a true is negative one.
-        int64_t shares; //!< Weight of gem calculated by the bancor function
-    };
-    
-    /**
-     * \brief The structure represents a gem destruction event. Mosaic breaks down after rewarding it, when users can take back their points.
-     * \ingroup gallery_events
-     */
-    struct [[using eosio: event("gemchop"), GALLERY_LIBRARY]] gem_chop_event {
-        uint64_t tracery; //!< Mosaic tracery
-        name owner; //!< Mosaic owner
-        name creator;
-        asset reward; //!< Gem owner reward.
-        asset unfrozen; //!< Number of returned points that were «frozen» at the time of collecting user opinions. This is total number of points given as sympathies and those that were pledged.
-    };
-    
-    /**
-     * \brief The structure represents the event about the selected best mosaics to be rewarded. The number of selected mosaics is determined by the \a rewarded_mosaic_num parameter in the \a c.list contract and defaults to 10.
-     * \ingroup gallery_events
-     */
-    struct [[using eosio: event("mosaictop"), GALLERY_LIBRARY]] mosaic_top_event {
-        symbol_code commun_code; //!< Point symbol
-        uint64_t tracery; //!< Mosaic tracery
-        uint16_t place; //!< Place where the mosaic is located
-        int64_t comm_rating;
-        int64_t lead_rating;
-    };
-    
-    /**
-     * \brief The structure represents an event about the current number of «frozen» user points.
-     * \ingroup gallery_events
-     */
-    struct [[using eosio: event("inclstate"), GALLERY_LIBRARY]] inclusion_state_event {
-        name account; //!< User account that changed the current number of «frozen» points. The event occurred due to this account action.
-        asset quantity; //!< Current number of «frozen» points belonging to the account
-    };
-}// events
-}// gallery_types
+protected:
+    explicit gallery_engine(deactivate_hook deactivate): _deactivate(deactivate) {}
 
+private:
+    deactivate_hook _deactivate;
 
-template<typename T>
-class gallery_base {
     void send_mosaic_event(name _self, symbol commun_symbol, const gallery_types::mosaic_struct& mosaic) {
         gallery_types::events::mosaic_state_event data {
             .tracery = mosaic.tracery,
@@ -361,8 +109,18 @@ class gallery_base {
         eosio::event(_self, "inclstate"_n, data).send();
     }
     
+    void send_gems_claim_event(name _self, name owner, uint16_t gem_count, asset reward, asset unfrozen) {
+        gallery_types::events::gems_claim_event data {
+            .owner = owner,
+            .gem_count = gem_count,
+            .reward = reward,
+            .unfrozen = unfrozen
+        };
+        eosio::event(_self, "gemsclaim"_n, data).send();
+    }
+    
 private:
-    bool send_reward(name from, name to, const asset &quantity, uint64_t tracery) {
+    bool send_reward(name from, name to, const asset &quantity, const std::string& memo) {
         if (to && !point::balance_exists(to, quantity.symbol.code())) {
             return false;
         }
@@ -372,12 +130,48 @@ private:
                 permission_level{from, config::transfer_permission},
                 config::point_name,
                 "transfer"_n,
-                std::make_tuple(from, to, quantity, "reward for " + std::to_string(tracery))
+                std::make_tuple(from, to, quantity, memo)
             ).send();
         }
         return true; 
     };
     
+    struct pending_reward_t {
+        int64_t amount = 0;
+        uint64_t tracery = 0;
+        uint16_t gem_count = 0;
+    };
+    using rewards_t = std::map<name, pending_reward_t>;
+    
+    static void add_reward(rewards_t& rewards, name to, int64_t amount, uint64_t tracery) {
+        auto& r = rewards[to];
+        r.amount += amount;
+        r.tracery = tracery;
+        r.gem_count++;
+    }
+    
+    // one transfer per recipient, rewards of accounts without balance go to the issuer
+    void send_rewards(name _self, symbol commun_symbol, const rewards_t& rewards) {
+        auto commun_code = commun_symbol.code();
+        int64_t issuer_amount = 0;
+        for (const auto& r : rewards) {
+            if (!r.second.amount) {
+                continue;
+            }
+            auto memo = r.second.gem_count == 1 ?
+                "reward for " + std::to_string(r.second.tracery) :
+                "reward for " + std::to_string(r.second.gem_count) + " gems";
+            if (!send_reward(_self, r.first, asset(r.second.amount, commun_symbol), memo)) {
+                issuer_amount += r.second.amount;
+            }
+        }
+        if (issuer_amount) {
+            //shouldn't we use a more specific memo in send_reward here?
+            eosio::check(send_reward(_self, point::get_issuer(commun_code), asset(issuer_amount, commun_symbol), "reward"), 
+                "the issuer's balance doesn't exist");
+        }
+    }
+    
     void freeze(name _self, name account, const asset &quantity, name ram_payer = name()) {
         
         if (!quantity.amount) {
@@ -416,90 +210,223 @@ private:
         return point::get_reserve_quantity(quantity, nullptr).amount;
     }
     
-    template<typename GemIndex, typename GemItr>
-    bool chop_gem(name _self, symbol commun_symbol, GemIndex& gem_idx, GemItr& gem_itr, bool by_user, bool has_reward, bool no_rewards = false) {
-        const auto& gem = *gem_itr;
-        auto commun_code = commun_symbol.code();
-        auto& community = commun_list::get_community(commun_code);
+    struct chopped_mosaic_t {
+        gallery_types::mosaic_struct mosaic;
+        time_point claim_date;  // gems of the mosaic can be chopped by anyone since this date
+        uint16_t gem_count = 0; // gems chopped from the mosaic, it isn't written if zero
+    };
 
-        gallery_types::mosaics mosaics_table(_self, commun_code.raw());
-        auto mosaic = mosaics_table.find(gem.tracery);
-        eosio::check(mosaic != mosaics_table.end(), "mosaic doesn't exist");
-        auto claim_date = mosaic->collection_end_date + eosio::seconds(community.moderation_period + community.extra_reward_period);
-        bool ready_to_claim = claim_date <= eosio::current_time_point() && gem.claim_date != config::eternity;
+    struct prov_change_t {
+        int64_t total = 0;
+        int64_t frozen = 0;
+    };
+
+    // gems chopped in one action: the community and the mosaics are read once, the changes of the mosaics,
+    // frozen points and provider pools are accumulated and written by apply_chops, one write per row
+    struct chop_batch_t {
+        symbol commun_symbol;
+        const structures::community& community;
+        rewards_t& rewards; //!< the rewards should be sent by the caller with send_rewards
+        std::map<uint64_t, chopped_mosaic_t> mosaics;
+        std::map<name, int64_t> unfrozen;
+        std::map<name, std::map<name, prov_change_t> > provs; //!< grantor -> recipient -> change of the slice
+        uint16_t gem_count = 0;
+
+        chop_batch_t(symbol commun_symbol_, rewards_t& rewards_)
+        :   commun_symbol(commun_symbol_)
+        ,   community(commun_list::get_community(commun_symbol_.code()))
+        ,   rewards(rewards_) {}
+    };
+
+    chopped_mosaic_t& get_chopped_mosaic(name _self, chop_batch_t& batch, uint64_t tracery) {
+        auto itr = batch.mosaics.find(tracery);
+        if (itr == batch.mosaics.end()) {
+            gallery_types::mosaics mosaics_table(_self, batch.commun_symbol.code().raw());
+            auto mosaic = mosaics_table.find(tracery);
+            eosio::check(mosaic != mosaics_table.end(), "mosaic doesn't exist");
+            const auto& community = batch.community;
+            auto claim_date = mosaic->collection_end_date + eosio::seconds(community.moderation_period + community.extra_reward_period);
+            itr = batch.mosaics.emplace(tracery, chopped_mosaic_t{*mosaic, claim_date}).first;
+        }
+        return itr->second;
+    }
+
+    static inline uint64_t gem_bucket_hour(time_point claim_date) {
+        return claim_date.sec_since_epoch() / config::gem_bucket_period;
+    }
+    
+    // the payer takes the whole bucket row over, so nobody pays for the row without signing the action
+    void schedule_gem(name _self, symbol_code commun_code, uint64_t gem_id, time_point claim_date, name payer) {
+        if (claim_date == config::eternity) {
+            return;
+        }
+        auto hour = gem_bucket_hour(claim_date);
+        uint64_t bucket_id = hour << 8;
+        gallery_types::gem_buckets buckets_table(_self, commun_code.raw());
+        auto bucket = buckets_table.lower_bound((hour + 1) << 8);
+        if (bucket != buckets_table.begin()) {
+            --bucket;
+            if (bucket->hour() == hour) {
+                if (bucket->gems.size() < config::max_bucket_gems || (bucket->id & 0xff) == 0xff) {
+                    buckets_table.modify(bucket, payer, [&](auto& item) { item.gems.push_back(gem_id); });
+                    return;
+                }
+                bucket_id = bucket->id + 1;
+            }
+        }
+        buckets_table.emplace(payer, [&](auto& item) { item = gallery_types::gem_bucket_struct {
+            .id = bucket_id,
+            .gems = {gem_id}
+        };});
+    }
+    
+    // the changes are applied by apply_chops, which should be called by the caller before other changes of the mosaics;
+    // the row of the gem is erased by the caller, a gem not ready to be chopped isn't changed and should be postponed
+    bool chop_gem(name _self, chop_batch_t& batch, const gallery_types::gem_struct& gem,
+                  bool by_user, bool has_reward, bool no_rewards = false) {
+        const auto& community = batch.community;
+        auto& chopped = get_chopped_mosaic(_self, batch, gem.tracery);
+        auto& mosaic = chopped.mosaic;
+
+        bool ready_to_claim = chopped.claim_date <= eosio::current_time_point() && gem.claim_date != config::eternity;
         if (by_user) {
             eosio::check(ready_to_claim || has_auth(gem.owner) 
                 || (has_auth(gem.creator) && !has_reward && gem.claim_date != config::eternity), "lack of necessary authority");
         } else if (!ready_to_claim) {
-            gem_idx.modify(gem_itr, eosio::same_payer, [&](auto& item) {
-                item.claim_date = claim_date;
-            });
             return false;
         }
 
-        int64_t reward = 0;
         bool damn = gem.shares < 0;
-        if (!no_rewards && damn == mosaic->banned()) {
-            reward = damn ? 
-                (community.damned_gem_reward_enabled ? safe_prop(mosaic->reward, -gem.shares, mosaic->damn_shares) : 0) :
-                safe_prop(mosaic->reward,  gem.shares, mosaic->shares);
-        }
-        asset frozen_points(gem.points + gem.pledge_points, commun_symbol);
-        asset reward_points(reward, commun_symbol);
-        
-        freeze(_self, gem.owner, -frozen_points);
-        send_chop_event(_self, gem, reward_points, frozen_points);
+        int64_t reward = no_rewards ? 0 : math::gem_reward(mosaic.reward, mosaic.shares, mosaic.damn_shares, gem.shares,
+                                                            mosaic.banned(), community.damned_gem_reward_enabled);
+        asset frozen_points(gem.points + gem.pledge_points, batch.commun_symbol);
+        send_chop_event(_self, gem, asset(reward, batch.commun_symbol), frozen_points);
 
+        batch.unfrozen[gem.owner] += frozen_points.amount;
         if (gem.creator != gem.owner) {
-            
-            gallery_types::provs provs_table(_self, commun_code.raw());
-            auto provs_index = provs_table.get_index<"bykey"_n>();
-            auto prov_itr = provs_index.find(std::make_tuple(gem.owner, gem.creator));
-            if (prov_itr != provs_index.end()) {
-                provs_index.modify(prov_itr, name(), [&](auto& item) {
-                    item.total  += reward_points.amount;
-                    item.frozen -= frozen_points.amount;
-                });
+            auto& prov = batch.provs[gem.owner][gem.creator];
+            prov.total  += reward;
+            prov.frozen -= frozen_points.amount;
+        }
+        if (reward) {
+            add_reward(batch.rewards, gem.owner, reward, gem.tracery);
+        }
+
+        if (!damn) {
+            mosaic.points -= gem.points;
+            mosaic.shares -= gem.shares;
+            mosaic.comm_rating -= gem.points;
+        }
+        else {
+            mosaic.damn_points -= gem.points;
+            mosaic.damn_shares += gem.shares;
+            mosaic.comm_rating += gem.points;
+        }
+        mosaic.pledge_points -= gem.pledge_points;
+        mosaic.reward -= reward;
+        mosaic.gem_count--;
+        chopped.gem_count++;
+        batch.gem_count++;
+        return true;
+    }
+
+    // the only code depending on the index type is kept small, the gem was passed to chop_gem in the same batch
+    template<typename GemIndex, typename GemItr>
+    void postpone_gem(name _self, chop_batch_t& batch, GemIndex& gem_idx, const GemItr& gem_itr) {
+        auto claim_date = batch.mosaics.at(gem_itr->tracery).claim_date;
+        gem_idx.modify(gem_itr, eosio::same_payer, [&](auto& item) {
+            item.claim_date = claim_date;
+        });
+        auto payer = eosio::has_auth(gem_itr->owner) ? gem_itr->owner : eosio::has_auth(gem_itr->creator) ? gem_itr->creator : _self;
+        schedule_gem(_self, batch.commun_symbol.code(), gem_itr->id, claim_date, payer);
+    }
+
+    static inline uint64_t stat_shard(uint64_t tracery) {
+        return tracery % config::stat_shards_num;
+    }
+
+    void add_unclaimed(name _self, symbol_code commun_code, const std::map<uint64_t, int64_t>& unclaimed) {
+        gallery_types::stat_shards shards_table(_self, commun_code.raw());
+        for (const auto& u : unclaimed) {
+            if (!u.second) {
+                continue;
+            }
+            auto shard = shards_table.find(u.first);
+            if (shard != shards_table.end()) {
+                shards_table.modify(shard, name(), [&](auto& s) { s.unclaimed += u.second; });
+            }
+            else {
+                shards_table.emplace(_self, [&](auto& s) { s = {.id = u.first, .unclaimed = u.second}; });
             }
         }
-        if (!send_reward(_self, gem.owner, reward_points, gem.tracery)) {
-            //shouldn't we use a more specific memo in send_reward here?
-            eosio::check(send_reward(_self, point::get_issuer(commun_code), reward_points, gem.tracery), "the issuer's balance doesn't exist");
+    }
+
+    // the shards are kept with zero values to not pay for the rows again
+    int64_t fold_unclaimed(name _self, symbol_code commun_code) {
+        gallery_types::stat_shards shards_table(_self, commun_code.raw());
+        int64_t ret = 0;
+        for (auto shard = shards_table.begin(); shard != shards_table.end(); ++shard) {
+            if (shard->unclaimed) {
+                ret += shard->unclaimed;
+                shards_table.modify(shard, name(), [&](auto& s) { s.unclaimed = 0; });
+            }
         }
-        
-        if (mosaic->gem_count > 1 || mosaic->lead_rating) {
-            mosaics_table.modify(mosaic, name(), [&](auto& item) {
-                if (!damn) {
-                    item.points -= gem.points;
-                    item.shares -= gem.shares;
-                    item.comm_rating -= gem.points;
-                }
-                else {
-                    item.damn_points -= gem.points;
-                    item.damn_shares += gem.shares;
-                    item.comm_rating += gem.points;
+        return ret;
+    }
+
+    // a mosaic without gems is removed unless it is active and has lead_rating, its reward left goes to the unclaimed;
+    // the unclaimed points are written to the shard of the mosaic, not to the stat read by all claims
+    void apply_chops(name _self, chop_batch_t& batch) {
+        auto commun_code = batch.commun_symbol.code();
+        gallery_types::mosaics mosaics_table(_self, commun_code.raw());
+        std::map<uint64_t, int64_t> unclaimed; // by shard
+        for (const auto& m : batch.mosaics) {
+            if (!m.second.gem_count) {
+                continue;
+            }
+            const auto& mosaic = m.second.mosaic;
+            auto mosaic_itr = mosaics_table.find(m.first);
+            if (mosaic.gem_count || (mosaic.lead_rating && !mosaic.deactivated())) {
+                mosaics_table.modify(mosaic_itr, name(), [&](auto& item) { item = mosaic; });
+                send_mosaic_event(_self, batch.commun_symbol, mosaic);
+            }
+            else {
+                unclaimed[stat_shard(mosaic.tracery)] += mosaic.reward;
+                if (!mosaic.deactivated()) {
+                    _deactivate(_self, commun_code, mosaic);
                 }
-                item.pledge_points -= gem.pledge_points;
-                item.reward -= reward;
-                item.gem_count--;
-            });
-            send_mosaic_event(_self, commun_symbol, *mosaic);
+                send_mosaic_chop_event(_self, commun_code, mosaic.tracery);
+                mosaics_table.erase(mosaic_itr);
+            }
         }
-        else {
-            gallery_types::stats stats_table(_self, commun_code.raw());
-            const auto& stat = stats_table.get(commun_code.raw(), "SYSTEM: no stat but community present");
-            stats_table.modify(stat, name(), [&]( auto& s) { s.unclaimed += mosaic->reward - reward; });
-            if (!mosaic->deactivated()) {
-                T::deactivate(_self, commun_code, *mosaic);
+        if (!unclaimed.empty()) {
+            add_unclaimed(_self, commun_code, unclaimed);
+        }
+
+        if (!batch.provs.empty()) {
+            gallery_types::provider_pools pools_table(_self, commun_code.raw());
+            for (const auto& p : batch.provs) {
+                auto pool_itr = pools_table.find(p.first.value);
+                if (pool_itr != pools_table.end()) {
+                    pools_table.modify(pool_itr, name(), [&](auto& item) {
+                        for (const auto& r : p.second) {
+                            pool::change_slice(item, r.first, r.second.total, r.second.frozen);
+                        }
+                    });
+                }
             }
-            send_mosaic_chop_event(_self, commun_code, mosaic->tracery);
-            mosaics_table.erase(mosaic);
         }
-        return true;
+
+        for (const auto& u : batch.unfrozen) {
+            freeze(_self, u.first, -asset(u.second, batch.commun_symbol));
+        }
+        batch.mosaics.clear();
+        batch.unfrozen.clear();
+        batch.provs.clear();
     }
     
     void freeze_points_in_gem(name _self, bool creating, symbol commun_symbol, uint64_t tracery, time_point claim_date, 
-                              int64_t points, int64_t shares, int64_t pledge_points, name owner, name creator) {
+                              int64_t points, int64_t shares, int64_t pledge_points, name owner, name creator, rewards_t& rewards) {
         check(points >= 0, "SYSTEM: points can't be negative");
         check(pledge_points >= 0, "SYSTEM: pledge_points can't be negative");
         if (!shares && !points && !pledge_points && !creating) {
@@ -532,14 +459,18 @@ private:
         if (!refilled) {
             
             uint8_t gem_num = 0;
+            chop_batch_t batch(commun_symbol, rewards);
             auto max_claim_date = eosio::current_time_point();
             auto claim_idx = gems_table.get_index<"byclaim"_n>();
             auto chop_gem_of = [&](name account) {
                 auto gem_itr = claim_idx.lower_bound(std::make_tuple(account, time_point()));
                 if ((gem_itr != claim_idx.end()) && (gem_itr->owner == account) && (gem_itr->claim_date < max_claim_date)) {
-                    if (chop_gem(_self, commun_symbol, claim_idx, gem_itr, false, true)) {
+                    if (chop_gem(_self, batch, *gem_itr, false, true)) {
                         claim_idx.erase(gem_itr);
                     }
+                    else {
+                        postpone_gem(_self, batch, claim_idx, gem_itr);
+                    }
                     ++gem_num;
                 }
             };
@@ -548,22 +479,38 @@ private:
                 chop_gem_of(creator);
             }
             max_claim_date -= eosio::seconds(config::forced_chopping_delay);
-            auto joint_idx = gems_table.get_index<"byclaimjoint"_n>();
-            auto gem_itr = joint_idx.begin();
+            gallery_types::gem_buckets buckets_table(_self, commun_code.raw());
+            auto max_hour = gem_bucket_hour(max_claim_date);  // only the buckets of the earlier hours are drained
+            auto bucket = buckets_table.begin();
             
-            while ((gem_itr != joint_idx.end()) && (gem_itr->claim_date < max_claim_date) && (gem_num < config::auto_claim_num)) {
-                if (chop_gem(_self, commun_symbol, joint_idx, gem_itr, false, true, true)) {
-                    gem_itr = joint_idx.erase(gem_itr);
+            while ((bucket != buckets_table.end()) && (bucket->hour() < max_hour) && (gem_num < config::auto_claim_num)) {
+                auto gem_ids = bucket->gems;
+                while (!gem_ids.empty() && (gem_num < config::auto_claim_num)) {
+                    auto gem_itr = gems_table.find(gem_ids.back());
+                    gem_ids.pop_back();
+                    if ((gem_itr != gems_table.end()) && (gem_bucket_hour(gem_itr->claim_date) == bucket->hour())) {
+                        if (chop_gem(_self, batch, *gem_itr, false, true, true)) {
+                            gems_table.erase(gem_itr);
+                        }
+                        else {
+                            postpone_gem(_self, batch, gems_table, gem_itr);
+                        }
+                    }
+                    ++gem_num;
+                }
+                if (gem_ids.empty()) {
+                    bucket = buckets_table.erase(bucket);
                 }
                 else {
-                    ++gem_itr;
+                    buckets_table.modify(bucket, name(), [&](auto& item) { item.gems = gem_ids; });
                 }
-                ++gem_num;
             }
+            apply_chops(_self, batch);
             
+            auto gem_id = gems_table.available_primary_key();
             gems_table.emplace(creator, [&]( auto &item ) {
                 item = gallery_types::gem_struct {
-                    .id = gems_table.available_primary_key(),
+                    .id = gem_id,
                     .tracery = tracery,
                     .claim_date = claim_date,
                     .points = points,
@@ -574,6 +521,7 @@ private:
                 };
                 send_gem_event(_self, commun_symbol, item);
             });
+            schedule_gem(_self, commun_code, gem_id, claim_date, creator);
         }
         freeze(_self, owner, asset(points + pledge_points, commun_symbol), creator);
         
@@ -662,28 +610,40 @@ private:
         auto commun_symbol = quantity.symbol;
         auto commun_code = commun_symbol.code();          
         
-        gallery_types::provs provs_table(_self, commun_code.raw());
-        auto provs_index = provs_table.get_index<"bykey"_n>();
+        gallery_types::provider_pools pools_table(_self, commun_code.raw());
         
         auto left_pledge = pledge_points;
         auto left_points = points_sum;
+        rewards_t rewards;
         
         for (const auto& p : providers) {
-            auto prov_itr = provs_index.find(std::make_tuple(p.first, creator));
-            eosio::check(prov_itr != provs_index.end(), "no points provided");
+            uint16_t fee = 0;
+            {
+                auto pool_itr = pools_table.find(p.first.value);
+                auto slice = pool_itr != pools_table.end() ? pool_itr->get_slice(creator) : nullptr;
+                eosio::check(slice, "no points provided");
+                fee = slice->fee;
+            }
             
             int64_t cur_pledge = safe_prop(left_pledge, p.second, left_points);
             int64_t cur_points = p.second - cur_pledge;
             int64_t cur_shares_abs = safe_prop(shares_abs, p.second, points_sum);
-            int64_t cur_shares_fee = safe_pct(prov_itr->fee, cur_shares_abs);
+            int64_t cur_shares_fee = safe_pct(fee, cur_shares_abs);
             cur_shares_abs   -= cur_shares_fee;
             total_shares_fee += cur_shares_fee;
 
             freeze_points_in_gem(_self, creating, commun_symbol, tracery, claim_date, 
-                cur_points, damn ? -cur_shares_abs : cur_shares_abs, cur_pledge, p.first, creator);
+                cur_points, damn ? -cur_shares_abs : cur_shares_abs, cur_pledge, p.first, creator, rewards);
             
-            eosio::check(prov_itr->available() >= p.second, "not enough provided points");
-            provs_index.modify(prov_itr, name(), [&](auto& item) { item.frozen += p.second; });
+            // freeze_points_in_gem can chop gems of the grantor and change its pool through apply_chops,
+            // so the pool is read again from a new table object
+            gallery_types::provider_pools updated_pools(_self, commun_code.raw());
+            auto pool_itr = updated_pools.find(p.first.value);
+            auto slice = pool_itr != updated_pools.end() ? pool_itr->get_slice(creator) : nullptr;
+            eosio::check(slice && slice->available() >= p.second, "not enough provided points");
+            updated_pools.modify(pool_itr, name(), [&](auto& item) {
+                pool::change_slice(item, creator, 0, p.second);
+            });
             
             left_pledge -= cur_pledge;
             left_points -= p.second;
@@ -696,14 +656,15 @@ private:
             cur_shares_abs += total_shares_fee;
             
             freeze_points_in_gem(_self, creating, commun_symbol, tracery, claim_date, 
-                cur_points, damn ? -cur_shares_abs : cur_shares_abs, cur_pledge, creator, creator);
+                cur_points, damn ? -cur_shares_abs : cur_shares_abs, cur_pledge, creator, creator, rewards);
         }
+        send_rewards(_self, commun_symbol, rewards);
         
         gallery_types::mosaics mosaics_table(_self, commun_code.raw());
         auto mosaic = mosaics_table.find(tracery);
         send_mosaic_event(_self, commun_symbol, *mosaic);
 
-        deactivate_old_mosaics(_self, commun_code);
+        deactivate_old_mosaics(_self, commun_code, config::auto_deactivate_num);
     }
     
     struct claim_info_t {
@@ -757,17 +718,27 @@ private:
         });
     }
     
-    void deactivate_old_mosaics(name _self, symbol_code commun_code) {
+    // returns the number of processed mosaics, at most max_steps;
+    // watermarks in the stat allow to skip the indexes while nothing is due
+    size_t deactivate_old_mosaics(name _self, symbol_code commun_code, size_t max_steps) {
         auto& community = commun_list::get_community(commun_code);
+        auto now = eosio::current_time_point();
+        auto max_collection_end_date = now - (eosio::seconds(community.moderation_period) + eosio::seconds(community.extra_reward_period));
+
+        gallery_types::stats stats_table(_self, commun_code.raw());
+        const auto& stat = stats_table.get(commun_code.raw(), "SYSTEM: no stat but community present");
+        if (stat.next_moderate_date.value_or() >= now && stat.next_archive_date.value_or() >= max_collection_end_date) {
+            return 0;
+        }
 
         gallery_types::mosaics mosaics_table(_self, commun_code.raw());
         auto mosaics_by_date_idx = mosaics_table.get_index<"bydate"_n>();
         auto mosaics_by_status_idx = mosaics_table.get_index<"bystatus"_n>();
-        auto now = eosio::current_time_point();
-        auto max_collection_end_date = now - (eosio::seconds(community.moderation_period) + eosio::seconds(community.extra_reward_period));
+        size_t steps = 0;
 
-        auto mosaic_by_status = mosaics_by_status_idx.lower_bound(std::make_tuple(gallery_types::mosaic_struct::ACTIVE, time_point()));
-        for (size_t i = 0; i < config::auto_deactivate_num && mosaic_by_status != mosaics_by_status_idx.end(); i++, ++mosaic_by_status) {
+        auto first_active = [&]() { return mosaics_by_status_idx.lower_bound(std::make_tuple(gallery_types::mosaic_struct::ACTIVE, time_point())); };
+        auto mosaic_by_status = first_active();
+        for (; steps < max_steps && mosaic_by_status != mosaics_by_status_idx.end(); steps++, mosaic_by_status = first_active()) {
             if (mosaic_by_status->collection_end_date >= now || mosaic_by_status->status != gallery_types::mosaic_struct::ACTIVE) {
                 break;
             }
@@ -775,9 +746,14 @@ private:
                 item.status = gallery_types::mosaic_struct::MODERATE;
             });
         }
-
-        auto mosaic_by_date = mosaics_by_date_idx.lower_bound(std::make_tuple(false, time_point()));
-        for (size_t i = 0; i < config::auto_deactivate_num && mosaic_by_date != mosaics_by_date_idx.end(); i++, ++mosaic_by_date) {
+        auto next_moderate_date = (mosaic_by_status != mosaics_by_status_idx.end() && mosaic_by_status->status == gallery_types::mosaic_struct::ACTIVE) ?
+            mosaic_by_status->collection_end_date : config::eternity;
+
+        // an archived mosaic is kept only for its gems, a mosaic left without them for lead_rating is removed at once
+        std::map<uint64_t, int64_t> unclaimed; // by shard
+        auto first_not_deactivated = [&]() { return mosaics_by_date_idx.lower_bound(std::make_tuple(false, time_point())); };
+        auto mosaic_by_date = first_not_deactivated();
+        for (; steps < max_steps && mosaic_by_date != mosaics_by_date_idx.end(); steps++, mosaic_by_date = first_not_deactivated()) {
             if (mosaic_by_date->collection_end_date >= max_collection_end_date) {
                 break;
             }
@@ -788,15 +764,44 @@ private:
                 }
                 item.deactivated_xor_locked = true;
             });
-            T::deactivate(_self, commun_code, *mosaic_by_date);
+            _deactivate(_self, commun_code, *mosaic_by_date);
+            if (!mosaic_by_date->gem_count) {
+                unclaimed[stat_shard(mosaic_by_date->tracery)] += mosaic_by_date->reward;
+                send_mosaic_chop_event(_self, commun_code, mosaic_by_date->tracery);
+                mosaics_by_date_idx.erase(mosaic_by_date);
+            }
+        }
+        if (!unclaimed.empty()) {
+            add_unclaimed(_self, commun_code, unclaimed);
+        }
+        auto next_archive_date = (mosaic_by_date != mosaics_by_date_idx.end() && !mosaic_by_date->deactivated_xor_locked) ?
+            mosaic_by_date->collection_end_date : config::eternity;
+
+        if (stat.next_moderate_date.value_or() != next_moderate_date || stat.next_archive_date.value_or() != next_archive_date) {
+            stats_table.modify(stat, name(), [&](auto& s) {
+                s.next_moderate_date = next_moderate_date;
+                s.next_archive_date = next_archive_date;
+            });
+        }
+        return steps;
+    }
+    
+    // a mosaic becomes active (created or unlocked), its collection end date may be earlier than the watermarks
+    void lower_deactivation_watermarks(name _self, symbol_code commun_code, time_point collection_end_date) {
+        gallery_types::stats stats_table(_self, commun_code.raw());
+        const auto& stat = stats_table.get(commun_code.raw(), "SYSTEM: no stat but community present");
+        // the empty watermarks of an old record are the lowest already
+        if (collection_end_date < stat.next_moderate_date.value_or() || collection_end_date < stat.next_archive_date.value_or()) {
+            stats_table.modify(stat, name(), [&](auto& s) {
+                s.next_moderate_date = std::min(s.next_moderate_date.value(), collection_end_date);
+                s.next_archive_date = std::min(s.next_archive_date.value(), collection_end_date);
+            });
         }
     }
     
 public:
     static inline int64_t get_frozen_amount(name gallery_contract_account, name owner, symbol_code sym_code) {
-        gallery_types::inclusions inclusions_table(gallery_contract_account, owner.value);
-        auto incl = inclusions_table.find(sym_code.raw());
-        return incl != inclusions_table.end() ? incl->quantity.amount : 0;
+        return gallery_types::get_frozen_amount(gallery_contract_account, owner, sym_code);
     }
 protected:
 
@@ -845,8 +850,8 @@ protected:
             points_sum += by_comm_itr->comm_rating;
         }
         for (auto& m: ranked_mosaics) {
-            m.second.weight = config::default_comm_grades[m.second.mosaic_num] +
-                safe_prop(config::default_comm_points_grade_sum, m.second.comm_rating, points_sum);
+            m.second.weight = math::comm_grade_weight(config::default_comm_grades[m.second.mosaic_num],
+                config::default_comm_points_grade_sum, m.second.comm_rating, points_sum);
         }
         auto by_lead_idx = mosaics_table.get_index<"byleadrating"_n>();
         
@@ -896,8 +901,10 @@ protected:
             });
             send_top_event(_self, commun_code, *mosaic, place++);
         }
+        auto unclaimed = fold_unclaimed(_self, commun_code);
         stats_table.modify(stat, name(), [&]( auto& s) {
             s.retained = left_reward;
+            s.unclaimed += unclaimed;
             s.last_reward_date = now;
         });
     }
@@ -908,10 +915,39 @@ protected:
         gallery_types::stats stats_table(_self, commun_code.raw());
         eosio::check(stats_table.find(commun_code.raw()) == stats_table.end(), "already exists");
 
-        stats_table.emplace(_self, [&](auto& s) { s = {
-            .id = commun_code.raw(),
-            .last_reward_date = eosio::current_time_point()
-        };});
+        stats_table.emplace(_self, [&](auto& s) {
+            s = {
+                .id = commun_code.raw(),
+                .last_reward_date = eosio::current_time_point()
+            };
+            s.next_moderate_date = time_point();
+            s.next_archive_date = time_point();
+            s.unscheduled_gem_id = std::numeric_limits<uint64_t>::max();
+        });
+    }
+
+    // adds gems created before the buckets to them, forced chopping doesn't find these gems until then
+    void schedule_old_gems(name _self, symbol_code commun_code, name payer, uint16_t max_gems) {
+        require_auth(payer);
+        eosio::check(max_gems > 0, "max_gems must be positive");
+        gallery_types::stats stats_table(_self, commun_code.raw());
+        const auto& stat = stats_table.get(commun_code.raw(), "SYSTEM: no stat but community present");
+        eosio::check(!stat.all_gems_scheduled(), "all gems are scheduled");
+
+        gallery_types::gems gems_table(_self, commun_code.raw());
+        auto gem_itr = gems_table.lower_bound(stat.unscheduled_gem_id.value_or());
+        for (uint16_t gem_num = 0; (gem_itr != gems_table.end()) && (gem_num < max_gems); ++gem_itr, ++gem_num) {
+            schedule_gem(_self, commun_code, gem_itr->id, gem_itr->claim_date, payer);
+        }
+        auto next_id = gem_itr != gems_table.end() ? gem_itr->id : std::numeric_limits<uint64_t>::max();
+        stats_table.modify(stat, name(), [&](auto& s) {
+            // the extensions before unscheduled_gem_id have to be present to serialize it
+            if (!s.next_moderate_date.has_value() || !s.next_archive_date.has_value()) {
+                s.next_moderate_date = time_point();
+                s.next_archive_date = time_point();
+            }
+            s.unscheduled_gem_id = next_id;
+        });
     }
 
     void emit_for_gallery(name _self, symbol_code commun_code) {
@@ -950,6 +986,7 @@ protected:
             .points = 0,
             .shares = 0
         };});
+        lower_deactivation_watermarks(_self, commun_code, now + eosio::seconds(community.collection_period));
 
         auto claim_date = now + eosio::seconds(community.collection_period + community.moderation_period + community.extra_reward_period);
         int64_t pledge_points = std::min(points_sum, op.mosaic_pledge);
@@ -1009,8 +1046,12 @@ protected:
         auto gems_idx = gems_table.get_index<"bykey"_n>();
         auto gem = gems_idx.find(std::make_tuple(claim_info.tracery, gem_owner, gem_creator));
         eosio::check(gem != gems_idx.end(), "nothing to claim");
-        chop_gem(_self, claim_info.commun_symbol, gems_idx, gem, true, claim_info.has_reward, claim_info.premature);
+        rewards_t rewards;
+        chop_batch_t batch(claim_info.commun_symbol, rewards);
+        chop_gem(_self, batch, *gem, true, claim_info.has_reward, claim_info.premature);
         gems_idx.erase(gem);
+        apply_chops(_self, batch);
+        send_rewards(_self, claim_info.commun_symbol, rewards);
     }
     
     bool claim_gems_by_creator(name _self, uint64_t tracery, symbol_code commun_code, name gem_creator, bool eager, 
@@ -1022,10 +1063,12 @@ protected:
         auto gems_idx = gems_table.get_index<"bycreator"_n>();
         auto gem = gems_idx.lower_bound(std::make_tuple(claim_info.tracery, gem_creator, name()));
         bool gem_found = false;
+        rewards_t rewards;
+        chop_batch_t batch(claim_info.commun_symbol, rewards);
         while ((gem != gems_idx.end()) && (gem->tracery == claim_info.tracery) && (gem->creator == gem_creator)) {
             if (!damn.has_value() || *damn == (gem->shares < 0)) {
                 gem_found = true;
-                chop_gem(_self, claim_info.commun_symbol, gems_idx, gem, true, claim_info.has_reward, claim_info.premature);
+                chop_gem(_self, batch, *gem, true, claim_info.has_reward, claim_info.premature);
                 gem = gems_idx.erase(gem);
             }
             else {
@@ -1033,18 +1076,63 @@ protected:
             }
         }
         eosio::check(gem_found || !strict, "nothing to claim");
+        apply_chops(_self, batch);
+        send_rewards(_self, claim_info.commun_symbol, rewards);
         return gem_found;
     }
     
+    void claim_all(name _self, symbol_code commun_code, name gem_owner, uint16_t max_gems) {
+        eosio::check(max_gems > 0, "max_gems must be positive");
+        auto& community = commun_list::get_community(commun_code);
+        auto commun_symbol = community.commun_symbol;
+        
+        emit::maybe_issue_reward(commun_code, _self);
+        
+        gallery_types::gems gems_table(_self, commun_code.raw());
+        auto claim_idx = gems_table.get_index<"byclaim"_n>();
+        auto now = eosio::current_time_point();
+        
+        rewards_t rewards;
+        chop_batch_t batch(commun_symbol, rewards);
+        uint16_t gem_num = 0;
+        auto gem_itr = claim_idx.lower_bound(std::make_tuple(gem_owner, time_point()));
+        while ((gem_itr != claim_idx.end()) && (gem_itr->owner == gem_owner) && (gem_itr->claim_date <= now) && (gem_num < max_gems)) {
+            if (chop_gem(_self, batch, *gem_itr, false, true)) {
+                gem_itr = claim_idx.erase(gem_itr);
+            }
+            else {
+                // the postponed gem moves past now in the index, so the ready ones start from the beginning again
+                postpone_gem(_self, batch, claim_idx, gem_itr);
+                gem_itr = claim_idx.lower_bound(std::make_tuple(gem_owner, time_point()));
+            }
+            ++gem_num;
+        }
+        eosio::check(batch.gem_count, "nothing to claim");
+        
+        auto gem_count = batch.gem_count;
+        asset frozen_points(batch.unfrozen[gem_owner], commun_symbol);
+        apply_chops(_self, batch);
+        send_rewards(_self, commun_symbol, rewards);
+        send_gems_claim_event(_self, gem_owner, gem_count, asset(rewards[gem_owner].amount, commun_symbol), frozen_points);
+    }
+    
     void maybe_claim_old_gem(name _self, symbol commun_symbol, name gem_owner) {
         auto commun_code = commun_symbol.code();
         gallery_types::gems gems_table(_self, commun_code.raw());
         auto claim_idx = gems_table.get_index<"byclaim"_n>();
         auto gem_itr = claim_idx.lower_bound(std::make_tuple(gem_owner, time_point()));
-        if ((gem_itr != claim_idx.end()) && (gem_itr->owner == gem_owner) && 
-            (gem_itr->claim_date < eosio::current_time_point()) && chop_gem(_self, commun_symbol, claim_idx, gem_itr, false, true)) {
-                
+        if ((gem_itr == claim_idx.end()) || (gem_itr->owner != gem_owner) || (gem_itr->claim_date >= eosio::current_time_point())) {
+            return;
+        }
+        rewards_t rewards;
+        chop_batch_t batch(commun_symbol, rewards);
+        if (chop_gem(_self, batch, *gem_itr, false, true)) {
             claim_idx.erase(gem_itr);
+            apply_chops(_self, batch);
+            send_rewards(_self, commun_symbol, rewards);
+        }
+        else {
+            postpone_gem(_self, batch, claim_idx, gem_itr);
         }
     }
     
@@ -1053,31 +1141,49 @@ protected:
         commun_list::check_community_exists(quantity.symbol);
         
         eosio::check(grantor != recipient, "grantor == recipient");
-        gallery_types::provs provs_table(_self, quantity.symbol.code().raw());
-        auto provs_index = provs_table.get_index<"bykey"_n>();
-        auto prov_itr = provs_index.find(std::make_tuple(grantor, recipient));
-        bool exists = prov_itr != provs_index.end();
+        gallery_types::provider_pools pools_table(_self, quantity.symbol.code().raw());
+        auto pool_itr = pools_table.find(grantor.value);
+        auto slice = pool_itr != pools_table.end() ? pool_itr->get_slice(recipient) : nullptr;
+        bool exists = slice != nullptr;
         bool enable = quantity.amount || fee.has_value();
         
         if (exists && enable) {
-            provs_index.modify(prov_itr, name(), [&](auto& item) {
-                item.total += quantity.amount;
+            pools_table.modify(pool_itr, name(), [&](auto& item) {
+                auto cur = item.get_slice(recipient);
+                cur->total += quantity.amount;
                 if (fee.has_value()) {
-                    item.fee = *fee;
+                    cur->fee = *fee;
                 }
             });
         }
         else if(enable) { // !exists
-            provs_table.emplace(grantor, [&] (auto &item) { item = gallery_types::provision_struct {
-                .id = provs_table.available_primary_key(),
-                .grantor = grantor,
+            gallery_types::allowance_slice new_slice {
                 .recipient = recipient,
                 .fee = fee.value_or(0),
                 .total = quantity.amount
-            };});
+            };
+            if (pool_itr != pools_table.end()) {
+                eosio::check(pool_itr->slices.size() < config::max_pool_slices, "too many recipients in the pool");
+                pools_table.modify(pool_itr, name(), [&](auto& item) {
+                    pool::insert_slice(item.slices, new_slice);
+                });
+            }
+            else {
+                pools_table.emplace(grantor, [&] (auto &item) { item = gallery_types::provider_pool_struct {
+                    .grantor = grantor,
+                    .slices = {new_slice}
+                };});
+            }
         }
         else if (exists) {// !enable
-            provs_index.erase(prov_itr);
+            if (pool_itr->slices.size() == 1) {
+                pools_table.erase(pool_itr);
+            }
+            else {
+                pools_table.modify(pool_itr, name(), [&](auto& item) {
+                    item.frozen -= pool::erase_slice(item.slices, recipient);
+                });
+            }
         }
         else { // !exists && !enable
             eosio::check(false, "no points provided");
@@ -1087,38 +1193,47 @@ protected:
     void advise_mosaics(name _self, symbol_code commun_code, name leader, std::set<uint64_t> favorites) {
         eosio::check(favorites.size() <= config::advice_weight.size(), "a surfeit of advice");
         
-        gallery_types::mosaics mosaics_table(_self, commun_code.raw());
-
         gallery_types::advices advices_table(_self, commun_code.raw());
         auto prev_advice = advices_table.find(leader.value);
-        if (prev_advice != advices_table.end()) {
-            eosio::check(prev_advice->favorites != favorites, "no changes in favorites");
-            auto prev_weight = config::advice_weight.at(prev_advice->favorites.size() - 1);
-            for (auto& m : prev_advice->favorites) {
-                auto mosaic = mosaics_table.find(m);
-                if (mosaic != mosaics_table.end()) {
-                    mosaics_table.modify(mosaic, name(), [&](auto& item) { item.lead_rating -= prev_weight; });
-                }
-            }
-            if (favorites.empty()) {
-                advices_table.erase(prev_advice);
-                return;
+        const bool have_prev = prev_advice != advices_table.end();
+        const std::set<uint64_t> empty_favorites;
+        const auto& prev_favorites = have_prev ? prev_advice->favorites : empty_favorites;
+        eosio::check(prev_favorites != favorites, "no changes in favorites");
+
+        // the weight depends on the number of favorites, so a mosaic is only touched if its weight delta isn't 0
+        gallery_types::mosaics mosaics_table(_self, commun_code.raw());
+        for (const auto& d : advice::rating_deltas(config::advice_weight, prev_favorites, favorites)) {
+            auto mosaic = mosaics_table.find(d.first);
+            if (mosaic == mosaics_table.end()) {
+                // the mosaic of the previous advice can be already archived
+                eosio::check(!favorites.count(d.first), "mosaic doesn't exist");
+                continue;
             }
+            mosaics_table.modify(mosaic, name(), [&](auto& item) { item.lead_rating += d.second; });
+        }
+
+        if (favorites.empty()) {
+            advices_table.erase(prev_advice);
+        }
+        else if (have_prev) {
             advices_table.modify(prev_advice, leader, [&](auto& item) { item.favorites = favorites; });
         }
         else {
-            eosio::check(!favorites.empty(), "no changes in favorites");
             advices_table.emplace(leader, [&] (auto &item) { item = gallery_types::advice_struct {
                 .leader = leader,
                 .favorites = favorites
             };});
         }
-        
-        auto weight = config::advice_weight.at(favorites.size() - 1);
-        for (auto& m : favorites) {
-            auto mosaic = mosaics_table.find(m);
-            eosio::check(mosaic != mosaics_table.end(), "mosaic doesn't exist");
-            mosaics_table.modify(mosaic, name(), [&](auto& item) { item.lead_rating += weight; });
+    }
+
+    void advise_many(name _self, name leader, const std::vector<gallery_types::advice_batch_item>& advices) {
+        eosio::check(!advices.empty(), "no advices");
+        eosio::check(advices.size() <= config::max_advice_batch_size, "too many advices");
+        std::set<symbol_code> communities;
+        for (const auto& a : advices) {
+            eosio::check(communities.insert(a.commun_code).second, "duplicate community");
+            control::require_leader_auth(a.commun_code, leader);
+            advise_mosaics(_self, a.commun_code, leader, a.favorites);
         }
     }
 
@@ -1145,6 +1260,14 @@ protected:
                 send_mosaic_event(_self, community.commun_symbol, m);
             }
         });
+        if (!lock) {
+            lower_deactivation_watermarks(_self, commun_code, mosaic.collection_end_date);
+        }
+    }
+    
+    void deactivate_mosaics(name _self, symbol_code commun_code, uint16_t max_steps) {
+        eosio::check(max_steps > 0, "max_steps must be positive");
+        eosio::check(deactivate_old_mosaics(_self, commun_code, max_steps), "nothing to deactivate");
     }
 
     void ban_mosaic(name _self, symbol_code commun_code, uint64_t tracery) {
@@ -1169,6 +1292,16 @@ protected:
     }
 };
 
+/**
+ * \brief Passes the deactivate hook of a contract to the gallery engine, the hook is a static function of \a T
+ * \ingroup gallery_class
+ */
+template<typename T>
+class gallery_base : public gallery_engine {
+protected:
+    gallery_base(): gallery_engine(&T::deactivate) {}
+};
+
 class
 /// @cond
 [[eosio::contract("commun.gallery")]]
@@ -1213,17 +1346,24 @@ public:
         claim_gem(_self, tracery, commun_code, gem_owner, gem_creator.value_or(gem_owner), eager.value_or(false));
     }
     
-    // [[eosio::action]] // TODO: removed from MVP
-    void provide(name grantor, name recipient, asset quantity, std::optional<uint16_t> fee) {
+    [[eosio::action]] void claimall(symbol_code commun_code, name gem_owner, uint16_t max_gems) {
+        claim_all(_self, commun_code, gem_owner, max_gems);
+    }
+    
+    [[eosio::action]] void provide(name grantor, name recipient, asset quantity, std::optional<uint16_t> fee) {
         provide_points(_self, grantor, recipient, quantity, fee);
     }
 
-    // [[eosio::action]] // TODO: removed from MVP
-    void advise(symbol_code commun_code, name leader, std::set<uint64_t> favorites) {
+    [[eosio::action]] void advise(symbol_code commun_code, name leader, std::set<uint64_t> favorites) {
         control::require_leader_auth(commun_code, leader);
         advise_mosaics(_self, commun_code, leader, favorites);
     }
 
+    // [[eosio::action]] // TODO: removed from MVP
+    void advisemany(name leader, std::vector<gallery_types::advice_batch_item> advices) {
+        advise_many(_self, leader, advices);
+    }
+
     //TODO: [[eosio::action]] void checkadvice (symbol_code commun_code, name leader);
 
     [[eosio::action]] void update(symbol_code commun_code, uint64_t tracery) {
@@ -1242,6 +1382,14 @@ public:
         set_lock_status(_self, commun_code, tracery, false);
     }
 
+    [[eosio::action]] void deactmosaics(symbol_code commun_code, uint16_t max_steps) {
+        deactivate_mosaics(_self, commun_code, max_steps);
+    }
+
+    [[eosio::action]] void schedgems(symbol_code commun_code, name payer, uint16_t max_gems) {
+        schedule_old_gems(_self, commun_code, payer, max_gems);
+    }
+
     [[eosio::action]] void ban(symbol_code commun_code, uint64_t tracery) {
         require_auth(_self);
         ban_mosaic(_self, commun_code, tracery);
@@ -1254,6 +1402,10 @@ public:
     ON_TRANSFER(COMMUN_POINT) void ontransfer(name from, name to, asset quantity, std::string memo) {
         on_points_transfer(_self, from, to, quantity, memo);
     }      
+
+    ON_MINT(COMMUN_POINT) void onmint(name receiver, asset quantity) {
+        on_points_transfer(_self, config::point_name, receiver, quantity, std::string());
+    }
 };
     
 } /// namespace commun
@@ -14,11 +14,17 @@ static constexpr std::array<int64_t, 4>  default_lead_grades =
     {{1000, 500, 300, 200}};
 
 static constexpr uint16_t max_providers_num = 7;
+static constexpr uint16_t max_pool_slices = 64; // a pool row is rewritten on each vote with provided points and on each chop
+static constexpr uint8_t max_advice_batch_size = 10;
 
 static constexpr int64_t forced_chopping_delay = 30 * 24 * 60 * 60;
 
 static constexpr uint8_t auto_claim_num = 3;
+
+static constexpr uint32_t gem_bucket_period = 60 * 60;
+static constexpr uint16_t max_bucket_gems = 100;
 static constexpr uint8_t auto_deactivate_num = 3;
+static constexpr uint8_t stat_shards_num = 16;
 
 #ifndef UNIT_TEST_ENV
     static const eosio::time_point eternity(eosio::days(365 * 8000));
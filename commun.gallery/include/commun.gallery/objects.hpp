@@ -0,0 +1,356 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+#pragma once
+
+#include <eosio/asset.hpp>
+#include <eosio/eosio.hpp>
+#include <eosio/time.hpp>
+#include <eosio/binary_extension.hpp>
+#include "config.hpp"
+#include "pool.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <vector>
+
+// tables and events of the gallery, they don't depend on the other contracts, so c.point includes only this file
+namespace commun {
+
+using namespace eosio;
+
+#define GALLERY_LIBRARY contract("commun.gallery"), contract("commun.publication")
+
+namespace gallery_types {
+    using providers_t = std::vector<std::pair<name, int64_t> >;
+
+    /**
+     * \brief The structure represents mosaic data table in DB.
+     * \ingroup gallery_tables
+     *
+     * \details The table contains data that uniquely identifies and represents a mosaic.
+     *
+     * <b>The states which a mosaic may exist in:</b>
+     * - ACTIVE — Active state of the mosaic, collecting user opinions (sympathy). Once a mosaic is created, it is assigned ACTIVE status;
+     * - MODERATE — Collection of user opinions has been completed. The leaders decide whether to pay reward to author of the mosaic and users who voted;
+     * - ARCHIVED — Mosaic is in archiving state; user opinions collection has been completed;
+     * - LOCKED — Collection of user opinions is temporarily blocked by leaders (i.e. due to complaints from users about the post). Leaders can put it back in the ACTIVE state to continue collecting users' opinions. The time spent by the mosaic in LOCKED state is determined using the lock_date parameter. The period of collecting opinions (collection_period parameter) is increased by this value. The author can improve content of unlocked mosaic. In this case, the lock_date parameter will be reset to zero. Leaders can lock the mosaic again if the author’s work still does not suit users;
+     * - BANNED — Post has been locked by leaders. Collected reward to the author of the post and voted users will not be paid;
+     * - HIDDEN — Post has been removed by the author. Mosaic of the post may still exist, since it takes some time to destroy the gems. If the post has collected the sympathy of users, then rewards to these users will be paid;
+     * - BANNED_AND_HIDDEN — Post has been removed and blocked by leaders (no rewards will be paid).
+     */
+    struct mosaic_struct {
+
+        mosaic_struct() = default;
+        uint64_t tracery; //!< The mosaic tracery, used as primary key
+        name creator;     //!< The mosaic creator
+        
+        name opus;        //!< Mosaic description type. The parameter indicates what the mosaic describes, such as a post or comment.
+        uint16_t royalty; //!< Share (in percent) of royalties to the author for creating the mosaic. When creating a mosaic, its first gem belongs to the author. Part of weight of other gems created by other members is added to the gem of mosaic author. So, part of funds invested in gem is allocated to the mosaic author. 
+
+        time_point lock_date = time_point();   //!< Mosaic lock date. The mosaic is blocked by the leaders if any frauds with the mosaic are detected. After blocking, the collection of gems inside this mosaic is suspended.
+        time_point collection_end_date;        //!< Gem collection period
+        uint16_t gem_count;   //!< Current number of gems inside the mosaic
+        
+        int64_t points;   //!< Number of points collected inside this mosaic. Points are added to the mosaic when users vote.
+        int64_t shares;   //!< Mosaic weight (post weight) calculated via «bancor» function. Weight of vote depends on the voting time. The earlier vote carries more weight.
+        int64_t damn_points = 0;   //!< Number of points related to negative votes
+        int64_t damn_shares = 0;   //!< Number of shares related to negative votes
+        int64_t pledge_points = 0; //!< Number of tokens pledged. A number of points is invested in creating a mosaic and thereby limits the number of mosaics created by author. These points are «frozen» and cannot be part of the reward.
+        
+        int64_t reward = 0;   //!< Total reward amount. The reward is formed not at the end of the mosaic collection, but with a certain periodicity. Rewards are allocated to top mosaics which have become the most popular among users. Number of these mosaics is determined by the \a rewarded_mosaic_num parameter in the \a c.list. The \a c.ctrl contract allocates tokens as a share of the annual emission to \a c.gallery contract. The funds received are converted into points and then distributed among worthy mosaics.
+        
+        int64_t comm_rating = 0;
+        int64_t lead_rating = 0;
+        
+        enum status_t: uint8_t { ACTIVE, MODERATE, ARCHIVED, LOCKED, BANNED, HIDDEN, BANNED_AND_HIDDEN };
+        uint8_t status = ACTIVE;   //!< Field indicating a mosaic status. Once a mosaic is created, it is assigned ACTIVE status.
+        time_point last_top_date = time_point();
+        bool deactivated_xor_locked = false;   //!< Flag indicating the post is inactive or blocked. \a true — post blocked by leaders or archived.
+        
+        bool banned()const { return status == BANNED || status == BANNED_AND_HIDDEN; }
+        bool hidden()const { return status == HIDDEN || status == BANNED_AND_HIDDEN; }
+        bool deactivated()const { return deactivated_xor_locked && status != LOCKED; }
+
+        void lock() {
+            check(status == ACTIVE, "mosaic is inactive");
+            check(lock_date == time_point(), "Mosaic should be modified to lock again.");
+            check(!deactivated_xor_locked, "SYSTEM: lock, incorrect deactivated_xor_locked value");
+            status = LOCKED;
+            lock_date = eosio::current_time_point();
+            deactivated_xor_locked = true;
+        }
+
+        void unlock(int64_t moderation_period) {
+            check(status == LOCKED, "mosaic not locked");
+            check(deactivated_xor_locked, "SYSTEM: unlock, incorrect deactivated_xor_locked value");
+            auto now = eosio::current_time_point();
+            eosio::check(now <= collection_end_date + eosio::seconds(moderation_period), "cannot unlock mosaic after moderation period");
+            status = ACTIVE;
+            collection_end_date += now - lock_date;
+            deactivated_xor_locked = false;
+        }
+
+        uint64_t primary_key() const { return tracery; }
+        using by_comm_rating_t = std::tuple<uint8_t, int64_t, int64_t>;
+        by_comm_rating_t by_comm_rating()const { return std::make_tuple(status, comm_rating, lead_rating); }
+        using by_lead_rating_t = std::tuple<int64_t, int64_t>;
+        by_lead_rating_t by_lead_rating()const { return std::make_tuple(lead_rating, comm_rating); }
+        using by_date_t = std::tuple<bool, time_point>;
+        by_date_t by_date()const { return std::make_tuple(deactivated_xor_locked, collection_end_date); }
+        using by_status_t = std::tuple<uint8_t, time_point>;
+        by_status_t by_status() const { return std::make_tuple(status, collection_end_date); }
+    };
+    
+    /**
+     * \brief The structure represents gem data table in DB.
+     * \ingroup gallery_tables
+     *
+     * The table contains data that uniquely identifies and represents a gem in mosaic.
+     */
+    struct gem_struct {
+        uint64_t id; //!< Unique gem identifier
+        uint64_t tracery; //!< Mosaic tracery containing the gem
+        time_point claim_date; //!< Date when the gem can be broken down. The gem cannot be destroyed until this date. Also, points spent on voting for the mosaic cannot be returned back until this date(such implementation excludes voting for another mosaic with the same points).
+        
+        int64_t points; //!< Number of points that were frozen during voting
+        int64_t shares; //!< Number of shares calculated by the «shares» function
+        
+        int64_t pledge_points; //!< Number of points pledged to create the gem (this is implemented to limit a number of gems created in community. The parameter is set in \a c.list contract).
+        
+        name owner; //!< Gem owner
+        name creator;
+        
+        uint64_t primary_key() const { return id; }
+        using key_t = std::tuple<uint64_t, name, name>;
+        key_t by_key()const { return std::make_tuple(tracery, owner, creator); }
+        key_t by_creator()const { return std::make_tuple(tracery, creator, owner); }
+        using by_claim_t = std::tuple<name, time_point>;
+        by_claim_t by_claim()const { return std::make_tuple(owner, claim_date); }
+    };
+    
+    /**
+     * \brief The structure represents a list of gems whose claim dates are in the same hour, it's used to find gems for forced chopping.
+     * \ingroup gallery_tables
+     *
+     * A gem is added to the bucket of its claim date when it is created or its claim date is postponed, gems created before the buckets are added by \ref schedgems. The bucket isn't changed when the gem is chopped or held, so gems are checked when the bucket is drained. An hour can have several buckets of \a max_bucket_gems gems. The row is paid by the account which added the last gem to it.
+     */
+    struct gem_bucket_struct {
+        uint64_t id; //!< Number of the hour since the epoch shifted left by 8 bits plus the number of the bucket in the hour, used as primary key
+        std::vector<uint64_t> gems; //!< Identifiers of the gems
+        
+        uint64_t primary_key()const { return id; }
+        uint64_t hour()const { return id >> 8; }
+    };
+    
+    /**
+     * \brief The structure represents the table in DB containing total number of all «frozen» points for a user.
+     * \ingroup gallery_tables
+     *
+     * The user account name can be found in the scope field of the table. Each created table has two additional fields — code of the table and scope indicating the owner of points.
+     */
+    struct inclusion_struct {
+        asset quantity; //!< Total number of «frozen» user points
+            // just an idea:
+            // use as inclusion not only points, but also other gems. 
+            // this will allow to buy shares in the mosaics without liquid points, creating more sophisticated collectables
+            // (pntinclusion / geminclusion)
+        
+        uint64_t primary_key()const { return quantity.symbol.code().raw(); }
+    };
+    
+    /**
+     * \brief The structure represents the mosaic statictic data table in DB.
+     * \ingroup gallery_tables
+     *
+     * The table contains statistic information about total number of unclaimed (blocked) points for all users related to a mosaic.
+     */
+    struct stat_struct {
+        uint64_t id; //!< Mosaic identifier
+        int64_t unclaimed = 0; //!< Total number of unclaimed points for all users related to the mosaic, the points in \a statshard are added on the reward of the gallery
+        int64_t retained = 0; //!< Total amount of retained reward related to unclaimed points
+        time_point last_reward_date = time_point();
+        eosio::binary_extension<time_point> next_moderate_date; //!< Collection end date of the earliest active mosaic, nothing is moved to MODERATE before it; empty (the indexes are scanned) for records written before the watermarks
+        eosio::binary_extension<time_point> next_archive_date; //!< Collection end date of the earliest mosaic which is not archived yet, nothing is archived before it (plus moderation and extra reward periods); empty as \a next_moderate_date
+        eosio::binary_extension<uint64_t> unscheduled_gem_id; //!< Gems with lower identifiers are added to \a gembucket by \ref schedgems, the maximum value when all gems are added; empty if none are added
+
+        uint64_t primary_key()const { return id; }
+        bool all_gems_scheduled()const { return unscheduled_gem_id.has_value() && unscheduled_gem_id.value() == std::numeric_limits<uint64_t>::max(); }
+    };
+
+    /**
+     * \brief The structure represents a shard of the unclaimed points of the community statistic.
+     * \ingroup gallery_tables
+     *
+     * Rewards left in removed mosaics are added to the shard of the mosaic tracery instead of the stat, so claims of different mosaics don't write the same row. The shards are folded into the stat when the gallery gets its reward.
+     */
+    struct stat_shard_struct {
+        uint64_t id; //!< Shard number, tracery modulo \a stat_shards_num
+        int64_t unclaimed = 0; //!< Unclaimed points not yet added to the stat
+
+        uint64_t primary_key()const { return id; }
+    };
+    
+    struct allowance_slice {
+        name recipient;
+        uint16_t fee;
+        int64_t total  = 0;
+        int64_t frozen = 0;
+        int64_t available()const { return total - frozen; };
+    };
+    
+    /**
+     * \brief struct represents a pool of points provided by a grantor, one row per grantor in a community scope.
+     *
+     * Allowances of recipients are kept in \a slices sorted by recipient, so the gallery reads or updates all provisions of a grantor with one row access.
+     */
+    struct provider_pool_struct {
+        name grantor;
+        int64_t frozen = 0; //!< Sum of frozen points of all slices
+        std::vector<allowance_slice> slices; //!< Allowances of recipients, sorted by recipient
+
+        uint64_t primary_key()const { return grantor.value; }
+
+        const allowance_slice* get_slice(name recipient)const { return pool::get_slice(slices, recipient); }
+        allowance_slice* get_slice(name recipient) { return pool::get_slice(slices, recipient); }
+    };
+    
+    struct advice_struct {
+        name leader;
+        std::set<uint64_t> favorites;
+        uint64_t primary_key()const { return leader.value; }
+    };
+
+    struct advice_batch_item {
+        symbol_code commun_code;
+        std::set<uint64_t> favorites;
+    };
+    
+    using mosaic_comm_index [[using eosio: non_unique, order("status","asc"), order("comm_rating","desc"), order("lead_rating","desc")]] =
+        eosio::indexed_by<"bycommrating"_n, eosio::const_mem_fun<gallery_types::mosaic_struct, gallery_types::mosaic_struct::by_comm_rating_t, &gallery_types::mosaic_struct::by_comm_rating> >;
+    using mosaic_lead_index [[using eosio: non_unique, order("lead_rating","desc"), order("comm_rating","desc")]] =
+        eosio::indexed_by<"byleadrating"_n, eosio::const_mem_fun<gallery_types::mosaic_struct, gallery_types::mosaic_struct::by_lead_rating_t, &gallery_types::mosaic_struct::by_lead_rating> >;
+    using mosaic_coll_end_index [[using eosio: non_unique, order("deactivated_xor_locked","desc"), order("collection_end_date","asc")]] =
+        eosio::indexed_by<"bydate"_n, eosio::const_mem_fun<gallery_types::mosaic_struct, gallery_types::mosaic_struct::by_date_t, &gallery_types::mosaic_struct::by_date> >;
+    using mosaic_status_index [[using eosio: non_unique, order("status","desc"), order("collection_end_date","asc")]] =
+        eosio::indexed_by<"bystatus"_n, eosio::const_mem_fun<gallery_types::mosaic_struct, gallery_types::mosaic_struct::by_status_t, &gallery_types::mosaic_struct::by_status> >;
+
+    using mosaics [[using eosio: order("tracery","asc"), scope_type("symbol_code"), GALLERY_LIBRARY]] = eosio::multi_index<"mosaic"_n, gallery_types::mosaic_struct, mosaic_comm_index, mosaic_lead_index, mosaic_coll_end_index, mosaic_status_index>;
+    
+    using gem_key_index [[using eosio: order("tracery","asc"), order("owner","asc"), order("creator","asc")]] =
+        eosio::indexed_by<"bykey"_n, eosio::const_mem_fun<gallery_types::gem_struct, gallery_types::gem_struct::key_t, &gallery_types::gem_struct::by_key> >;
+    using gem_creator_index [[using eosio: order("tracery","asc"), order("creator","asc"), order("owner","asc")]] =
+        eosio::indexed_by<"bycreator"_n, eosio::const_mem_fun<gallery_types::gem_struct, gallery_types::gem_struct::key_t, &gallery_types::gem_struct::by_creator> >;
+    using gem_claim_index [[using eosio: non_unique, order("owner","asc"), order("claim_date","asc")]] =
+        eosio::indexed_by<"byclaim"_n, eosio::const_mem_fun<gallery_types::gem_struct, gallery_types::gem_struct::by_claim_t, &gallery_types::gem_struct::by_claim> >;
+
+    using gems [[using eosio: order("id","asc"), scope_type("symbol_code"), GALLERY_LIBRARY]] = eosio::multi_index<"gem"_n, gallery_types::gem_struct, gem_key_index, gem_creator_index, gem_claim_index>;
+    using gem_buckets [[using eosio: order("id","asc"), scope_type("symbol_code"), GALLERY_LIBRARY]] = eosio::multi_index<"gembucket"_n, gallery_types::gem_bucket_struct>;
+    
+    using inclusions [[using eosio: order("quantity._sym","asc"), GALLERY_LIBRARY]] = eosio::multi_index<"inclusion"_n, gallery_types::inclusion_struct>;
+    
+    using provider_pools [[using eosio: order("grantor","asc"), scope_type("symbol_code"), GALLERY_LIBRARY]] = eosio::multi_index<"provpool"_n, gallery_types::provider_pool_struct>;
+
+    using advices [[using eosio: scope_type("symbol_code"), order("leader","asc"), GALLERY_LIBRARY]] = eosio::multi_index<"advice"_n, gallery_types::advice_struct>;
+
+    using stats [[using eosio: scope_type("symbol_code"), order("id","asc"), GALLERY_LIBRARY]] = eosio::multi_index<"stat"_n, gallery_types::stat_struct>;
+    using stat_shards [[using eosio: scope_type("symbol_code"), order("id","asc"), GALLERY_LIBRARY]] = eosio::multi_index<"statshard"_n, gallery_types::stat_shard_struct>;
+    
+namespace events {
+    
+    /**
+     * \brief The structure represents a mosaic destruction event. The mosaic is destroyed after destruction of the last gem belonging to this mosaic.
+     * \ingroup gallery_events
+     */
+    struct [[using eosio: event("mosaicchop"), GALLERY_LIBRARY]] mosaic_chop_event {
+        symbol_code commun_code; //!< Point symbol
+        uint64_t tracery; //!< Tracery that breaks down
+    };
+    
+    /**
+     * \brief The structure represents a mosaic state change event. Such event is sent when a mosaic state changes.
+     * \ingroup gallery_events
+     */
+    struct [[using eosio: event("mosaicstate"), GALLERY_LIBRARY]] mosaic_state_event {
+        uint64_t tracery; //!< Mosaic tracery
+        name creator; //!< Mosaic creator
+        time_point collection_end_date; //!< End date of collecting user opinions
+        uint16_t gem_count; //!< Number of gems inside the mosaic
+        int64_t shares; //!< Mosaic weight
+        int64_t damn_shares; //!< Weight of gems with negative votes
+        asset reward; //!< Amount of currently collected rewards
+        bool banned; //!< Flag indicating the blocking of reward at the initiative of community leaders
+    };
+    
+    /**
+     * \brief The structure represents a gem state change event. Gem for a mosaic is automatically created when an author creates the mosaic. A state of the gem changes when a user votes.
+     * \ingroup gallery_events
+     */
+    struct [[using eosio: event("gemstate"), GALLERY_LIBRARY]] gem_state_event {
+        uint64_t tracery; //!< Mosaic tracery
+        name owner; //!< Mosaic owner
+        name creator;
+        asset points; //!< Number of «frozen» points in the gem
+        asset pledge_points; //!< Number of pledged points in the gem
+        bool damn; //!< Flag indicating a negative or positive user opinion. \a true is negative one.
+        int64_t shares; //!< Weight of gem calculated by the bancor function
+    };
+    
+    /**
+     * \brief The structure represents a gem destruction event. Mosaic breaks down after rewarding it, when users can take back their points.
+     * \ingroup gallery_events
+     */
+    struct [[using eosio: event("gemchop"), GALLERY_LIBRARY]] gem_chop_event {
+        uint64_t tracery; //!< Mosaic tracery
+        name owner; //!< Mosaic owner
+        name creator;
+        asset reward; //!< Gem owner reward.
+        asset unfrozen; //!< Number of returned points that were «frozen» at the time of collecting user opinions. This is total number of points given as sympathies and those that were pledged.
+    };
+    
+    /**
+     * \brief The structure represents the event about the selected best mosaics to be rewarded. The number of selected mosaics is determined by the \a rewarded_mosaic_num parameter in the \a c.list contract and defaults to 10.
+     * \ingroup gallery_events
+     */
+    struct [[using eosio: event("mosaictop"), GALLERY_LIBRARY]] mosaic_top_event {
+        symbol_code commun_code; //!< Point symbol
+        uint64_t tracery; //!< Mosaic tracery
+        uint16_t place; //!< Place where the mosaic is located
+        int64_t comm_rating;
+        int64_t lead_rating;
+    };
+    
+    /**
+     * \brief The structure represents an event about the current number of «frozen» user points.
+     * \ingroup gallery_events
+     */
+    struct [[using eosio: event("inclstate"), GALLERY_LIBRARY]] inclusion_state_event {
+        name account; //!< User account that changed the current number of «frozen» points. The event occurred due to this account action.
+        asset quantity; //!< Current number of «frozen» points belonging to the account
+    };
+    
+    /**
+     * \brief The structure represents a summary event sent when several gems of an account are chopped at once by the \a claimall action. The \a gemchop event is still sent for each gem.
+     * \ingroup gallery_events
+     */
+    struct [[using eosio: event("gemsclaim"), GALLERY_LIBRARY]] gems_claim_event {
+        name owner; //!< Gems owner
+        uint16_t gem_count; //!< Number of chopped gems
+        asset reward; //!< Total reward of the chopped gems
+        asset unfrozen; //!< Total number of returned points
+    };
+}// events
+}// gallery_types
+
+namespace gallery_types {
+
+    inline int64_t get_frozen_amount(name gallery_contract_account, name owner, symbol_code sym_code) {
+        inclusions inclusions_table(gallery_contract_account, owner.value);
+        auto incl = inclusions_table.find(sym_code.raw());
+        return incl != inclusions_table.end() ? incl->quantity.amount : 0;
+    }
+}// gallery_types
+
+} /// namespace commun
@@ -0,0 +1,57 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// bookkeeping of the provider pools, it doesn't depend on eosio types, so the unit tests use it directly
+namespace commun { namespace pool {
+
+// slices of a pool are sorted by recipient
+template<typename Slice, typename Key>
+typename std::vector<Slice>::const_iterator slice_pos(const std::vector<Slice>& slices, Key recipient) {
+    return std::lower_bound(slices.begin(), slices.end(), recipient,
+        [](const Slice& s, Key r) { return s.recipient < r; });
+}
+
+template<typename Slice, typename Key>
+const Slice* get_slice(const std::vector<Slice>& slices, Key recipient) {
+    auto pos = slice_pos(slices, recipient);
+    return pos != slices.end() && pos->recipient == recipient ? &*pos : nullptr;
+}
+
+template<typename Slice, typename Key>
+Slice* get_slice(std::vector<Slice>& slices, Key recipient) {
+    return const_cast<Slice*>(get_slice(static_cast<const std::vector<Slice>&>(slices), recipient));
+}
+
+template<typename Slice>
+void insert_slice(std::vector<Slice>& slices, const Slice& slice) {
+    slices.insert(slices.begin() + (slice_pos(slices, slice.recipient) - slices.begin()), slice);
+}
+
+// returns frozen points of the removed slice, the caller subtracts them from the pool
+template<typename Slice, typename Key>
+int64_t erase_slice(std::vector<Slice>& slices, Key recipient) {
+    auto pos = slices.begin() + (slice_pos(slices, recipient) - slices.begin());
+    if (pos == slices.end() || pos->recipient != recipient) {
+        return 0;
+    }
+    auto frozen = pos->frozen;
+    slices.erase(pos);
+    return frozen;
+}
+
+// changes a slice and the pool sum of frozen points together, returns false if the recipient has no slice
+template<typename Pool, typename Key>
+bool change_slice(Pool& pool, Key recipient, int64_t total, int64_t frozen) {
+    auto slice = get_slice(pool.slices, recipient);
+    if (!slice) {
+        return false;
+    }
+    slice->total  += total;
+    slice->frozen += frozen;
+    pool.frozen   += frozen;
+    return true;
+}
+
+} } // commun::pool
@@ -17,6 +17,7 @@ class
 /// @endcond
 commun_list: public contract {
     uint64_t validate_name(tables::community& community_tbl, const std::string& community_name);
+    void update_param_vote(symbol_code commun_code, name param, name leader, optional<int64_t> value);
 public:
     using contract::contract;
 
@@ -220,6 +221,32 @@ public:
     */
     [[eosio::action]] void unban(symbol_code commun_code, name account, std::string reason);
 
+    /**
+        \brief The \ref voteparam action is used by a community leader to vote for a value of a community parameter.
+
+        \param commun_code a point symbol of the community
+        \param leader account of the leader
+        \param param name of the parameter: \a gemsperday (gems_per_day), \a emissionrate (emission_rate), \a collperiod (collection_period) or \a moderperiod (moderation_period)
+        \param value proposed value of the parameter. The vote is removed if this parameter is not set
+
+        The parameter takes the median of the values voted by leaders once more than a half of \a leaders_num leaders voted for it. A vote changes the median by one position, so the cost of the action doesn't depend on the number of votes.
+
+        \signreq
+            — the \a leader account, which must be in the top of community leaders.
+    */
+    [[eosio::action]] void voteparam(symbol_code commun_code, name leader, name param, optional<int64_t> value);
+
+    /**
+        \brief The \ref clrparamvote action removes a parameter vote of an account which is not a community leader any more.
+
+        \param commun_code a point symbol of the community
+        \param leader account whose vote is removed
+        \param param name of the parameter
+
+        \nosignreq
+    */
+    [[eosio::action]] void clrparamvote(symbol_code commun_code, name leader, name param);
+
     static auto& get_community(symbol_code commun_code) {
         static tables::community community_tbl(config::list_name, config::list_name.value);
         return community_tbl.get(commun_code.raw(), "community not exists");
@@ -176,6 +176,43 @@ private:
     }
 };
 
+/**
+ * \brief The structure represents a vote of a community leader for a value of a community parameter.
+ * \ingroup list_tables
+ *
+ * Such record is created by \ref commun_list::voteparam and removed by \ref commun_list::voteparam or \ref commun_list::clrparamvote.
+ */
+// DOCS_TABLE: param_vote
+struct param_vote {
+    uint64_t id;
+    name param;     //!< Name of the parameter
+    name leader;    //!< Leader who voted
+    int64_t value;  //!< Value proposed by the leader
+
+    uint64_t primary_key() const { return id; }
+
+    using value_key_t = std::tuple<name, int64_t, name>;
+    value_key_t by_value() const { return std::make_tuple(param, value, leader); }
+    using leader_key_t = std::tuple<name, name>;
+    leader_key_t by_leader() const { return std::make_tuple(param, leader); }
+};
+
+/**
+ * \brief The structure represents the current median of leader votes for a community parameter.
+ * \ingroup list_tables
+ *
+ * The median points to a vote in the "byvalue" index of \a paramvote table and is moved by one vote on each vote change, so it is never recalculated from scratch. For an even number of votes the upper of two middle votes is used.
+ */
+// DOCS_TABLE: param_median
+struct param_median {
+    name param;     //!< Name of the parameter
+    uint16_t count; //!< Number of votes for the parameter
+    int64_t value;  //!< Value of the median vote
+    name leader;    //!< Leader of the median vote (makes the median position unique)
+
+    uint64_t primary_key() const { return param.value; }
+};
+
 }
 
 namespace commun::tables {
@@ -185,4 +222,14 @@ namespace commun::tables {
     using community [[using eosio: order("commun_symbol._sym","asc"), contract("commun.list")]] = eosio::multi_index<"community"_n, structures::community, comn_hash_index>;
 
     using dapp [[using eosio: order("id","asc"), contract("commun.list")]] = eosio::multi_index<"dapp"_n, structures::dapp>;
+
+    using param_vote_value_index [[using eosio: order("param","asc"), order("value","asc"), order("leader","asc")]] =
+        eosio::indexed_by<"byvalue"_n, eosio::const_mem_fun<structures::param_vote, structures::param_vote::value_key_t, &structures::param_vote::by_value>>;
+    using param_vote_leader_index [[using eosio: order("param","asc"), order("leader","asc")]] =
+        eosio::indexed_by<"byleader"_n, eosio::const_mem_fun<structures::param_vote, structures::param_vote::leader_key_t, &structures::param_vote::by_leader>>;
+    using paramvote [[using eosio: scope_type("symbol_code"), order("id","asc"), contract("commun.list")]] =
+        eosio::multi_index<"paramvote"_n, structures::param_vote, param_vote_value_index, param_vote_leader_index>;
+
+    using parammedian [[using eosio: scope_type("symbol_code"), order("param","asc"), contract("commun.list")]] =
+        eosio::multi_index<"parammedian"_n, structures::param_median>;
 }
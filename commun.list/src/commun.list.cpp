@@ -123,6 +123,10 @@ void commun_list::setsysparams(symbol_code commun_code, optional<std::string> co
     });
 }
 
+static bool valid_emission_rate(int64_t rate) {
+    return rate == PERC(1) || (PERC(5) <= rate && rate <= PERC(50) && (rate % PERC(5) == 0));
+}
+
 void commun_list::setparams(symbol_code commun_code,
         optional<uint8_t> leaders_num, optional<uint8_t> max_votes, 
         optional<name> permission, optional<uint8_t> required_threshold, 
@@ -130,9 +134,7 @@ void commun_list::setparams(symbol_code commun_code,
     require_auth(point::get_issuer(commun_code));
 
     // <> Place for checks
-    eosio::check(!emission_rate.has_value() || *emission_rate == PERC(1) ||
-        (PERC(5) <= *emission_rate && *emission_rate <= PERC(50) && (*emission_rate % PERC(5) == 0)),
-        "incorrect emission rate");
+    eosio::check(!emission_rate.has_value() || valid_emission_rate(*emission_rate), "incorrect emission rate");
     eosio::check(!leaders_percent.has_value() ||
         (PERC(1) <= *leaders_percent && *leaders_percent <= PERC(10) && (*leaders_percent % PERC(1) == 0)),
         "incorrect leaders percent");
@@ -161,6 +163,127 @@ void commun_list::setparams(symbol_code commun_code,
     });
 }
 
+// checks the value of a leader-voted parameter and sets it, returns true if the value changed
+static bool set_voted_param(structures::community& c, name param, int64_t value) {
+    const auto set = [&](auto& field) {
+        bool changed = field != value;
+        field = value;
+        return changed;
+    };
+    switch (param.value) {
+    case "gemsperday"_n.value:
+        eosio::check(0 < value && value <= std::numeric_limits<uint16_t>::max(), "incorrect gems per day");
+        return set(c.gems_per_day);
+    case "emissionrate"_n.value:
+        eosio::check(valid_emission_rate(value), "incorrect emission rate");
+        return set(c.emission_rate);
+    case "collperiod"_n.value:
+        eosio::check(0 < value && value <= config::max_voted_period, "incorrect collection period");
+        return set(c.collection_period);
+    case "moderperiod"_n.value:
+        eosio::check(0 < value && value <= config::max_voted_period, "incorrect moderation period");
+        return set(c.moderation_period);
+    }
+    eosio::check(false, "unknown parameter");
+    return false;
+}
+
+// moves the median to the next (step > 0) or to the previous vote in "byvalue" order
+template<typename Idx>
+static void move_median(Idx& idx, structures::param_median& m, int step) {
+    auto itr = idx.find(std::make_tuple(m.param, m.value, m.leader));
+    eosio::check(itr != idx.end(), "SYSTEM: median vote not found");
+    if (step > 0) {
+        ++itr;
+    } else {
+        eosio::check(itr != idx.begin(), "SYSTEM: median out of range");
+        --itr;
+    }
+    eosio::check(itr != idx.end() && itr->param == m.param, "SYSTEM: median out of range");
+    m.value = itr->value;
+    m.leader = itr->leader;
+}
+
+void commun_list::update_param_vote(symbol_code commun_code, name param, name leader, optional<int64_t> value) {
+    tables::community community_tbl(_self, _self.value);
+    auto& community = community_tbl.get(commun_code.raw(), "community not exists");
+    if (value) {
+        structures::community c = community;
+        set_voted_param(c, param, *value);  // validates the value
+    }
+
+    tables::paramvote votes(_self, commun_code.raw());
+    auto value_idx = votes.get_index<"byvalue"_n>();
+    auto leader_idx = votes.get_index<"byleader"_n>();
+    auto vote = leader_idx.find(std::make_tuple(param, leader));
+    const bool have_vote = vote != leader_idx.end();
+    eosio::check(have_vote || value, "no vote to remove");
+    eosio::check(!have_vote || !value || vote->value != *value, "the same value already voted");
+
+    tables::parammedian medians(_self, commun_code.raw());
+    auto median_itr = medians.find(param.value);
+    structures::param_median m = median_itr != medians.end() ? *median_itr : structures::param_median{param, 0, 0, name()};
+
+    // the median is the vote number count/2 in "byvalue" order; a vote change moves it by at most one vote
+    if (have_vote) {
+        eosio::check(m.count > 0, "SYSTEM: incorrect param votes count");
+        const auto key = std::make_tuple(vote->value, vote->leader);
+        const auto med = std::make_tuple(m.value, m.leader);
+        const bool odd = m.count % 2;
+        if (key == med) {
+            if (m.count > 1) {
+                move_median(value_idx, m, odd ? 1 : -1);
+            }
+        } else if (key < med ? odd : !odd) {
+            move_median(value_idx, m, key < med ? 1 : -1);
+        }
+        --m.count;
+        leader_idx.erase(vote);
+    }
+    if (value) {
+        votes.emplace(leader, [&](auto& v) { v = structures::param_vote{
+            .id = votes.available_primary_key(),
+            .param = param,
+            .leader = leader,
+            .value = *value
+        };});
+        const auto key = std::make_tuple(*value, leader);
+        const bool odd = m.count % 2;
+        if (!m.count) {
+            m.value = *value;
+            m.leader = leader;
+        } else if (key < std::make_tuple(m.value, m.leader) ? !odd : odd) {
+            move_median(value_idx, m, odd ? 1 : -1);
+        }
+        ++m.count;
+    }
+
+    if (!m.count) {
+        medians.erase(median_itr);
+        return;
+    }
+    if (median_itr == medians.end()) {
+        medians.emplace(_self, [&](auto& item) { item = m; });
+    } else {
+        medians.modify(median_itr, eosio::same_payer, [&](auto& item) { item = m; });
+    }
+
+    structures::community c = community;
+    if (m.count > c.control_param.leaders_num / 2 && set_voted_param(c, param, m.value)) {
+        community_tbl.modify(community, eosio::same_payer, [&](auto& item) { item = c; });
+    }
+}
+
+void commun_list::voteparam(symbol_code commun_code, name leader, name param, optional<int64_t> value) {
+    control::require_leader_auth(commun_code, leader);
+    update_param_vote(commun_code, param, leader, value);
+}
+
+void commun_list::clrparamvote(symbol_code commun_code, name leader, name param) {
+    eosio::check(!control::in_the_top(commun_code, leader), "leader is in the top");
+    update_param_vote(commun_code, param, leader, {});
+}
+
 #undef SET_PARAM
 #undef PERC
 
@@ -8,6 +8,7 @@
 #include <eosio/eosio.hpp>
 #include <eosio/asset.hpp>
 #include <eosio/singleton.hpp>
+#include <eosio/binary_extension.hpp>
 #include "config.hpp"
 
 #include <string>
@@ -68,6 +69,7 @@ public:
         \param fee commission (in percent) charged from the amount of CMN tokens when buying and selling points.
         \param transfer_fee commission (in percent) charged from the amount of point transfer. This parameter should be at least min_transfer_fee_points. The commission and the amount transferred are debited from balance of the "from" account. Default value is "10" that corresponds to "0,1" (%)
         \param min_transfer_fee_points minimum number of points transferred as fee. Such number of points will be debited from the account, even if the calculated fee is less than this value. Default value is "1" that corresponds to one smallest part of point (i.e. 0,001 point)
+        \param batch_exchange enables the batch exchange mode. In this mode buying and selling orders are queued and are executed by the \ref settle action. Disabled by default
 
         All parameters except \a commun_code are optionally. So, each of them can be set via separate calling of this action. At least one of these parameters must be set.
 
@@ -80,7 +82,8 @@ public:
             — <i>the point issuer</i> .
     */
     [[eosio::action]]
-    void setparams(symbol_code commun_code, std::optional<uint16_t> fee, std::optional<uint16_t> transfer_fee, std::optional<int64_t> min_transfer_fee_points);
+    void setparams(symbol_code commun_code, std::optional<uint16_t> fee, std::optional<uint16_t> transfer_fee, std::optional<int64_t> min_transfer_fee_points,
+                   std::optional<bool> batch_exchange);
 
     /**
         \brief The \ref setfreezer action is used to set contract account, so, this account will have ability to "freeze" the points or the CMN tokens on its balance.
@@ -114,6 +117,23 @@ public:
     [[eosio::action]]
     void issue(name to, asset quantity, string memo);
 
+    /**
+        \brief The \ref mintto action is used to put the points into circulation directly on balance of a contract (used for the emission).
+
+        \param receiver account, on whose balance the points are credited
+        \param quantity number of the supplied points
+
+        The number of supplied points should not exceed the maximum_supply value specified by the \ref create action.
+        When the \ref mintto action is called, the information about \a currency and \a balance events is sent to the event engine.
+
+        Unlike \ref issue, the points are not credited to the \a issuer balance and then transferred. The \a receiver is notified about this action once and can handle it in the same way as an incoming transfer.
+
+        \signreq
+            — <i>the \a c.point contract account</i> (the emission contract gets it via a linked permission) .
+    */
+    [[eosio::action]]
+    void mintto(name receiver, asset quantity);
+
     /**
         \brief The \ref retire action is used for taking a certain number of points out of circulation ("burning" the points). These points can be withdrawn from balance of the \a issuer account as well as from balance of any other account.
 
@@ -200,6 +220,21 @@ public:
     [[eosio::action]]
     void withdraw(name owner, asset quantity);
 
+    /**
+        \brief The \ref settle action executes the queued exchange orders of a point in the batch exchange mode.
+
+        \param commun_code the point symbol code
+        \param max_orders maximum number of orders to execute, the oldest orders are executed first
+
+        All buying orders of the batch get points at one price, and then all selling orders of the batch get CMN tokens at one price, so the bancor formula is evaluated once for each side and the point statistics is updated once. An order is returned to its owner if the batch price doesn't satisfy its minimum (set by the "minimum: " memo prefix). Excluding orders only improves the price for the rest of the side, so the price is recalculated at most once more.
+
+        When this action is called, the information about \a balance, \a currency, \a exchange and \a fee events is sent to the event engine. The \a exchange event is sent once for each side with the total amount.
+
+        \nosignreq
+    */
+    [[eosio::action]]
+    void settle(symbol_code commun_code, uint16_t max_orders);
+
     /**
         \brief The \ref enablesafe action enables a safe on given balance and sets its initial parameters.
 
@@ -305,6 +340,33 @@ public:
      */
     [[eosio::action]] void cancelsafemod(name owner, name mod_id);
 
+    /**
+        \brief The \ref applyready action applies all ready delayed changes of the safes of an account.
+
+        \param owner account name of safe owner
+        \param max maximum number of delayed changes to look through. This parameter must be greater than "0"
+
+        The balance owner calls this action to apply in one pass the delayed changes whose delay has passed, for safes of all points. Changes are applied in order of the time they became ready (then of identifier), like separate \ref applysafemod calls made as soon as possible, so a later change of the same parameter wins. Only ready changes are looked through. Ready changes of disabled safes are removed. The action fails if nothing was applied or removed, or if the points are locked by \ref globallock.
+
+        \signreq
+            — the \a owner account.
+     */
+    [[eosio::action]] void applyready(name owner, uint16_t max);
+
+    /**
+        \brief The \ref sweepmods action removes stale delayed changes of the safes of an account and frees their storage.
+
+        \param owner account name of safe owner
+        \param max maximum number of delayed changes to look through. This parameter must be greater than "0"
+
+        A delayed change is stale if its safe is disabled or if it was ready but not applied during \a safe_mod_expiry period. The action fails if nothing was removed.
+
+        No signature is required, so the storage of abandoned accounts can be freed without their owners. It is safe for the owner: a change of a disabled safe can't be applied anyway, and removing a change never unlocks points or weakens a safe. The worst case for the owner is to request again a change left unapplied for \a safe_mod_expiry period. The memory of the removed records is returned to the owner, who paid for it.
+
+        \nosignreq
+     */
+    [[eosio::action]] void sweepmods(name owner, uint16_t max);
+
     /**
         \brief The \ref globallock action locks all points (except for "frozen" ones) and delayed mods to given period of time.
 
@@ -318,6 +380,33 @@ public:
      */
     [[eosio::action]] void globallock(name owner, uint32_t period); // Can also add "deletelock" to free storage
 
+    /**
+        \brief The \ref recountsafes action recalculates the number of safes stored in the guard record of an account.
+
+        \param owner account name of safes owner
+        \param ram_payer account name that pays for the guard record
+
+        The guard record (\ref lock_struct) keeps the number of enabled safes, so transfers of accounts without safes don't look into the safe table. The counter is recalculated by \ref enablesafe, \ref disablesafe and \ref applysafemod; this action sets it for safes enabled before the counter was introduced. Until then the safe table is checked on each transfer of the account. It fails if the counter is already correct, so a caller can't rewrite the record for nothing.
+
+        Any account may recount the safes of the owner to finish the migration before \ref safescounted, the memory of the written record is charged to it.
+
+        \signreq
+            — the \a ram_payer account (optional)  
+            or  
+            — \a owner (required if the \a ram_payer's sign is omitted) .
+     */
+    [[eosio::action]] void recountsafes(name owner, std::optional<name> ram_payer);
+
+    /**
+        \brief The \ref safescounted action marks that the safes of all accounts are counted.
+
+        It is called after \ref recountsafes has been run for every account having safes. Before that, transfers of accounts without the guard record look into the safe table, since they can have safes enabled before the counter was introduced.
+
+        \signreq
+            — <i>majority of Commun dApp leaders</i> .
+    */
+    [[eosio::action]] void safescounted();
+
     static inline bool exist(symbol_code commun_code) {
         stats stats_table(config::point_name, commun_code.raw());
         return stats_table.find(commun_code.raw()) != stats_table.end();
@@ -437,6 +526,7 @@ struct structures {
         name     issuer; //!< Account who issued the points*
         uint16_t transfer_fee = config::def_transfer_fee; //!< Fee charged for transfer of the points
         int64_t min_transfer_fee_points = config::def_min_transfer_fee_points; //!< Minimum amount of fee charged for transfer of points
+        eosio::binary_extension<bool> batch_exchange; //!< Buying and selling orders are queued and executed by the \ref settle action; empty (disabled) for records written before the mode
 
         uint64_t primary_key()const { return max_supply.symbol.code().raw(); }
         name by_issuer()const { return issuer; }
@@ -449,6 +539,7 @@ struct structures {
     // DOCS_TABLE: globalparam_struct
     struct globalparam_struct {
         name point_freezer; //!< A name of contract that has the ability to freeze points of accounts
+        eosio::binary_extension<bool> safes_counted; //!< Safes of all accounts are counted in their guard records (\ref safescounted)
     };
 
     /**
@@ -480,6 +571,8 @@ struct structures {
         uint64_t primary_key() const { return id.value; }
         using key_t = std::tuple<symbol_code, name>;
         key_t by_symbol_code() const { return std::make_tuple(commun_code, id); }
+        using date_key_t = std::tuple<time_point_sec, name>;
+        date_key_t by_date() const { return std::make_tuple(date, id); }
 
 #ifndef UNIT_TEST_ENV
         EOSLIB_SERIALIZE(safemod_struct, (id)(commun_code)(date)(unlock)(delay)(trusted))
@@ -487,12 +580,28 @@ struct structures {
     };
 
     /**
-        \brief DB record containing information about a global lock; singleton; scope = safe owner
+        \brief DB record containing information about a queued exchange order in the batch exchange mode; scope = point symbol code
+        \ingroup point_tables
+    */
+    // DOCS_TABLE: order_struct
+    struct order_struct {
+        uint64_t id;        //!< order id, orders are executed in ascending order
+        name owner;         //!< account buying or selling points
+        asset quantity;     //!< CMN tokens to spend (including the fee) or points to sell
+        asset min_order;    //!< minimum amount to get (points or CMN tokens), zero if not set
+
+        uint64_t primary_key() const { return id; }
+        bool buying() const { return quantity.symbol == config::reserve_token; }
+    };
+
+    /**
+        \brief DB record guarding debits of an account: a global lock and the number of enabled safes; singleton; scope = safe owner
         \ingroup point_tables
     */
     // DOCS_TABLE: lock_struct
     struct lock_struct {
         time_point_sec unlocks; //!< time when lock becomes ineffective
+        eosio::binary_extension<uint16_t> safes; //!< number of safes enabled by the owner; empty for records written before the counter
     };
 };
 
@@ -508,16 +617,20 @@ struct structures {
 
     using safemod_sym_idx [[using eosio: order("commun_code","asc"), order("id","asc")]] = eosio::indexed_by<"bysymbolcode"_n,
         eosio::const_mem_fun<structures::safemod_struct, structures::safemod_struct::key_t, &structures::safemod_struct::by_symbol_code>>;
-    using safemod_tbl [[eosio::order("id","asc")]] = eosio::multi_index<"safemod"_n, structures::safemod_struct, safemod_sym_idx>;
+    using safemod_date_idx [[using eosio: order("date","asc"), order("id","asc")]] = eosio::indexed_by<"bydate"_n,
+        eosio::const_mem_fun<structures::safemod_struct, structures::safemod_struct::date_key_t, &structures::safemod_struct::by_date>>;
+    using safemod_tbl [[eosio::order("id","asc")]] = eosio::multi_index<"safemod"_n, structures::safemod_struct, safemod_sym_idx, safemod_date_idx>;
 
     using lock_singleton [[eosio::order("id","asc")]] = eosio::singleton<"lock"_n, structures::lock_struct>;
 
+    using orders [[using eosio: order("id","asc"), scope_type("symbol_code")]] = eosio::multi_index<"order"_n, structures::order_struct>;
+
     void notify_balance_change(name owner, asset diff);
     void sub_balance(name owner, asset value);
     void add_balance(name owner, asset value, name ram_payer);
 
     static inline double get_cw(const structures::param_struct& param) {
-        return static_cast<double>(param.cw) / static_cast<double>(commun::config::_100percent);
+        return math::cw_to_double(param.cw);
     }
 
     static inline asset calc_reserve_quantity(const structures::param_struct& param, const structures::stat_struct& stat, asset token_quantity, asset* fee_quantity) {
@@ -525,24 +638,12 @@ struct structures {
         check(token_quantity.amount <= stat.supply.amount, "can't convert more than supply");
         if (token_quantity.amount == 0)
             return asset(0, stat.reserve.symbol);
-        int64_t ret = 0;
-        if (token_quantity.amount == stat.supply.amount)
-            ret = stat.reserve.amount;
-        else if (param.cw == commun::config::_100percent)
-            ret = safe_prop(token_quantity.amount, stat.reserve.amount, stat.supply.amount);
-        else {
-            double sell_prop = static_cast<double>(token_quantity.amount) / static_cast<double>(stat.supply.amount);
-            ret = static_cast<int64_t>(static_cast<double>(stat.reserve.amount) * (1.0 - std::pow(1.0 - sell_prop, 1.0 / get_cw(param))));
-        }
+        int64_t ret = math::bancor_sell(stat.reserve.amount, stat.supply.amount, param.cw, token_quantity.amount);
 
         if (fee_quantity) {
-            if (param.fee) {
-                auto initial = ret;
-                ret = safe_pct(ret, config::_100percent - param.fee);
-                *fee_quantity = asset(initial - ret, stat.reserve.symbol);
-            } else {
-                *fee_quantity = asset(0, stat.reserve.symbol);
-            }
+            auto initial = ret;
+            ret = math::sub_fee(ret, param.fee);
+            *fee_quantity = asset(initial - ret, stat.reserve.symbol);
         }
 
         return asset(ret, stat.reserve.symbol);
@@ -572,6 +673,21 @@ struct structures {
     
     void burn_the_fee(const asset& quantity, symbol_code commun_code, bool buying_points);
 
+    void queue_order(name owner, symbol_code commun_code, asset quantity, asset min_order);
+
+    struct batch_order {
+        name owner;
+        int64_t amount;     // CMN tokens to spend or points to sell
+        int64_t net;        // amount after the fee for buying orders
+        int64_t min;
+        int64_t result = 0;
+        bool rejected = false;
+    };
+
+    static int64_t fill_buy_orders(const structures::param_struct& param, const structures::stat_struct& stat, std::vector<batch_order>& batch);
+    static int64_t fill_sell_orders(const structures::param_struct& param, const structures::stat_struct& stat, std::vector<batch_order>& batch,
+                                    int64_t& fee);
+
     void delay_safe_change(
         name owner, asset unlock, name mod_id, std::optional<uint32_t> delay, std::optional<name> trusted,
         bool check_params = true, bool check_sym = true);
@@ -579,11 +695,18 @@ struct structures {
         name owner, symbol_code commun_code, name mod_id, std::optional<uint32_t> delay, std::optional<name> trusted,
         bool check_params = true);
 
+    static inline bool is_active(const structures::lock_struct& lock) {
+        return lock.unlocks > eosio::current_time_point();
+    }
+
     static inline bool is_locked(name owner) {
         lock_singleton lock(config::point_name, owner.value);
-        return lock.exists() && lock.get().unlocks > eosio::current_time_point();
+        return lock.exists() && is_active(lock.get());
     }
 
+    uint16_t count_safes(name owner);
+    void update_safes_count(name owner, name payer);
+
     /**
       \brief The structure representing the event related to change of point state. Such event occurs if at least one of the two values (supply or reserve) changes during execution of the actions \ref create, \ref issue and \ref retire as well as during the reserve tokens transfer via performing \ref transfer.
       \ingroup point_events
@@ -18,7 +18,7 @@
  * \note
  * Safe locking operations do not affect “frozen” funds.
 
- * Smart contract supports the following operations applicable to the safe: [enablesafe][1], [disablesafe][2], [unlocksafe][3], [locksafe][4], [modifysafe][5], [applysafemod][6], [cancelsafemod][7], [globallock][8]. 
+ * Smart contract supports the following operations applicable to the safe: [enablesafe][1], [disablesafe][2], [unlocksafe][3], [locksafe][4], [modifysafe][5], [applysafemod][6], [cancelsafemod][7], [globallock][8], [applyready][9], [sweepmods][10]. 
 
  * At first, a safe owner should enable his/her safe via calling [enablesafe][1]. This action allows the owner to set initial amount of unlocked points in the safe (\a unlock parameter). Later the owner can call [unlocksafe][3] to increase unlocked amount.
 
@@ -55,6 +55,8 @@
 
  * Active global lock also prevents users from applying delayed \a mods without a trusted signature.
 
+ * All ready \a mods of an account can be applied at once with [applyready][9]. \a Mods that can no longer be applied (the safe is disabled or the \a mod is not applied for a long time after it became ready) can be removed by anyone with [sweepmods][10], which only frees their storage.
+
  * [1]: @ref commun::point::enablesafe
  * [2]: @ref commun::point::disablesafe
  * [3]: @ref commun::point::unlocksafe
@@ -63,6 +65,8 @@
  * [6]: @ref commun::point::applysafemod
  * [7]: @ref commun::point::cancelsafemod
  * [8]: @ref commun::point::globallock
+ * [9]: @ref commun::point::applyready
+ * [10]: @ref commun::point::sweepmods
  */
 
 /**
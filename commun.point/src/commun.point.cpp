@@ -4,7 +4,7 @@
  */
 
 #include "commun.point/commun.point.hpp"
-#include <commun.gallery/commun.gallery.hpp>
+#include <commun.gallery/objects.hpp>
 #include <commun/dispatchers.hpp>
 #include <cyber.token/cyber.token.hpp>
 #include <eosio/event.hpp>
@@ -83,7 +83,8 @@ void point::create(name issuer, asset initial_supply, asset maximum_supply, int1
 }
 
 #define SET_PARAM(PARAM) if (PARAM && (p.PARAM != *PARAM)) { p.PARAM = *PARAM; _empty = false; }
-void point::setparams(symbol_code commun_code, std::optional<uint16_t> fee, std::optional<uint16_t> transfer_fee, std::optional<int64_t> min_transfer_fee_points) {
+void point::setparams(symbol_code commun_code, std::optional<uint16_t> fee, std::optional<uint16_t> transfer_fee, std::optional<int64_t> min_transfer_fee_points,
+                      std::optional<bool> batch_exchange) {
     params params_table(_self, _self.value);
     const auto& param = params_table.get(commun_code.raw(), "symbol does not exist");
     require_auth(param.issuer);
@@ -97,6 +98,10 @@ void point::setparams(symbol_code commun_code, std::optional<uint16_t> fee, std:
         SET_PARAM(fee);
         SET_PARAM(transfer_fee);
         SET_PARAM(min_transfer_fee_points);
+        if (batch_exchange && (p.batch_exchange.value_or() != *batch_exchange)) {
+            p.batch_exchange = *batch_exchange;
+            _empty = false;
+        }
         eosio::check(!_empty, "No params changed");
         check(!p.transfer_fee || p.min_transfer_fee_points > 0, "min_transfer_fee_points cannot be 0 if transfer_fee set");
     });
@@ -107,7 +112,9 @@ void point::setfreezer(name freezer) {
     require_auth(_self);
     eosio::check(is_account(freezer), "freezer account does not exist");
     auto global_param = global_params(_self, _self.value);
-    global_param.set({ .point_freezer = freezer }, _self);
+    auto p = global_param.get_or_default();
+    p.point_freezer = freezer;
+    global_param.set(p, _self);
 }
 
 void point::issue(name to, asset quantity, string memo) {
@@ -145,6 +152,36 @@ void point::issue(name to, asset quantity, string memo) {
     }
 }
 
+void point::mintto(name receiver, asset quantity) {
+    require_auth(_self);
+    check(is_account(receiver), "receiver account does not exist");
+
+    auto commun_symbol = quantity.symbol;
+    check(commun_symbol.is_valid(), "invalid symbol name");
+    symbol_code commun_code = commun_symbol.code();
+
+    params params_table(_self, _self.value);
+    const auto& param = params_table.get(commun_code.raw(), "point with symbol does not exist");
+
+    stats stats_table(_self, commun_code.raw());
+    const auto& stat = stats_table.get(commun_code.raw(), "SYSTEM: point with symbol does not exist");
+
+    check(stat.reserve.amount > 0, "no reserve");
+    check(quantity.is_valid(), "invalid quantity");
+    check(quantity.amount > 0, "must issue positive quantity");
+
+    check(quantity.symbol == stat.supply.symbol, "symbol precision mismatch");
+    check(quantity.amount <= param.max_supply.amount - stat.supply.amount, "quantity exceeds available supply");
+
+    stats_table.modify(stat, same_payer, [&](auto& s) {
+        s.supply += quantity;
+        send_currency_event(s, param);
+    });
+
+    add_balance(receiver, quantity, _self);
+    require_recipient(receiver);
+}
+
 void point::retire(name from, asset quantity, string memo) {
     auto commun_symbol = quantity.symbol;
     check(commun_symbol.is_valid(), "invalid symbol name");
@@ -204,10 +241,18 @@ void point::on_reserve_transfer(name from, name to, asset quantity, std::string
         
         stats stats_table(_self, commun_code.raw());
         auto& stat = stats_table.get(commun_code.raw(), "SYSTEM: point with symbol does not exist");
+
+        if (param.batch_exchange.value_or() && !restock) {
+            check(math::sub_fee(quantity.amount, param.fee) > 0, "the entire amount is spent on fee");
+            check(!min_order || min_order->symbol == stat.supply.symbol, "symbol precision mismatch");
+            check(balance_exists(from, commun_code), "balance of from not opened");
+            queue_order(from, commun_code, quantity, min_order.value_or(asset(0, stat.supply.symbol)));
+            return;
+        }
         
         if (param.fee) {
             auto initial = quantity.amount;
-            quantity.amount = safe_pct(quantity.amount, config::_100percent - param.fee);
+            quantity.amount = math::sub_fee(quantity.amount, param.fee);
             check(quantity.amount > 0, "the entire amount is spent on fee");
             burn_the_fee(asset(initial - quantity.amount, stat.reserve.symbol), commun_code, true);
         }
@@ -255,10 +300,10 @@ void point::sub_balance(name owner, asset value) {
     const auto& from = accounts_table.get(scode, "no balance object found");
 
     auto avail_balance = from.balance.amount;
-    auto global_param = global_params(_self, _self.value);
-    auto point_freezer = global_param.get_or_default().point_freezer;
+    auto global_param = global_params(_self, _self.value).get_or_default();
+    auto point_freezer = global_param.point_freezer;
     if (point_freezer) {
-        avail_balance -= gallery::get_frozen_amount(point_freezer, owner, value.symbol.code());
+        avail_balance -= gallery_types::get_frozen_amount(point_freezer, owner, value.symbol.code());
     }
     check(avail_balance >= value.amount, "overdrawn balance");
 
@@ -267,14 +312,25 @@ void point::sub_balance(name owner, asset value) {
         send_balance_event(owner, a);
     });
 
-    check(!is_locked(owner), "balance locked in safe");
-    safe_tbl safes(_self, owner.value);
-    const auto& safe = safes.find(scode);
-    if (safe != safes.end()) {
-        safes.modify(safe, owner, [&](auto& s) {
-            s.unlocked -= value;
-            check(s.unlocked.amount >= 0, "overdrawn safe unlocked balance");
-        });
+    // The guard row holds both the global lock and the number of safes, so an owner without them costs a single lookup.
+    // The safe table is still read when the count is unknown: the rows written before the counter have no count,
+    // and an owner without the row can have old safes until all of them are counted (see safescounted)
+    lock_singleton guard(_self, owner.value);
+    bool may_have_safes = !global_param.safes_counted.value_or();
+    if (guard.exists()) {
+        const auto g = guard.get();
+        check(!is_active(g), "balance locked in safe");
+        may_have_safes = !g.safes.has_value() || g.safes.value() > 0;
+    }
+    if (may_have_safes) {
+        safe_tbl safes(_self, owner.value);
+        const auto& safe = safes.find(scode);
+        if (safe != safes.end()) {
+            safes.modify(safe, owner, [&](auto& s) {
+                s.unlocked -= value;
+                check(s.unlocked.amount >= 0, "overdrawn safe unlocked balance");
+            });
+        }
     }
 
     notify_balance_change(owner, -value);
@@ -378,6 +434,13 @@ void point::do_transfer(name from, name to, const asset &quantity, const string
     else {
         auto min_order = get_min_order(memo);
 
+        if (param.batch_exchange.value_or()) {
+            check(!min_order || min_order->symbol == config::reserve_token, "invalid reserve token symbol");
+            sub_balance(from, quantity);
+            queue_order(from, commun_code, quantity, min_order.value_or(asset(0, config::reserve_token)));
+            return;
+        }
+
         sub_balance(from, quantity);
 
         asset fee_quantity(0, config::reserve_token);
@@ -408,6 +471,178 @@ void point::burn_the_fee(const asset& quantity, symbol_code commun_code, bool bu
     send_fee_event(quantity);
 }
 
+////////////////////////////////////////////////////////////////
+// batch exchange
+
+void point::queue_order(name owner, symbol_code commun_code, asset quantity, asset min_order) {
+    orders orders_table(_self, commun_code.raw());
+    orders_table.emplace(owner, [&](auto& o) { o = {
+        .id = orders_table.available_primary_key(),
+        .owner = owner,
+        .quantity = quantity,
+        .min_order = min_order
+    };});
+}
+
+// Returns points issued for the not rejected orders.
+// The average price of a bigger purchase is higher, so rejecting orders can't break the minimums of the rest.
+int64_t point::fill_buy_orders(const structures::param_struct& param, const structures::stat_struct& stat, std::vector<batch_order>& batch) {
+    for (;;) {
+        int64_t net_sum = 0;
+        for (const auto& o : batch) {
+            net_sum += o.rejected ? 0 : o.net;
+        }
+        if (!net_sum) {
+            return 0;
+        }
+        int64_t tokens = 0;
+        if (stat.reserve.amount > 0) {
+            double new_supply = math::bancor_supply_after_buy(stat.reserve.amount, stat.supply.amount, get_cw(param), net_sum);
+            if (math::bancor_supply_fits(new_supply)) {
+                tokens = static_cast<int64_t>(new_supply) - stat.supply.amount;
+            }
+        }
+        if (tokens > param.max_supply.amount - stat.supply.amount) {
+            tokens = 0;
+        }
+        bool rejected = false;
+        int64_t ret = 0;
+        for (auto& o : batch) {
+            if (o.rejected) {
+                continue;
+            }
+            o.result = math::prop(tokens, o.net, net_sum);
+            if (o.result <= 0 || o.result < o.min) {
+                o.result = 0;
+                o.rejected = rejected = true;
+            }
+            ret += o.result;
+        }
+        if (!rejected) {
+            return ret;
+        }
+    }
+}
+
+// Returns CMN tokens paid for the not rejected orders, fee is set to the fee of the sale.
+// The average price of a bigger sale is lower, so rejecting orders can't break the minimums of the rest.
+int64_t point::fill_sell_orders(const structures::param_struct& param, const structures::stat_struct& stat, std::vector<batch_order>& batch,
+                                int64_t& fee) {
+    for (;;) {
+        fee = 0;
+        int64_t points_sum = 0;
+        for (const auto& o : batch) {
+            points_sum += o.rejected ? 0 : o.amount;
+        }
+        if (!points_sum) {
+            return 0;
+        }
+        check(points_sum <= stat.supply.amount, "SYSTEM: queued points exceed supply");
+        auto initial = math::bancor_sell(stat.reserve.amount, stat.supply.amount, param.cw, points_sum);
+        auto net = math::sub_fee(initial, param.fee);
+        bool rejected = false;
+        int64_t ret = 0;
+        for (auto& o : batch) {
+            if (o.rejected) {
+                continue;
+            }
+            o.result = math::prop(net, o.amount, points_sum);
+            if (o.result <= 0 || o.result < o.min) {
+                o.result = 0;
+                o.rejected = rejected = true;
+            }
+            ret += o.result;
+        }
+        if (!rejected) {
+            fee = initial - net;
+            return ret;
+        }
+    }
+}
+
+void point::settle(symbol_code commun_code, uint16_t max_orders) {
+    check(max_orders > 0, "max_orders must be positive");
+
+    params params_table(_self, _self.value);
+    const auto& param = params_table.get(commun_code.raw(), "point with symbol does not exist");
+    stats stats_table(_self, commun_code.raw());
+    const auto& stat = stats_table.get(commun_code.raw(), "SYSTEM: point with symbol does not exist");
+
+    std::vector<batch_order> buys;
+    std::vector<batch_order> sells;
+    orders orders_table(_self, commun_code.raw());
+    for (auto itr = orders_table.begin(); itr != orders_table.end() && buys.size() + sells.size() < max_orders;) {
+        auto amount = itr->quantity.amount;
+        if (itr->buying()) {
+            buys.push_back({itr->owner, amount, math::sub_fee(amount, param.fee), itr->min_order.amount});
+        } else {
+            sells.push_back({itr->owner, amount, amount, itr->min_order.amount});
+        }
+        itr = orders_table.erase(itr);
+    }
+    check(!buys.empty() || !sells.empty(), "no orders to settle");
+
+    auto bought = fill_buy_orders(param, stat, buys);
+    int64_t buy_amount = 0;
+    int64_t buy_net = 0;
+    for (const auto& o : buys) {
+        buy_amount += o.rejected ? 0 : o.amount;
+        buy_net += o.rejected ? 0 : o.net;
+    }
+
+    auto after_buys = stat;
+    after_buys.supply.amount += bought;
+    after_buys.reserve.amount += buy_net;
+    int64_t sell_fee = 0;
+    auto sold_for = fill_sell_orders(param, after_buys, sells, sell_fee);
+    int64_t points_sold = 0;
+    for (const auto& o : sells) {
+        points_sold += o.rejected ? 0 : o.amount;
+    }
+
+    auto reserve_diff = buy_net - sold_for - sell_fee;
+    stats_table.modify(stat, same_payer, [&](auto& s) {
+        s.supply.amount += bought - points_sold;
+        s.reserve.amount += reserve_diff;
+        send_currency_event(s, param);
+    });
+
+    auto commun_symbol = stat.supply.symbol;
+    for (const auto& o : buys) {
+        if (o.rejected) {
+            INLINE_ACTION_SENDER(eosio::token, transfer)(config::token_name, {_self, config::active_name},
+                {_self, o.owner, asset(o.amount, config::reserve_token), commun_code.to_string() + " order returned"});
+        } else {
+            add_balance(o.owner, asset(o.result, commun_symbol), _self);
+        }
+    }
+    if (buy_amount > buy_net) {
+        burn_the_fee(asset(buy_amount - buy_net, config::reserve_token), commun_code, true);
+    }
+    if (bought) {
+        send_exchange_event(asset(bought, commun_symbol));
+    }
+
+    for (const auto& o : sells) {
+        if (o.rejected) {
+            add_balance(o.owner, asset(o.amount, commun_symbol), _self);
+        } else {
+            INLINE_ACTION_SENDER(eosio::token, transfer)(config::token_name, {_self, config::active_name},
+                {_self, o.owner, asset(o.result, config::reserve_token), commun_code.to_string() + " sold"});
+        }
+    }
+    if (sell_fee) {
+        burn_the_fee(asset(sell_fee, config::reserve_token), commun_code, false);
+    }
+    if (sold_for) {
+        send_exchange_event(asset(sold_for, config::reserve_token));
+    }
+
+    if (reserve_diff) {
+        notify_balance_change(param.issuer, vague_asset(reserve_diff));
+    }
+}
+
 ////////////////////////////////////////////////////////////////
 // safe related actions
 using std::optional;
@@ -449,16 +684,19 @@ void point::enablesafe(name owner, asset unlock, uint32_t delay, name trusted) {
         s.delay = delay;
         s.trusted = trusted;
     });
+    update_safes_count(owner, owner);
 }
 
 
+// returns true if the safe was disabled
 template<typename Tbl, typename S>
-void instant_safe_change(Tbl& safes, S& safe,
+bool instant_safe_change(Tbl& safes, S& safe,
     name owner, share_type unlock, optional<uint32_t> delay, optional<name> trusted, bool ensure_change
 ) {
     if (delay && *delay == 0) {
         check(!unlock && !trusted, "SYS: incorrect disabling safe mod");
         safes.erase(safe);
+        return true;
     } else {
         bool changed = !ensure_change;
         safes.modify(safe, owner, [&](auto& s) {
@@ -478,6 +716,7 @@ void instant_safe_change(Tbl& safes, S& safe,
             check(changed, "Change has no effect and can be cancelled");
         });
     }
+    return false;
 }
 
 // helper for actions which do not change `unlocked` and have incomplete asset symbol
@@ -510,7 +749,9 @@ void point::delay_safe_change(
         check(!have_id, "mod_id must be empty for trusted action");
         check(!delay || *delay != safe.delay, "Can't set same delay");
         check(!trusted || *trusted != trusted_acc, "Can't set same trusted");
-        instant_safe_change(safes, safe, owner, unlock.amount, delay, trusted, false);
+        if (instant_safe_change(safes, safe, owner, unlock.amount, delay, trusted, false)) {
+            update_safes_count(owner, owner);
+        }
     } else {
         check(have_id, "mod_id must not be empty");
         safemod_tbl mods(_self, owner.value);
@@ -575,7 +816,9 @@ void point::applysafemod(name owner, name mod_id) {
         check(mod.date <= eosio::current_time_point(), "Safe change is time locked");
         check(!is_locked(owner), "Safe locked globally");
     }
-    instant_safe_change(safes, safe, owner, mod.unlock, mod.delay, mod.trusted, true);
+    if (instant_safe_change(safes, safe, owner, mod.unlock, mod.delay, mod.trusted, true)) {
+        update_safes_count(owner, owner);
+    }
     mods.erase(mod);
 }
 
@@ -586,6 +829,55 @@ void point::cancelsafemod(name owner, name mod_id) {
     mods.erase(mod);
 }
 
+void point::applyready(name owner, uint16_t max) {
+    require_auth(owner);
+    check(max > 0, "max must be positive");
+    check(!is_locked(owner), "Safe locked globally");
+
+    safemod_tbl mods(_self, owner.value);
+    safe_tbl safes(_self, owner.value);
+    auto idx = mods.get_index<"bydate"_n>();  // ready mods come first, in the order they became ready
+    const auto now = eosio::current_time_point();
+    uint16_t done = 0;
+    for (auto itr = idx.begin(); itr != idx.end() && itr->date <= now && max; max--) {
+        auto safe = safes.find(itr->commun_code.raw());
+        if (safe != safes.end()) {
+            // mods of one safe can compensate each other, so a single mod is allowed to change nothing here
+            if (instant_safe_change(safes, safe, owner, itr->unlock, itr->delay, itr->trusted, false)) {
+                update_safes_count(owner, owner);
+            }
+        }
+        itr = idx.erase(itr);
+        done++;
+    }
+    check(done > 0, "No ready safe mods");
+}
+
+void point::sweepmods(name owner, uint16_t max) {
+    check(max > 0, "max must be positive");
+
+    safemod_tbl mods(_self, owner.value);
+    safe_tbl safes(_self, owner.value);
+    auto idx = mods.get_index<"bysymbolcode"_n>();
+    const auto expired = eosio::current_time_point() - eosio::seconds(config::safe_mod_expiry);
+    uint16_t removed = 0;
+    symbol_code scode;  // mods are ordered by symbol code, so the safe is looked up once per symbol
+    bool have_safe = false;
+    for (auto itr = idx.begin(); itr != idx.end() && max; max--) {
+        if (itr->commun_code != scode) {
+            scode = itr->commun_code;
+            have_safe = safes.find(scode.raw()) != safes.end();
+        }
+        if (!have_safe || itr->date < expired) {
+            itr = idx.erase(itr);
+            removed++;
+        } else {
+            ++itr;
+        }
+    }
+    check(removed > 0, "Nothing to sweep");
+}
+
 void point::globallock(name owner, uint32_t period) {
     require_auth(owner);
     check(period > 0, "period must be > 0");
@@ -593,9 +885,58 @@ void point::globallock(name owner, uint32_t period) {
 
     time_point_sec unlocks{eosio::current_time_point() + eosio::seconds(period)};
     lock_singleton lock(_self, owner.value);
-    check(unlocks > lock.get_or_default().unlocks, "new unlock time must be greater than current");
+    auto guard = lock.get_or_default();
+    check(unlocks > guard.unlocks, "new unlock time must be greater than current");
+
+    guard.unlocks = unlocks;
+    lock.set(guard, owner);
+}
+
+void point::recountsafes(name owner, std::optional<name> ram_payer) {
+    auto actual_ram_payer = ram_payer.value_or(owner);
+    require_auth(actual_ram_payer);
+
+    lock_singleton lock(_self, owner.value);
+    auto count = count_safes(owner);
+    bool counted = !count;
+    if (lock.exists()) {
+        const auto g = lock.get();
+        counted = g.safes.has_value() && g.safes.value() == count;
+    }
+    check(!counted, "Safes count is up to date");
+    update_safes_count(owner, actual_ram_payer);
+}
+
+void point::safescounted() {
+    require_auth(_self);
+    auto global_param = global_params(_self, _self.value);
+    auto p = global_param.get_or_default();
+    check(!p.safes_counted.value_or(), "Safes are already counted");
+    p.safes_counted = true;
+    global_param.set(p, _self);
+}
 
-    lock.set({unlocks}, owner);
+uint16_t point::count_safes(name owner) {
+    safe_tbl safes(_self, owner.value);
+    uint16_t count = 0;
+    for (auto itr = safes.begin(); itr != safes.end(); ++itr) {
+        count++;
+    }
+    return count;
+}
+
+// the safes are recounted instead of incrementing the counter, so a change of an uncounted owner sets the right number
+void point::update_safes_count(name owner, name payer) {
+    lock_singleton lock(_self, owner.value);
+    auto guard = lock.get_or_default();
+    guard.safes = count_safes(owner);
+    if (!guard.safes.value() && !is_active(guard)) {
+        if (lock.exists()) {
+            lock.remove();
+        }
+    } else {
+        lock.set(guard, payer);
+    }
 }
 
 } /// namespace commun
@@ -1,6 +1,7 @@
 #pragma once
 #include <commun.publication/objects.hpp>
 #include <eosio/transaction.hpp>
+#include <eosio/event.hpp>
 #include <commun/dispatchers.hpp>
 
 namespace commun {
@@ -20,24 +21,67 @@ publication : public gallery_base<publication>, public contract {
 public:
     using contract::contract;
     
-    static bool can_remove_vertex(const vertex_struct& arg, const gallery_types::mosaic_struct& mosaic, const structures::community& community) {
+    static bool has_comments(const vertices& vertices_table, uint64_t tracery) {
+        auto idx = vertices_table.get_index<"byparent"_n>();
+        auto itr = idx.lower_bound(std::make_tuple(tracery, uint64_t(0)));
+        return itr != idx.end() && itr->parent_tracery == tracery;
+    }
+
+    static bool can_remove_vertex(const vertices& vertices_table, const vertex_struct& arg,
+        const gallery_types::mosaic_struct& mosaic, const structures::community& community
+    ) {
         auto now = eosio::current_time_point();
-        return arg.childcount == 0
+        return !has_comments(vertices_table, arg.tracery)
             || now > (mosaic.collection_end_date + eosio::seconds(community.moderation_period + community.extra_reward_period));
     }
 
+    static void add_reply(name self, symbol_code commun_code, uint64_t parent_tracery, int8_t diff, name payer) {
+        replies replies_table(self, commun_code.raw());
+        replies_table.emplace(payer, [&](auto& item) { item = reply_struct{
+            .id = replies_table.available_primary_key(),
+            .parent_tracery = parent_tracery,
+            .diff = diff
+        };});
+    }
+
+    // folds the oldest changes of comments counts, each vertex is modified once
+    static size_t fold_replies(name self, symbol_code commun_code, size_t max_steps) {
+        replies replies_table(self, commun_code.raw());
+        std::map<uint64_t, int64_t> diffs;
+        size_t folded = 0;
+        for (auto itr = replies_table.begin(); itr != replies_table.end() && folded < max_steps; folded++) {
+            diffs[itr->parent_tracery] += itr->diff;
+            itr = replies_table.erase(itr);
+        }
+
+        vertices vertices_table(self, commun_code.raw());
+        for (const auto& d : diffs) {
+            auto vertex = vertices_table.find(d.first);
+            if (!d.second || vertex == vertices_table.end()) {
+                continue;   // the parent can be removed after its active period
+            }
+            eosio::check(vertex->childcount + d.second >= 0, "SYSTEM: negative childcount");
+            vertices_table.modify(vertex, eosio::same_payer, [&](auto& item) { item.childcount += d.second; });
+        }
+        return folded;
+    }
+
+    static void archive_vertex(name self, symbol_code commun_code, const vertex_struct& vertex) {
+        vertex_archive_event event{commun_code, vertex.tracery, vertex.parent_tracery, vertex.level};
+        eosio::event(self, "vertexarch"_n, event).send();
+    }
+
     static void deactivate(name self, symbol_code commun_code, const gallery_types::mosaic_struct& mosaic) {
         vertices vertices_table(self, commun_code.raw());
         auto vertex = vertices_table.find(mosaic.tracery);
         eosio::check(vertex != vertices_table.end(), "SYSTEM: Permlink doesn't exist.");
-        eosio::check(can_remove_vertex(*vertex, mosaic, commun_list::get_community(commun_code)), "comment with child comments can't be removed during the active period");
+        eosio::check(can_remove_vertex(vertices_table, *vertex, mosaic, commun_list::get_community(commun_code)), "comment with child comments can't be removed during the active period");
 
-        if (vertex->parent_tracery) {
-            auto parent_vertex = vertices_table.find(vertex->parent_tracery);
-            if (parent_vertex != vertices_table.end()) {
-                vertices_table.modify(parent_vertex, eosio::same_payer, [&](auto& item) { item.childcount--; });
-            }
+        // a removed parent isn't counted any more, so no change is written for it
+        if (vertex->parent_tracery && vertices_table.find(vertex->parent_tracery) != vertices_table.end()) {
+            add_reply(self, commun_code, vertex->parent_tracery, -1, eosio::has_auth(mosaic.creator) ? mosaic.creator : self);
         }
+        archive_vertex(self, commun_code, *vertex);
         vertices_table.erase(*vertex);
     }
 
@@ -273,6 +317,18 @@ public:
     */
     [[eosio::action]] void claim(symbol_code commun_code, mssgid message_id, name gem_owner,
         std::optional<name> gem_creator, std::optional<bool> eager);
+
+    /**
+        \brief The \ref claimall action chops all gems of a user that are ready to be claimed. Points «frozen» in these gems are returned with one update of the user inclusion and rewards are paid with one transfer.
+
+        \param commun_code community symbol, same as point symbol
+        \param gem_owner account who owns the gems
+        \param max_gems maximum number of gems to be processed by the action
+
+        Gems are processed in order of their claim dates. A gem whose message is still under moderation (for example, the message was locked) gets a new claim date and is skipped.
+        \nosignreq
+    */
+    [[eosio::action]] void claimall(symbol_code commun_code, name gem_owner, uint16_t max_gems);
     // TODO: removed from MVP
     void hold(symbol_code commun_code, mssgid message_id, name gem_owner, std::optional<name> gem_creator);
     // TODO: removed from MVP
@@ -323,6 +379,8 @@ public:
     void provide(name grantor, name recipient, asset quantity, std::optional<uint16_t> fee);
     // TODO: removed from MVP
     void advise(symbol_code commun_code, name leader, std::set<mssgid> favorites);
+    // TODO: removed from MVP
+    void advisemany(name leader, std::vector<advice_batch_item> advices);
     //TODO: void checkadvice (symbol_code commun_code, name leader);
 
     /**
@@ -338,10 +396,49 @@ public:
     */
     [[eosio::action]] void ban(symbol_code commun_code, mssgid message_id);
 
+    /**
+        \brief The \ref deactmosaics action moves messages whose collection or moderation period is over to the next state. Messages are processed in order of their collection end dates.
+
+        \param commun_code community symbol, same as point symbol
+        \param max_steps maximum number of messages to be processed by the action
+
+        The same work is done (with a small fixed budget) by votes and message creation. This action allows to clear a backlog without loading user transactions. It fails if there is nothing to process.
+        \nosignreq
+    */
+    [[eosio::action]] void deactmosaics(symbol_code commun_code, uint16_t max_steps);
+
+    /**
+        \brief The \ref schedgems action adds messages votes (gems) created before the gem buckets to the buckets, so forced chopping finds them. Gems are processed in order of their identifiers, the position is kept in the gallery \a stat.
+
+        \param commun_code community symbol, same as point symbol
+        \param payer account paying for the bucket rows
+        \param max_gems maximum number of gems to be processed by the action
+
+        It fails if all gems are already added. Gems created later are added to the buckets on creation.
+        \signreq
+            — the \a payer account .
+    */
+    [[eosio::action]] void schedgems(symbol_code commun_code, name payer, uint16_t max_gems);
+
+    /**
+        \brief The \ref foldreplies action adds the changes of comments count accumulated in \a reply table to \a childcount of message vertices. Changes are processed in order they were made.
+
+        \param commun_code community symbol, same as point symbol
+        \param max_steps maximum number of changes to be processed by the action
+
+        Each vertex is modified once per call, however many changes it has. \ref create and \ref remove also fold a few oldest changes, so \a childcount of a vertex lags behind the number of its comments until its changes are folded. The action fails if there is nothing to process.
+        \nosignreq
+    */
+    [[eosio::action]] void foldreplies(symbol_code commun_code, uint16_t max_steps);
+
     ON_TRANSFER(COMMUN_POINT) void ontransfer(name from, name to, asset quantity, std::string memo) {
         on_points_transfer(_self, from, to, quantity, memo);
     }
 
+    ON_MINT(COMMUN_POINT) void onmint(name receiver, asset quantity) {
+        on_points_transfer(_self, config::point_name, receiver, quantity, std::string());
+    }
+
 private:
     gallery_types::providers_t get_providers(symbol_code commun_code, name account, uint16_t gems_per_period, std::optional<uint16_t> weight);
     accparams::const_iterator get_acc_param(accparams& accparams_table, symbol_code commun_code, name account);
@@ -7,4 +7,6 @@ const uint16_t max_length = 256;
 
 const uint16_t max_comment_depth = 127;
 
+const uint16_t auto_fold_replies = 4; // changes of comments counts folded by each create and remove
+
 }} // commun::config
@@ -37,6 +37,11 @@ struct mssgid {
     }
 };
 
+struct advice_batch_item {
+    symbol_code commun_code;
+    std::set<mssgid> favorites;
+};
+
 /**
  * \brief The structure represents a vertex table in DB.
  * \ingroup gallery_tables
@@ -47,9 +52,38 @@ struct vertex_struct {
     uint64_t tracery;  //!< Message mosaic's tracery using as the primary key
     uint64_t parent_tracery;  //!< Mosaic's tracery of the parent message
     uint16_t level; //!< Nesting level of the message(a post is assigned the zero level, comments are assigned levels from one onwards)
-    uint32_t childcount; //!< Count of comments of the same level under the message
+    uint32_t childcount; //!< Count of comments of the same level under the message; it lags behind until the changes in \a reply table are folded
 
     uint64_t primary_key() const { return tracery; }
+    using parent_key_t = std::tuple<uint64_t, uint64_t>;
+    parent_key_t by_parent() const { return std::make_tuple(parent_tracery, tracery); }
+};
+
+/**
+ * \brief The structure represents a change of the comments count of a message not yet added to its vertex.
+ * \ingroup gallery_tables
+ *
+ * Creating or removing a comment doesn't modify the parent vertex, it adds such record instead, so commenters of a popular message don't write the same row. The records are folded into \a childcount by \ref publication::foldreplies and a few oldest ones by each \ref publication::create and \ref publication::remove, so \a childcount is behind the real count until then. A record is paid by the author of the comment; when the comment is removed by the deactivation of its mosaic in an action the author hasn't signed, the contract pays.
+ */
+struct reply_struct {
+    uint64_t id;
+    uint64_t parent_tracery; //!< Mosaic's tracery of the parent message
+    int8_t diff;             //!< Change of the comments count: 1 for a created comment, -1 for a removed one
+
+    uint64_t primary_key() const { return id; }
+};
+
+/**
+ * \brief The structure represents an event about a vertex removed from \a vertex table.
+ * \ingroup gallery_events
+ *
+ * A vertex is removed when its mosaic is archived or chopped. The contract keeps nothing about removed vertices, the hierarchy of old messages is kept off-chain from these events.
+ */
+struct [[using eosio: event("vertexarch"), contract("commun.publication")]] vertex_archive_event {
+    symbol_code commun_code; //!< Point symbol
+    uint64_t tracery;        //!< Message mosaic's tracery
+    uint64_t parent_tracery; //!< Mosaic's tracery of the parent message
+    uint16_t level;          //!< Nesting level of the message
 };
 
 struct acc_param {
@@ -60,7 +94,10 @@ struct acc_param {
 
 using namespace eosio;
 
-using vertices [[using eosio: scope_type("symbol_code"), order("tracery","asc"), contract("commun.publication")]] = eosio::multi_index<"vertex"_n, vertex_struct>;
+using vertex_parent_index [[using eosio: order("parent_tracery","asc"), order("tracery","asc")]] =
+    eosio::indexed_by<"byparent"_n, eosio::const_mem_fun<vertex_struct, vertex_struct::parent_key_t, &vertex_struct::by_parent>>;
+using vertices [[using eosio: scope_type("symbol_code"), order("tracery","asc"), contract("commun.publication")]] = eosio::multi_index<"vertex"_n, vertex_struct, vertex_parent_index>;
+using replies [[using eosio: scope_type("symbol_code"), order("id","asc"), contract("commun.publication")]] = eosio::multi_index<"reply"_n, reply_struct>;
 using accparams [[using eosio: scope_type("symbol_code"), order("account","asc"), contract("commun.publication")]] = eosio::multi_index<"accparam"_n, acc_param>;
 
 } // commun
@@ -39,6 +39,7 @@ void publication::create(
     eosio::check(header.length() < config::max_length, "Title length is more than 256.");
     eosio::check(body.length(), "Body is empty.");
 
+    fold_replies(_self, commun_code, config::auto_fold_replies);
     vertices vertices_table(_self, commun_code.raw());
     auto tracery = message_id.tracery();
     eosio::check(vertices_table.find(tracery) == vertices_table.end(), "This message already exists.");
@@ -50,9 +51,7 @@ void publication::create(
         parent_tracery = parent_id.tracery();
         auto parent_vertex = vertices_table.find(parent_tracery);
         if (parent_vertex != vertices_table.end()) {
-            vertices_table.modify(parent_vertex, eosio::same_payer, [&](auto& item) {
-                ++item.childcount;
-            });
+            add_reply(_self, commun_code, parent_tracery, 1, message_id.author);
             level = 1 + parent_vertex->level;
             
             gallery_types::mosaics mosaics_table(_self, commun_code.raw());
@@ -122,9 +121,10 @@ void publication::remove(symbol_code commun_code, mssgid message_id) {
         auto mosaic = mosaics_table.find(tracery);
         eosio::check(mosaic == mosaics_table.end() || !mosaic->hidden(), "Message already removed.");
         
+        fold_replies(_self, commun_code, config::auto_fold_replies);
         vertices vertices_table(_self, commun_code.raw());
         bool removed = false;
-        if (can_remove_vertex(vertices_table.get(tracery), mosaics_table.get(tracery), commun_list::get_community(commun_code))) {
+        if (can_remove_vertex(vertices_table, vertices_table.get(tracery), mosaics_table.get(tracery), commun_list::get_community(commun_code))) {
             claim_gems_by_creator(_self, tracery, commun_code, message_id.author, true);
             removed = mosaics_table.find(tracery) == mosaics_table.end();
         }
@@ -203,6 +203,10 @@ void publication::claim(symbol_code commun_code, mssgid message_id, name gem_own
     claim_gem(_self, message_id.tracery(), commun_code, gem_owner, gem_creator.value_or(gem_owner), eager.value_or(false));
 }
 
+void publication::claimall(symbol_code commun_code, name gem_owner, uint16_t max_gems) {
+    claim_all(_self, commun_code, gem_owner, max_gems);
+}
+
 void publication::set_vote(symbol_code commun_code, name voter, const mssgid& message_id, std::optional<uint16_t> weight, bool damn) {
     eosio::check(voter != message_id.author, "author can't vote");
     if (weight.has_value() && *weight == 0) {
@@ -323,16 +327,16 @@ gallery_types::providers_t publication::get_providers(symbol_code commun_code, n
                                                       uint16_t gems_per_period, std::optional<uint16_t> weight) {
     accparams accparams_table(_self, commun_code.raw());
     auto acc_param = get_acc_param(accparams_table, commun_code, account);
-    gallery_types::provs provs_table(_self, commun_code.raw());
+    gallery_types::provider_pools pools_table(_self, commun_code.raw());
     gallery_types::providers_t ret;
-    auto provs_index = provs_table.get_index<"bykey"_n>();
     for (size_t n = 0; n < acc_param->providers.size(); n++) {
         auto prov_name = acc_param->providers[n];
-        auto prov_itr = provs_index.find(std::make_tuple(prov_name, account));
-        if (prov_itr != provs_index.end() && point::balance_exists(prov_name, commun_code)) {
+        auto pool_itr = pools_table.find(prov_name.value);
+        auto slice = pool_itr != pools_table.end() ? pool_itr->get_slice(account) : nullptr;
+        if (slice && point::balance_exists(prov_name, commun_code)) {
             auto actual_limit = std::max<int64_t>(
                 0, point::get_balance(prov_name, commun_code).amount - get_frozen_amount(_self, prov_name, commun_code));
-            auto amount = std::min(get_amount_to_freeze(prov_itr->total, prov_itr->frozen, gems_per_period, weight), actual_limit);
+            auto amount = std::min(get_amount_to_freeze(slice->total, slice->frozen, gems_per_period, weight), actual_limit);
             if (amount) {
                 ret.emplace_back(std::make_pair(prov_name, amount));
             }
@@ -353,12 +357,11 @@ void publication::setproviders(symbol_code commun_code, name recipient, std::vec
     require_auth(recipient);
     commun_list::check_community_exists(commun_code);
 
-    gallery_types::provs provs_table(_self, commun_code.raw());
-    auto provs_index = provs_table.get_index<"bykey"_n>();
+    gallery_types::provider_pools pools_table(_self, commun_code.raw());
     for (size_t n = 0; n < providers.size(); n++) {
         auto prov_name = providers[n];
-        auto prov_itr = provs_index.find(std::make_tuple(prov_name, recipient));
-        if (prov_itr == provs_index.end() || !point::balance_exists(prov_name, commun_code)) {
+        auto pool_itr = pools_table.find(prov_name.value);
+        if (pool_itr == pools_table.end() || !pool_itr->get_slice(recipient) || !point::balance_exists(prov_name, commun_code)) {
             providers[n] = name();
         }
     }
@@ -384,9 +387,35 @@ void publication::advise(symbol_code commun_code, name leader, std::set<mssgid>
     advise_mosaics(_self, commun_code, leader, favorite_mosaics);
 }
 
+void publication::advisemany(name leader, std::vector<advice_batch_item> advices) {
+    std::vector<gallery_types::advice_batch_item> mosaic_advices;
+    mosaic_advices.reserve(advices.size());
+    for (const auto& a : advices) {
+        std::set<uint64_t> favorite_mosaics;
+        for (const auto& m : a.favorites) {
+            favorite_mosaics.insert(m.tracery());
+        }
+        mosaic_advices.push_back({a.commun_code, favorite_mosaics});
+    }
+    advise_many(_self, leader, mosaic_advices);
+}
+
 void publication::ban(symbol_code commun_code, mssgid message_id) {
     require_auth(point::get_issuer(commun_code));
     ban_mosaic(_self, commun_code, message_id.tracery());
 }
 
+void publication::deactmosaics(symbol_code commun_code, uint16_t max_steps) {
+    deactivate_mosaics(_self, commun_code, max_steps);
+}
+
+void publication::schedgems(symbol_code commun_code, name payer, uint16_t max_gems) {
+    schedule_old_gems(_self, commun_code, payer, max_gems);
+}
+
+void publication::foldreplies(symbol_code commun_code, uint16_t max_steps) {
+    eosio::check(max_steps > 0, "max_steps must be positive");
+    eosio::check(fold_replies(_self, commun_code, max_steps), "nothing to fold");
+}
+
 } // commun
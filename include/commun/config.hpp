@@ -23,6 +23,8 @@ inline name operator ""_n() {
 using eosio::name;
 #endif
 
+#include <commun/defaults.hpp>
+
 #define CYBER_TOKEN "cyber.token"
 #define COMMUN_POINT "c.point"
 
@@ -55,13 +57,8 @@ static const auto recovery_name = "lead.recover"_n;
 
 static const auto client_permission_name = "clientperm"_n;
 
-// numbers and time
-static constexpr auto _1percent = 100;
-static constexpr auto _100percent = 100 * _1percent;
+// numbers and time, see also defaults.hpp
 static constexpr auto block_interval_ms = 3000;//1000 / 2;
-static constexpr int64_t seconds_per_minute = 60;
-static constexpr int64_t seconds_per_hour = seconds_per_minute * 60;
-static constexpr int64_t seconds_per_day = seconds_per_hour * 24;
 static constexpr int64_t blocks_per_year = int64_t(365)*seconds_per_day*1000/block_interval_ms;
 
 #ifndef UNIT_TEST_ENV
@@ -0,0 +1,51 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// Numbers and default parameters of the communities. The header doesn't depend on the contract environment,
+// so the genesis generator (see tests/genesis) makes the same rows as c.point create and c.list create.
+
+namespace commun { namespace config {
+
+static constexpr auto _1percent = 100;
+static constexpr auto _100percent = 100 * _1percent;
+static constexpr int64_t seconds_per_minute = 60;
+static constexpr int64_t seconds_per_hour = seconds_per_minute * 60;
+static constexpr int64_t seconds_per_day = seconds_per_hour * 24;
+
+// c.point
+static constexpr uint16_t def_transfer_fee = _1percent/10;
+static constexpr int64_t def_min_transfer_fee_points = 1;
+
+// c.list
+static constexpr std::array<int64_t, 10>  advice_weight = 
+    {{10000, 7071, 5774, 5000, 4472, 4082, 3780, 3536, 3333, 3162}}; //sqrt(100000000/k)
+
+static constexpr int64_t def_collection_period = 7 * 24 * 60 * 60;
+static constexpr int64_t def_moderation_period = 3 * 24 * 60 * 60;
+static constexpr int64_t def_extra_reward_period     = 0;
+
+static constexpr uint16_t def_author_percent = 50 * _1percent;
+
+static constexpr uint16_t def_gems_per_day = 10;
+static constexpr uint8_t def_rewarded_mosaic_num = 10;
+static constexpr int64_t def_min_lead_rating = advice_weight[0] + 1;
+
+static constexpr uint16_t def_emission_rate = _1percent * 20;
+static constexpr uint16_t def_leaders_percent = _1percent * 3;
+
+static constexpr int64_t def_reward_mosaics_period = 60 * 60;
+static constexpr int64_t def_reward_leaders_period = 24 * 60 * 60;
+
+static constexpr bool def_damned_gem_reward_enabled = false;
+static constexpr bool def_refill_gem_enabled = false;
+
+static constexpr bool def_custom_gem_size_enabled = false;
+
+static constexpr uint8_t def_comm_leaders_num = 3;
+static constexpr uint8_t def_comm_max_votes = 5;
+
+static constexpr uint8_t def_dapp_leaders_num = 21;
+static constexpr uint8_t def_dapp_max_votes = 30;
+
+}} // commun::config
@@ -20,3 +20,6 @@ extern "C" { \
 
 #undef ON_TRANSFER
 #define ON_TRANSFER(TOKEN) [[eosio::on_notify(TOKEN "::transfer")]]
+
+#undef ON_MINT
+#define ON_MINT(TOKEN) [[eosio::on_notify(TOKEN "::mintto")]]
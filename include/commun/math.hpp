@@ -0,0 +1,204 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// Economic formulas of the commun contracts. The header doesn't depend on the contract environment,
+// so the same code is compiled into the contracts and into host tools (see commun_math in tests/CMakeLists.txt).
+// Arguments are not validated here, the contracts check them before the call.
+
+namespace commun { namespace math {
+
+static constexpr int64_t pct_base = 10000; // the same as config::_100percent
+static constexpr int64_t invalid_quote = -1; // result of a batch quote for invalid arguments
+static constexpr int64_t seconds_per_year = int64_t(365)*24*60*60;
+
+inline int64_t prop(int64_t arg, int64_t numer, int64_t denom) {
+    return !arg || !numer ? 0 : static_cast<int64_t>((static_cast<__int128>(arg) * numer) / denom);
+}
+
+inline int64_t pct(int64_t arg, int64_t total) {
+    return prop(arg, total, pct_base);
+}
+
+inline double cw_to_double(uint16_t cw) {
+    return static_cast<double>(cw) / static_cast<double>(pct_base);
+}
+
+// supply after buying for reserve_amount, current_reserve must be positive; can exceed int64_t
+inline double bancor_supply_after_buy(int64_t current_reserve, int64_t current_supply, double cw, int64_t reserve_amount) {
+    double buy_prop = static_cast<double>(reserve_amount) / static_cast<double>(current_reserve);
+    return static_cast<double>(current_supply) * std::pow(1.0 + buy_prop, cw);
+}
+
+inline bool bancor_supply_fits(double new_supply) {
+    return new_supply <= static_cast<double>(std::numeric_limits<int64_t>::max());
+}
+
+// reserve returned for token_amount before the fee, 0 <= token_amount <= current_supply
+inline int64_t bancor_sell(int64_t current_reserve, int64_t current_supply, uint16_t cw, int64_t token_amount) {
+    if (token_amount == 0) {
+        return 0;
+    }
+    if (token_amount == current_supply) {
+        return current_reserve;
+    }
+    if (cw == pct_base) {
+        return prop(token_amount, current_reserve, current_supply);
+    }
+    double sell_prop = static_cast<double>(token_amount) / static_cast<double>(current_supply);
+    return static_cast<int64_t>(static_cast<double>(current_reserve) * (1.0 - std::pow(1.0 - sell_prop, 1.0 / cw_to_double(cw))));
+}
+
+inline int64_t sub_fee(int64_t amount, uint16_t fee) {
+    return fee ? pct(amount, pct_base - fee) : amount;
+}
+
+// weight of a mosaic in the community top: the grade of its place plus a share of grade_sum proportional to the rating
+inline int64_t comm_grade_weight(int64_t grade, int64_t grade_sum, int64_t comm_rating, int64_t rating_sum) {
+    return grade + prop(grade_sum, comm_rating, rating_sum);
+}
+
+// annual emission rate converted to the continuous one, both in pct_base units
+inline int64_t continuous_rate(int64_t annual_rate) {
+    static constexpr auto real_100percent = static_cast<double>(pct_base);
+    auto real_rate = static_cast<double>(annual_rate);
+    return static_cast<int64_t>(std::log(1.0 + (real_rate / real_100percent)) * real_100percent);
+}
+
+// points issued by c.emit to a receiver taking receiver_percent of the emission for passed_seconds
+inline int64_t emission_amount(int64_t supply, int64_t annual_rate, int64_t passed_seconds, int64_t receiver_percent) {
+    auto cont_emission = pct(supply, continuous_rate(annual_rate));
+    auto period_emission = prop(cont_emission, passed_seconds, seconds_per_year);
+    return pct(period_emission, receiver_percent);
+}
+
+// reward of a chopped gem: positive gems share the reward of a normal mosaic, negative ones — of a banned mosaic
+inline int64_t gem_reward(int64_t mosaic_reward, int64_t mosaic_shares, int64_t damn_shares, int64_t gem_shares,
+                          bool banned, bool damned_reward_enabled) {
+    bool damn = gem_shares < 0;
+    if (damn != banned) {
+        return 0;
+    }
+    if (damn) {
+        return damned_reward_enabled ? prop(mosaic_reward, -gem_shares, damn_shares) : 0;
+    }
+    return prop(mosaic_reward, gem_shares, mosaic_shares);
+}
+
+// part of the leaders reward paid when only active_num of leaders_num places are taken, the rest is retained
+inline int64_t leaders_reward_pool(int64_t reward, size_t active_num, size_t leaders_num) {
+    return prop(reward, static_cast<int64_t>(active_num), static_cast<int64_t>(leaders_num));
+}
+
+// Leaders reward is accumulated per unit of weight, a leader gets weight * (accumulator - checkpoint).
+// The accumulator is unsigned and may wrap around, the difference is still correct.
+using reward_acc_t = unsigned __int128;
+static constexpr reward_acc_t reward_per_weight_scale = 1000000000000000000ull;
+
+// increase of the accumulator when reward is shared by weight_sum, weight_sum must be positive;
+// it is rounded up, so while weight * weight_sum is less than the scale the accrued share of each leader
+// equals prop(reward, weight, weight_sum) of the eager distribution
+inline reward_acc_t reward_per_weight(int64_t reward, uint64_t weight_sum) {
+    return (static_cast<reward_acc_t>(reward) * reward_per_weight_scale + weight_sum - 1) / weight_sum;
+}
+
+// The accumulator is credited with more than the reward by rounding up, in 1/reward_per_weight_scale of a point:
+// reward * scale + reward_per_weight_excess == weight_sum * reward_per_weight. The remainders of the accruals
+// are dropped by rounding down, and once all the shares are accrued they cover the excess,
+// so the remainders without the excesses are a whole number of points.
+
+// added when reward is shared by weight_sum, less than weight_sum
+inline reward_acc_t reward_per_weight_excess(int64_t reward, uint64_t weight_sum) {
+    auto rem = static_cast<reward_acc_t>(reward) * reward_per_weight_scale % weight_sum;
+    return rem ? weight_sum - rem : 0;
+}
+
+// reward accrued to weight since the accumulator was equal to checkpoint
+inline int64_t accrued_reward(uint64_t weight, reward_acc_t acc, reward_acc_t checkpoint) {
+    return static_cast<int64_t>(static_cast<reward_acc_t>(weight) * (acc - checkpoint) / reward_per_weight_scale);
+}
+
+// dropped by accrued_reward
+inline reward_acc_t accrued_remainder(uint64_t weight, reward_acc_t acc, reward_acc_t checkpoint) {
+    return static_cast<reward_acc_t>(weight) * (acc - checkpoint) % reward_per_weight_scale;
+}
+
+// Batch quotes take struct-of-arrays inputs, all arrays have `size` elements.
+
+struct buy_batch {
+    const int64_t* reserve;
+    const int64_t* supply;
+    const uint16_t* cw;
+    const uint16_t* fee;
+    const int64_t* amount;  //!< reserve tokens to spend, including the fee
+    int64_t* tokens;        //!< out: points to get or invalid_quote
+    size_t size;
+};
+
+struct sell_batch {
+    const int64_t* reserve;
+    const int64_t* supply;
+    const uint16_t* cw;
+    const uint16_t* fee;
+    const int64_t* amount;  //!< points to sell
+    int64_t* tokens;        //!< out: reserve tokens to get (after the fee) or invalid_quote
+    int64_t* fees;          //!< out: fee in reserve tokens, may be null
+    size_t size;
+};
+
+// shares of a gem added to a mosaic (c.gallery uses the same formula with config::shares_cw)
+struct shares_batch {
+    double cw;
+    const int64_t* points;  //!< points of the mosaic (or damn points)
+    const int64_t* shares;  //!< shares of the mosaic (or damn shares)
+    const int64_t* amount;  //!< points of the new gem excluding the pledge
+    int64_t* result;        //!< out: shares of the new gem or invalid_quote
+    size_t size;
+};
+
+inline void quote(const buy_batch& b) {
+    for (size_t i = 0; i < b.size; i++) {
+        auto amount = sub_fee(b.amount[i], b.fee[i]);
+        if (b.reserve[i] <= 0 || amount <= 0) {
+            b.tokens[i] = invalid_quote;
+            continue;
+        }
+        double new_supply = bancor_supply_after_buy(b.reserve[i], b.supply[i], cw_to_double(b.cw[i]), amount);
+        b.tokens[i] = bancor_supply_fits(new_supply) ? static_cast<int64_t>(new_supply) - b.supply[i] : invalid_quote;
+    }
+}
+
+inline void quote(const sell_batch& b) {
+    for (size_t i = 0; i < b.size; i++) {
+        int64_t ret = invalid_quote;
+        int64_t fee = 0;
+        if (b.amount[i] >= 0 && b.amount[i] <= b.supply[i]) {
+            auto initial = bancor_sell(b.reserve[i], b.supply[i], b.cw[i], b.amount[i]);
+            ret = sub_fee(initial, b.fee[i]);
+            fee = initial - ret;
+        }
+        b.tokens[i] = ret;
+        if (b.fees) {
+            b.fees[i] = fee;
+        }
+    }
+}
+
+inline void quote(const shares_batch& b) {
+    for (size_t i = 0; i < b.size; i++) {
+        if (!b.points[i]) {
+            b.result[i] = b.amount[i];
+            continue;
+        }
+        if (b.points[i] < 0) {
+            b.result[i] = invalid_quote;
+            continue;
+        }
+        double new_shares = bancor_supply_after_buy(b.points[i], b.shares[i], b.cw, b.amount[i]);
+        b.result[i] = bancor_supply_fits(new_shares) ? static_cast<int64_t>(new_shares) - b.shares[i] : invalid_quote;
+    }
+}
+
+}} // commun::math
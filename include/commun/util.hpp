@@ -1,8 +1,10 @@
 #pragma once
 #include "config.hpp"
+#include "math.hpp"
 
 namespace commun {
 
+static_assert(math::pct_base == config::_100percent, "math::pct_base must be equal to 100%");
 
 template<typename T>
 struct member_pointer_info;
@@ -14,7 +16,7 @@ struct member_pointer_info<V C::*> {
 };
 
 int64_t safe_prop(int64_t arg, int64_t numer, int64_t denom) {
-    return !arg || !numer ? 0 : static_cast<int64_t>((static_cast<int128_t>(arg) * numer) / denom);
+    return math::prop(arg, numer, denom);
 }
 
 int64_t safe_pct(int64_t arg, int64_t total) {
@@ -43,7 +43,7 @@ _communAccounts = [
 
     ('c.point',   'commun.point',         None, [
             (None,      'active',       [], ['c@active', 'c.point@cyber.code'], []),
-            (None,      'issueperm',    [], ['c.emit@cyber.code'], [':issue']),
+            (None,      'issueperm',    [], ['c.emit@cyber.code'], [':mintto']),
             (None,      'clients',      [], ['c@clients'], [':create']),
         ]),
     ('c.ctrl',    'commun.ctrl',          None, [
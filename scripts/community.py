@@ -176,18 +176,6 @@ def createCommunity(community_name, creator_auth, creator_key, maximum_supply, r
                 'type': 'unban',
                 'requirement': 'lead.minor'})
     
-        trx.addAction('cyber', 'updateauth', owner_account, {
-                'account': owner_account,
-                'permission': 'transferperm',
-                'parent': 'active',
-                'auth': createAuthority([], ['c.emit@cyber.code'])})
-    
-        trx.addAction('cyber', 'linkauth', owner_account, {
-                'account': owner_account,
-                'code': 'c.point',
-                'type': 'transfer',
-                'requirement': 'transferperm'})
-    
         trx.addAction('cyber', 'providebw', 'c@providebw', {
                 'provider': 'c',
                 'account': owner_account})
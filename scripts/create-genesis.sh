@@ -29,6 +29,11 @@ if [ -f "$GENESIS_INFO_TMPL" ]; then
     EXTRA_MAPPED_FILES+=" -v `readlink -f $GENESIS_INFO_TMPL`:/opt/commun.contracts/genesis/genesis-info.json.tmpl"
 fi
 
+# rows made by tests/genesis/commun_genesis, inserted at the beginning of the "tables" list
+if [ -f "$GENESIS_TABLES" ]; then
+    EXTRA_MAPPED_FILES+=" -v `readlink -f $GENESIS_TABLES`:/opt/commun.contracts/genesis/genesis-tables.json"
+fi
+
 rm -f create-genesis.log && touch create-genesis.log
 
 docker run --rm \
@@ -41,7 +46,7 @@ docker run --rm \
     '$LS_CMD &&
      sed -f /opt/commun.contracts/scripts/add_domain_object.sed -i /opt/cyberway.contracts/cyber.bios/cyber.bios.abi &&
      sed "s|\${INITIAL_TIMESTAMP}|'$INITIAL_TIMESTAMP$'|; /^#/d" /opt/commun.contracts/genesis/genesis.json.tmpl | tee genesis.json /genesis-data/genesis.json&& \
-     sed "s|\$CYBERWAY_CONTRACTS|$CYBERWAY_CONTRACTS|;s|\$COMMUN_CONTRACTS|$COMMUN_CONTRACTS|; /^#/d" /opt/commun.contracts/genesis/genesis-info.json.tmpl | tee genesis-info.json && \
+     sed "s|\$CYBERWAY_CONTRACTS|$CYBERWAY_CONTRACTS|;s|\$COMMUN_CONTRACTS|$COMMUN_CONTRACTS|; /^#/d; /^\s*\"tables\":\s*\[/r /opt/commun.contracts/genesis/genesis-tables.json" /opt/commun.contracts/genesis/genesis-info.json.tmpl | tee genesis-info.json && \
      $CREATE_GENESIS_CMD 2>&1 | tee create-genesis.log'
 
 GENESIS_DATA_HASH=$(sha256sum $DEST/genesis.dat | cut -f1 -d" ")
@@ -0,0 +1,93 @@
+// State auditor, checks the invariants of c.point, c.gallery and c.ctrl on a chaindb dump (see commun_audit.hpp).
+//
+// Usage: commun_audit --dump=<dir> [--name=value ...], see print_usage() for the options.
+// The dump can be made by mongodump or by mongoexport of the contract databases, e.g.:
+//   mongodump --db _CYBERWAY_c_gallery --out <dir>
+// Exit code is 0 if no violations are found, 1 on violations and 2 on invalid arguments or unreadable dumps.
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "commun_audit.hpp"
+
+using namespace commun;
+
+namespace {
+
+void print_usage() {
+    audit::options d;
+    std::cout << "commun_audit --dump=<dir> [--name=value ...]\n"
+        << "  --db_prefix=" << d.db_prefix << "  --threads=<cores>  --partitions=<threads>\n"
+        << "  --max_violations=100 (0 to print all)\n"
+        << "Rows are spread over partitions by account and by mosaic, every partition reads the whole dump;\n"
+        << "increase partitions to reduce the memory used by a thread.\n";
+}
+
+audit::options parse_options(int argc, char** argv, size_t& max_violations) {
+    audit::options opts;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto eq = arg.find('=');
+        if (arg.compare(0, 2, "--") || eq == std::string::npos) {
+            throw std::invalid_argument(arg);
+        }
+        auto key = arg.substr(2, eq - 2);
+        auto value = arg.substr(eq + 1);
+        if (key == "dump") {
+            opts.dir = value;
+        } else if (key == "db_prefix") {
+            opts.db_prefix = value;
+        } else if (key == "threads") {
+            opts.threads = std::stoull(value);
+        } else if (key == "partitions") {
+            opts.partitions = std::stoull(value);
+        } else if (key == "max_violations") {
+            max_violations = std::stoull(value);
+        } else {
+            throw std::invalid_argument(arg);
+        }
+    }
+    if (opts.dir.empty()) {
+        throw std::invalid_argument("dump is not set");
+    }
+    return opts;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    audit::options opts;
+    size_t max_violations = 100;
+    try {
+        if (argc > 1 && (std::string(argv[1]) == "--help" || std::string(argv[1]) == "-h")) {
+            print_usage();
+            return 0;
+        }
+        opts = parse_options(argc, argv, max_violations);
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << "\n";
+        print_usage();
+        return 2;
+    }
+
+    audit::report r;
+    auto started = std::chrono::steady_clock::now();
+    try {
+        r = audit::run(opts);
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return 2;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+
+    for (size_t i = 0; i < r.violations.size() && (!max_violations || i < max_violations); i++) {
+        std::cout << r.violations[i].community << ": " << r.violations[i].message << "\n";
+    }
+    std::cout << "communities " << r.communities << ", rows read " << r.rows
+              << ", violations " << r.violations.size()
+              << ", audited in " << std::fixed << std::setprecision(2) << elapsed.count() << " s\n";
+    return r.violations.empty() ? 0 : 1;
+}
@@ -0,0 +1,977 @@
+#pragma once
+// Offline auditor of the cross-table invariants of c.point, c.gallery and c.ctrl.
+//
+// Reads tables exported from chaindb and checks for every community:
+//   - supply of the point equals the sum of balances and of the points queued for sale;
+//   - frozen points (inclusion) of an account equal the points and pledges of its gems and don't exceed its balance;
+//   - gem_count, points, shares and pledge_points of a mosaic equal the sums over its gems;
+//   - balance of c.gallery equals the rewards of mosaics plus retained and unclaimed points of the gallery stat
+//     and its shards;
+//   - balance of c.ctrl covers the unclaimed and accrued rewards of leaders plus the retained points,
+//     and the top of the leaders stat matches the leaders marked as in_top.
+//
+// A dump is a directory with a subdirectory per contract database (<prefix><account with '.' replaced by '_'>)
+// and a file per table, <table>.bson (mongodump) or <table>.json (mongoexport, JSON lines or a JSON array).
+// The scope of a row is taken from its "scope" field or from "_SERVICE_.scope". Missing tables are treated as empty.
+//
+// Rows are split into partitions by the hash of the symbol code and the account (balances, inclusions, gems
+// by owner, leaders) or the tracery (mosaics, gems by mosaic), so a large community is spread over all
+// partitions. The rows of a community as a whole (stats, orders) go to the partition of the empty key.
+// A worker takes a partition, streams all the tables, checks the accounts and the mosaics of the partition
+// and returns the sums of the communities, which are merged over the partitions and checked at the end.
+// The memory used by a worker is bounded by its partition while the tables are read once per partition,
+// so by default there is one partition per thread.
+//
+// The header doesn't depend on the chain, it's used by the commun_audit tool and by the unit tests.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <commun/math.hpp>
+
+namespace commun { namespace audit {
+
+struct audit_error : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// a parsed JSON or BSON value, numbers are kept as text and converted on access
+struct value {
+    enum kind_t { null_kind, bool_kind, number_kind, string_kind, object_kind, array_kind };
+    kind_t kind = null_kind;
+    bool flag = false;
+    std::string text;
+    std::vector<std::pair<std::string, value>> items; // fields of an object or elements (with empty keys) of an array
+
+    const value* find(const std::string& key) const {
+        for (const auto& i : items) {
+            if (i.first == key) {
+                return &i.second;
+            }
+        }
+        return nullptr;
+    }
+
+    // path is a list of keys separated by dots
+    const value* find_path(const std::string& path) const {
+        const value* v = this;
+        size_t pos = 0;
+        while (v && pos <= path.size()) {
+            auto dot = path.find('.', pos);
+            if (dot == std::string::npos) {
+                dot = path.size();
+            }
+            v = v->kind == object_kind ? v->find(path.substr(pos, dot - pos)) : nullptr;
+            pos = dot + 1;
+        }
+        return v;
+    }
+
+    const value& at(const std::string& path) const {
+        auto v = find_path(path);
+        if (!v) {
+            throw audit_error("missing field " + path);
+        }
+        return *v;
+    }
+};
+
+using uint128_t = unsigned __int128;
+
+inline std::string to_string(uint128_t v) {
+    std::string s;
+    do {
+        s.push_back(static_cast<char>('0' + static_cast<int>(v % 10)));
+        v /= 10;
+    } while (v);
+    return std::string(s.rbegin(), s.rend());
+}
+
+// mongoexport wraps numbers into {"$numberLong": "..."} and similar objects
+inline const value& unwrap_number(const value& v) {
+    if (v.kind == value::object_kind && v.items.size() == 1 && v.items[0].first.compare(0, 7, "$number") == 0) {
+        return v.items[0].second;
+    }
+    return v;
+}
+
+inline uint128_t parse_magnitude(const std::string& text, size_t pos, const std::string& what) {
+    uint128_t base = 10;
+    if (text.compare(pos, 2, "0x") == 0 || text.compare(pos, 2, "0X") == 0) {
+        base = 16;
+        pos += 2;
+    }
+    if (pos >= text.size()) {
+        throw audit_error("invalid " + what + ": " + text);
+    }
+    uint128_t ret = 0;
+    for (; pos < text.size(); pos++) {
+        auto c = text[pos];
+        uint128_t digit = base;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        }
+        if (digit >= base || ret > (~uint128_t(0) - digit) / base) {
+            throw audit_error("invalid " + what + ": " + text);
+        }
+        ret = ret * base + digit;
+    }
+    return ret;
+}
+
+inline const std::string& number_text(const value& v, const std::string& what) {
+    const auto& n = unwrap_number(v);
+    if (n.kind != value::number_kind && n.kind != value::string_kind) {
+        throw audit_error(what + " is not a number");
+    }
+    return n.text;
+}
+
+inline uint128_t as_uint128(const value& v) {
+    const auto& text = number_text(v, "uint128");
+    return parse_magnitude(text, 0, "uint128");
+}
+
+inline uint64_t as_uint64(const value& v) {
+    const auto& text = number_text(v, "uint64");
+    auto ret = parse_magnitude(text, 0, "uint64");
+    if (ret > std::numeric_limits<uint64_t>::max()) {
+        throw audit_error("uint64 overflow: " + text);
+    }
+    return static_cast<uint64_t>(ret);
+}
+
+inline int64_t as_int64(const value& v) {
+    const auto& text = number_text(v, "int64");
+    bool neg = !text.empty() && text[0] == '-';
+    auto mag = parse_magnitude(text, neg ? 1 : 0, "int64");
+    if (mag > static_cast<uint128_t>(std::numeric_limits<int64_t>::max()) + (neg ? 1 : 0)) {
+        throw audit_error("int64 overflow: " + text);
+    }
+    return neg ? static_cast<int64_t>(-static_cast<__int128>(mag)) : static_cast<int64_t>(mag);
+}
+
+inline bool as_bool(const value& v) {
+    if (v.kind == value::bool_kind) {
+        return v.flag;
+    }
+    return as_int64(v) != 0;
+}
+
+inline const std::string& as_string(const value& v) {
+    if (v.kind != value::string_kind) {
+        throw audit_error("value is not a string");
+    }
+    return v.text;
+}
+
+struct asset_t {
+    int64_t amount = 0;
+    std::string code;
+};
+
+// "1.000 CODE" as the abi serializer writes it or {"_amount": ..., "_decs": ..., "_sym": "CODE"} as it's stored in mongodb
+inline asset_t as_asset(const value& v) {
+    asset_t ret;
+    if (v.kind == value::object_kind) {
+        ret.amount = as_int64(v.at("_amount"));
+        ret.code = as_string(v.at("_sym"));
+        return ret;
+    }
+    const auto& s = as_string(v);
+    auto space = s.find(' ');
+    if (space == std::string::npos) {
+        throw audit_error("invalid asset: " + s);
+    }
+    std::string digits = s.substr(0, space);
+    digits.erase(std::remove(digits.begin(), digits.end(), '.'), digits.end());
+    value n;
+    n.kind = value::number_kind;
+    n.text = digits;
+    ret.amount = as_int64(n);
+    ret.code = s.substr(space + 1);
+    return ret;
+}
+
+inline const std::string& row_scope(const value& row) {
+    if (auto scope = row.find("scope")) {
+        return as_string(*scope);
+    }
+    return as_string(row.at("_SERVICE_.scope"));
+}
+
+// Streams rows of a table, one object per call
+class row_reader {
+public:
+    virtual ~row_reader() = default;
+    virtual bool next(value& row) = 0;
+};
+
+class json_reader : public row_reader {
+    std::istream& _in;
+    std::string _file;
+
+    [[noreturn]] void fail(const std::string& msg) {
+        auto pos = _in.tellg();
+        throw audit_error(_file + ": " + msg + (pos < 0 ? std::string(" at the end") : " at offset " + std::to_string(static_cast<long long>(pos))));
+    }
+    int peek_char() {
+        int c = _in.peek();
+        while (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            _in.get();
+            c = _in.peek();
+        }
+        return c;
+    }
+    void expect(char c) {
+        if (peek_char() != c) {
+            fail(std::string("expected '") + c + "'");
+        }
+        _in.get();
+    }
+    void append_utf8(std::string& s, uint32_t cp) {
+        if (cp < 0x80) {
+            s.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            s.push_back(static_cast<char>(0xc0 | (cp >> 6)));
+            s.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+        } else if (cp < 0x10000) {
+            s.push_back(static_cast<char>(0xe0 | (cp >> 12)));
+            s.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+            s.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+        } else {
+            s.push_back(static_cast<char>(0xf0 | (cp >> 18)));
+            s.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3f)));
+            s.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+            s.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+        }
+    }
+    uint32_t read_hex4() {
+        uint32_t cp = 0;
+        for (int i = 0; i < 4; i++) {
+            int c = _in.get();
+            cp <<= 4;
+            if (c >= '0' && c <= '9') {
+                cp |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                cp |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                cp |= c - 'A' + 10;
+            } else {
+                fail("invalid unicode escape");
+            }
+        }
+        return cp;
+    }
+    std::string read_string() {
+        expect('"');
+        std::string s;
+        for (;;) {
+            int c = _in.get();
+            if (c == EOF) {
+                fail("unterminated string");
+            }
+            if (c == '"') {
+                return s;
+            }
+            if (c != '\\') {
+                s.push_back(static_cast<char>(c));
+                continue;
+            }
+            c = _in.get();
+            switch (c) {
+                case '"': case '\\': case '/': s.push_back(static_cast<char>(c)); break;
+                case 'b': s.push_back('\b'); break;
+                case 'f': s.push_back('\f'); break;
+                case 'n': s.push_back('\n'); break;
+                case 'r': s.push_back('\r'); break;
+                case 't': s.push_back('\t'); break;
+                case 'u': {
+                    auto cp = read_hex4();
+                    if (cp >= 0xd800 && cp < 0xdc00) {
+                        if (_in.get() != '\\' || _in.get() != 'u') {
+                            fail("invalid surrogate pair");
+                        }
+                        cp = 0x10000 + ((cp - 0xd800) << 10) + (read_hex4() - 0xdc00);
+                    }
+                    append_utf8(s, cp);
+                    break;
+                }
+                default: fail("invalid escape");
+            }
+        }
+    }
+    void read_literal(const char* lit) {
+        for (auto p = lit; *p; p++) {
+            if (_in.get() != *p) {
+                fail(std::string("expected ") + lit);
+            }
+        }
+    }
+    void read_value(value& v) {
+        v = value();
+        int c = peek_char();
+        if (c == '{') {
+            _in.get();
+            v.kind = value::object_kind;
+            if (peek_char() == '}') {
+                _in.get();
+                return;
+            }
+            for (;;) {
+                auto key = read_string();
+                expect(':');
+                v.items.emplace_back(std::move(key), value());
+                read_value(v.items.back().second);
+                c = peek_char();
+                _in.get();
+                if (c == '}') {
+                    return;
+                }
+                if (c != ',') {
+                    fail("expected ',' or '}'");
+                }
+            }
+        } else if (c == '[') {
+            _in.get();
+            v.kind = value::array_kind;
+            if (peek_char() == ']') {
+                _in.get();
+                return;
+            }
+            for (;;) {
+                v.items.emplace_back(std::string(), value());
+                read_value(v.items.back().second);
+                c = peek_char();
+                _in.get();
+                if (c == ']') {
+                    return;
+                }
+                if (c != ',') {
+                    fail("expected ',' or ']'");
+                }
+            }
+        } else if (c == '"') {
+            v.kind = value::string_kind;
+            v.text = read_string();
+        } else if (c == 't') {
+            read_literal("true");
+            v.kind = value::bool_kind;
+            v.flag = true;
+        } else if (c == 'f') {
+            read_literal("false");
+            v.kind = value::bool_kind;
+        } else if (c == 'n') {
+            read_literal("null");
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            v.kind = value::number_kind;
+            while ((c = _in.peek()) == '-' || c == '+' || c == '.' || c == 'e' || c == 'E' || (c >= '0' && c <= '9')) {
+                v.text.push_back(static_cast<char>(_in.get()));
+            }
+        } else {
+            fail("unexpected character");
+        }
+    }
+
+public:
+    json_reader(std::istream& in, std::string file): _in(in), _file(std::move(file)) {}
+
+    // rows can be separated by new lines (JSON lines) or be elements of a top-level array
+    bool next(value& row) override {
+        int c;
+        while ((c = peek_char()) == '[' || c == ',' || c == ']') {
+            _in.get();
+        }
+        if (c == EOF) {
+            return false;
+        }
+        read_value(row);
+        if (row.kind != value::object_kind) {
+            fail("row is not an object");
+        }
+        return true;
+    }
+};
+
+class bson_reader : public row_reader {
+    std::istream& _in;
+    std::string _file;
+    std::vector<char> _buf;
+
+    [[noreturn]] void fail(const std::string& msg) {
+        throw audit_error(_file + ": " + msg);
+    }
+    template<typename T> T read_le(const char*& p, const char* end) {
+        if (end - p < static_cast<ptrdiff_t>(sizeof(T))) {
+            fail("truncated document");
+        }
+        uint64_t v = 0;
+        for (size_t i = 0; i < sizeof(T); i++) {
+            v |= static_cast<uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+        }
+        p += sizeof(T);
+        return static_cast<T>(v);
+    }
+    std::string read_cstring(const char*& p, const char* end) {
+        auto z = static_cast<const char*>(std::memchr(p, 0, end - p));
+        if (!z) {
+            fail("unterminated key");
+        }
+        std::string s(p, z);
+        p = z + 1;
+        return s;
+    }
+    // only integral values are expected, like the uint128 fields
+    std::string decimal128_text(uint64_t low, uint64_t high) {
+        if (((high >> 61) & 3) == 3) {
+            fail("unsupported decimal128 value");
+        }
+        int exp = static_cast<int>((high >> 49) & 0x3fff) - 6176;
+        uint128_t coeff = (static_cast<uint128_t>(high & ((uint64_t(1) << 49) - 1)) << 64) | low;
+        for (; exp < 0; exp++) {
+            if (coeff % 10) {
+                fail("fractional decimal128 value");
+            }
+            coeff /= 10;
+        }
+        for (; exp > 0 && coeff; exp--) {
+            coeff *= 10;
+        }
+        return (high >> 63 && coeff ? "-" : "") + to_string(coeff);
+    }
+    void read_document(const char*& p, const char* end, value& v, bool array) {
+        auto start = p;
+        auto size = read_le<int32_t>(p, end);
+        if (size < 5 || size > end - start) {
+            fail("invalid document size");
+        }
+        end = start + size;
+        v.kind = array ? value::array_kind : value::object_kind;
+        for (;;) {
+            if (p >= end) {
+                fail("truncated document");
+            }
+            auto type = static_cast<unsigned char>(*p++);
+            if (!type) {
+                break;
+            }
+            auto key = read_cstring(p, end);
+            v.items.emplace_back(array ? std::string() : std::move(key), value());
+            auto& item = v.items.back().second;
+            switch (type) {
+                case 0x01: {
+                    auto bits = read_le<uint64_t>(p, end);
+                    double d;
+                    std::memcpy(&d, &bits, sizeof(d));
+                    std::ostringstream s;
+                    s.precision(17);
+                    s << d;
+                    item.kind = value::number_kind;
+                    item.text = s.str();
+                    break;
+                }
+                case 0x02: {
+                    auto len = read_le<int32_t>(p, end);
+                    if (len < 1 || len > end - p) {
+                        fail("invalid string size");
+                    }
+                    item.kind = value::string_kind;
+                    item.text.assign(p, len - 1);
+                    p += len;
+                    break;
+                }
+                case 0x03: case 0x04:
+                    read_document(p, end, item, type == 0x04);
+                    break;
+                case 0x05: {
+                    auto len = read_le<int32_t>(p, end);
+                    if (len < 0 || len + 1 > end - p) {
+                        fail("invalid binary size");
+                    }
+                    p += len + 1;
+                    break;
+                }
+                case 0x07:
+                    if (end - p < 12) {
+                        fail("truncated object id");
+                    }
+                    p += 12;
+                    break;
+                case 0x08:
+                    item.kind = value::bool_kind;
+                    item.flag = read_le<uint8_t>(p, end) != 0;
+                    break;
+                case 0x0a:
+                    break;
+                case 0x10:
+                    item.kind = value::number_kind;
+                    item.text = std::to_string(read_le<int32_t>(p, end));
+                    break;
+                case 0x09: case 0x12:
+                    item.kind = value::number_kind;
+                    item.text = std::to_string(read_le<int64_t>(p, end));
+                    break;
+                case 0x11:
+                    item.kind = value::number_kind;
+                    item.text = std::to_string(read_le<uint64_t>(p, end));
+                    break;
+                case 0x13: {
+                    auto low = read_le<uint64_t>(p, end);
+                    auto high = read_le<uint64_t>(p, end);
+                    item.kind = value::number_kind;
+                    item.text = decimal128_text(low, high);
+                    break;
+                }
+                default:
+                    fail("unsupported bson type " + std::to_string(type));
+            }
+        }
+        if (p != end) {
+            fail("invalid document end");
+        }
+    }
+
+public:
+    bson_reader(std::istream& in, std::string file): _in(in), _file(std::move(file)) {}
+
+    bool next(value& row) override {
+        char size_buf[4];
+        if (!_in.read(size_buf, 4)) {
+            if (_in.gcount()) {
+                fail("truncated document size");
+            }
+            return false;
+        }
+        const char* p = size_buf;
+        auto size = read_le<int32_t>(p, size_buf + 4);
+        if (size < 5) {
+            fail("invalid document size");
+        }
+        _buf.resize(size);
+        std::memcpy(_buf.data(), size_buf, 4);
+        if (!_in.read(_buf.data() + 4, size - 4)) {
+            fail("truncated document");
+        }
+        p = _buf.data();
+        row = value();
+        read_document(p, _buf.data() + size, row, false);
+        return true;
+    }
+};
+
+struct options {
+    std::string dir;
+    std::string db_prefix = "_CYBERWAY_";
+    size_t threads = 0;     // hardware concurrency if zero
+    size_t partitions = 0;  // the number of threads if zero
+};
+
+struct violation {
+    std::string community;
+    std::string message;
+
+    bool operator<(const violation& rhs) const {
+        return std::tie(community, message) < std::tie(rhs.community, rhs.message);
+    }
+};
+
+struct report {
+    uint64_t rows = 0;          // rows read by all workers (each partition reads the tables)
+    size_t communities = 0;
+    std::vector<violation> violations;
+};
+
+// the file of a table or an empty string if the table isn't exported
+inline std::string table_file(const options& opts, const std::string& account, const std::string& table, bool& bson) {
+    std::string db = account;
+    std::replace(db.begin(), db.end(), '.', '_');
+    auto base = opts.dir + "/" + opts.db_prefix + db + "/" + table;
+    for (bool b : {true, false}) {
+        auto path = base + (b ? ".bson" : ".json");
+        if (std::ifstream(path).good()) {
+            bson = b;
+            return path;
+        }
+    }
+    return std::string();
+}
+
+inline uint64_t partition_hash(const std::string& community, const std::string& key) {
+    uint64_t h = 14695981039346656037ull;  // FNV-1a
+    auto add = [&](const std::string& s) {
+        for (auto c : s) {
+            h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+    };
+    add(community);
+    h = (h ^ 0xffu) * 1099511628211ull;  // not a symbol code char, so ("AB", "C") and ("A", "BC") differ
+    add(key);
+    return h;
+}
+
+struct mosaic_sums {
+    bool has_row = false;
+    int64_t gem_count = 0, points = 0, shares = 0, damn_points = 0, damn_shares = 0, pledge_points = 0, reward = 0;
+    int64_t gems = 0, gem_points = 0, gem_shares = 0, gem_damn_points = 0, gem_damn_shares = 0, gem_pledge_points = 0;
+};
+
+struct owner_sums {
+    int64_t balance = 0;
+    int64_t frozen = 0;       // the inclusion row
+    int64_t gem_points = 0;   // points and pledges of the owned gems
+};
+
+// sums of a community over the rows of a partition, the partitions are merged before the community is checked
+struct community_totals {
+    bool has_point_stat = false;
+    int64_t supply = 0;
+    int64_t balances = 0;
+    int64_t orders = 0;
+
+    bool has_gallery_stat = false;
+    bool has_mosaics = false;
+    int64_t gallery_retained = 0, gallery_unclaimed = 0, gallery_balance = 0;
+    int64_t rewards = 0;
+
+    bool has_ctrl_stat = false;
+    int64_t ctrl_retained = 0, ctrl_balance = 0;
+    uint64_t top_weight = 0, top_num = 0;
+    int64_t leaders_due = 0;
+    uint64_t leaders_top_weight = 0, leaders_top_num = 0;
+
+    void merge(const community_totals& t) {
+        has_point_stat = has_point_stat || t.has_point_stat;
+        supply += t.supply;
+        balances += t.balances;
+        orders += t.orders;
+        has_gallery_stat = has_gallery_stat || t.has_gallery_stat;
+        has_mosaics = has_mosaics || t.has_mosaics;
+        gallery_retained += t.gallery_retained;
+        gallery_unclaimed += t.gallery_unclaimed;
+        gallery_balance += t.gallery_balance;
+        rewards += t.rewards;
+        has_ctrl_stat = has_ctrl_stat || t.has_ctrl_stat;
+        ctrl_retained += t.ctrl_retained;
+        ctrl_balance += t.ctrl_balance;
+        top_weight += t.top_weight;
+        top_num += t.top_num;
+        leaders_due += t.leaders_due;
+        leaders_top_weight += t.leaders_top_weight;
+        leaders_top_num += t.leaders_top_num;
+    }
+};
+
+class auditor {
+    using key_t = std::pair<std::string, std::string>;
+    struct key_hash {
+        size_t operator()(const key_t& k) const { return partition_hash(k.first, k.second); }
+    };
+
+    const options& _opts;
+    size_t _partition;
+    size_t _partitions;
+    std::unordered_map<key_t, owner_sums, key_hash> _owners;            // (community, account)
+    std::unordered_map<key_t, mosaic_sums, key_hash> _mosaics;          // (community, tracery)
+    std::unordered_map<std::string, community_totals> _totals;
+    std::unordered_map<std::string, math::reward_acc_t> _reward_per_weight;  // of all communities, the stat is small
+    uint64_t _rows = 0;
+
+    bool mine(const std::string& community, const std::string& key) const {
+        return partition_hash(community, key) % _partitions == _partition;
+    }
+    // rows of a community as a whole (stats, orders) are taken by the partition of the empty key
+    community_totals* totals(const std::string& community) {
+        return mine(community, std::string()) ? &_totals[community] : nullptr;
+    }
+    owner_sums* owner(const std::string& community, const std::string& account) {
+        return mine(community, account) ? &_owners[key_t(community, account)] : nullptr;
+    }
+    mosaic_sums* mosaic(const std::string& community, uint64_t tracery) {
+        auto key = std::to_string(tracery);
+        return mine(community, key) ? &_mosaics[key_t(community, key)] : nullptr;
+    }
+
+    template<typename F>
+    void read(const std::string& account, const std::string& table, F&& on_row) {
+        bool bson = false;
+        auto path = table_file(_opts, account, table, bson);
+        if (path.empty()) {
+            return;
+        }
+        std::ifstream in(path, std::ios::binary);
+        std::unique_ptr<row_reader> reader;
+        if (bson) {
+            reader.reset(new bson_reader(in, path));
+        } else {
+            reader.reset(new json_reader(in, path));
+        }
+        value row;
+        uint64_t n = 0;
+        while (reader->next(row)) {
+            n++;
+            try {
+                on_row(row);
+            } catch (const audit_error& e) {
+                throw audit_error(path + ", row " + std::to_string(n) + ": " + e.what());
+            }
+        }
+        _rows += n;
+    }
+
+    static void mismatch(std::vector<violation>& out, const std::string& code, const std::string& what, int64_t expected, int64_t actual) {
+        if (expected != actual) {
+            out.push_back({code, what + ": " + std::to_string(expected) + " != " + std::to_string(actual)});
+        }
+    }
+
+    static void check_owner(const key_t& key, const owner_sums& o, std::vector<violation>& out) {
+        mismatch(out, key.first, "inclusion of " + key.second + " != points in gems", o.frozen, o.gem_points);
+        if (o.frozen > o.balance) {
+            out.push_back({key.first, "inclusion of " + key.second + " exceeds balance: " + std::to_string(o.frozen) + " > " + std::to_string(o.balance)});
+        }
+    }
+
+    static void check_mosaic(const key_t& key, const mosaic_sums& s, std::vector<violation>& out) {
+        auto prefix = "mosaic " + key.second + " ";
+        if (!s.has_row) {
+            out.push_back({key.first, prefix + "doesn't exist, but has " + std::to_string(s.gems) + " gems"});
+            return;
+        }
+        mismatch(out, key.first, prefix + "gem_count", s.gem_count, s.gems);
+        mismatch(out, key.first, prefix + "points", s.points, s.gem_points);
+        mismatch(out, key.first, prefix + "shares", s.shares, s.gem_shares);
+        mismatch(out, key.first, prefix + "damn_points", s.damn_points, s.gem_damn_points);
+        mismatch(out, key.first, prefix + "damn_shares", s.damn_shares, s.gem_damn_shares);
+        mismatch(out, key.first, prefix + "pledge_points", s.pledge_points, s.gem_pledge_points);
+    }
+
+public:
+    auditor(const options& opts, size_t partition, size_t partitions)
+        : _opts(opts), _partition(partition), _partitions(partitions) {}
+
+    // the ctrl stat is read before the leaders depending on it
+    void aggregate() {
+        read("c.point", "stat", [&](const value& row) {
+            auto supply = as_asset(row.at("supply"));
+            if (auto t = totals(supply.code)) {
+                t->has_point_stat = true;
+                t->supply = supply.amount;
+            }
+        });
+        read("c.point", "accounts", [&](const value& row) {
+            auto balance = as_asset(row.at("balance"));
+            const auto& account = row_scope(row);
+            if (auto o = owner(balance.code, account)) {
+                o->balance += balance.amount;
+                auto& t = _totals[balance.code];
+                t.balances += balance.amount;
+                if (account == "c.gallery") {
+                    t.gallery_balance += balance.amount;
+                } else if (account == "c.ctrl") {
+                    t.ctrl_balance += balance.amount;
+                }
+            }
+        });
+        read("c.point", "order", [&](const value& row) {
+            auto quantity = as_asset(row.at("quantity"));
+            if (quantity.code != row_scope(row)) {
+                return; // buying orders hold the reserve tokens
+            }
+            if (auto t = totals(quantity.code)) {
+                t->orders += quantity.amount;
+            }
+        });
+        read("c.gallery", "stat", [&](const value& row) {
+            if (auto t = totals(row_scope(row))) {
+                t->has_gallery_stat = true;
+                t->gallery_retained = as_int64(row.at("retained"));
+                t->gallery_unclaimed += as_int64(row.at("unclaimed"));
+            }
+        });
+        read("c.gallery", "statshard", [&](const value& row) {
+            if (auto t = totals(row_scope(row))) {
+                t->gallery_unclaimed += as_int64(row.at("unclaimed"));
+            }
+        });
+        read("c.gallery", "mosaic", [&](const value& row) {
+            const auto& community = row_scope(row);
+            if (auto m = mosaic(community, as_uint64(row.at("tracery")))) {
+                m->has_row = true;
+                m->gem_count = as_int64(row.at("gem_count"));
+                m->points = as_int64(row.at("points"));
+                m->shares = as_int64(row.at("shares"));
+                m->damn_points = as_int64(row.at("damn_points"));
+                m->damn_shares = as_int64(row.at("damn_shares"));
+                m->pledge_points = as_int64(row.at("pledge_points"));
+                m->reward = as_int64(row.at("reward"));
+                auto& t = _totals[community];
+                t.has_mosaics = true;
+                t.rewards += m->reward;
+            }
+        });
+        // a gem is added to its mosaic and to its owner, which can be in different partitions
+        read("c.gallery", "gem", [&](const value& row) {
+            const auto& community = row_scope(row);
+            auto points = as_int64(row.at("points"));
+            auto pledge = as_int64(row.at("pledge_points"));
+            if (auto m = mosaic(community, as_uint64(row.at("tracery")))) {
+                auto shares = as_int64(row.at("shares"));
+                m->gems++;
+                if (shares < 0) {  // the same as chop_gem
+                    m->gem_damn_points += points;
+                    m->gem_damn_shares -= shares;
+                } else {
+                    m->gem_points += points;
+                    m->gem_shares += shares;
+                }
+                m->gem_pledge_points += pledge;
+            }
+            if (auto o = owner(community, as_string(row.at("owner")))) {
+                o->gem_points += points + pledge;
+            }
+        });
+        read("c.gallery", "inclusion", [&](const value& row) {
+            auto quantity = as_asset(row.at("quantity"));
+            if (auto o = owner(quantity.code, row_scope(row))) {
+                o->frozen += quantity.amount;
+            }
+        });
+        read("c.ctrl", "stat", [&](const value& row) {
+            const auto& community = row_scope(row);
+            // the reward fields are binary extensions, the rows created before them have none
+            auto acc = row.find_path("reward_per_weight");
+            if (acc) {
+                _reward_per_weight[community] = as_uint128(*acc);
+            }
+            if (auto t = totals(community)) {
+                t->has_ctrl_stat = true;
+                t->ctrl_retained = as_int64(row.at("retained"));
+                if (acc) {
+                    t->top_weight = as_uint64(row.at("top_weight"));
+                    t->top_num = as_uint64(row.at("top_num"));
+                }
+            }
+        });
+        read("c.ctrl", "leader", [&](const value& row) {
+            const auto& community = row_scope(row);
+            if (!mine(community, as_string(row.at("name")))) {
+                return;
+            }
+            auto& t = _totals[community];
+            t.leaders_due += as_int64(row.at("unclaimed_points"));
+            auto in_top = row.find_path("in_top");
+            if (in_top && as_bool(*in_top)) {
+                auto weight = as_uint64(row.at("total_weight"));
+                auto rpw = _reward_per_weight.find(community);
+                t.leaders_due += math::accrued_reward(weight, rpw != _reward_per_weight.end() ? rpw->second : 0,
+                                                      as_uint128(row.at("reward_checkpoint")));
+                t.leaders_top_weight += weight;
+                t.leaders_top_num++;
+            }
+        });
+    }
+
+    // checks the owners and the mosaics of the partition and passes the sums of the communities to the caller
+    void check(report& out, std::map<std::string, community_totals>& communities) const {
+        for (const auto& o : _owners) {
+            check_owner(o.first, o.second, out.violations);
+        }
+        for (const auto& m : _mosaics) {
+            check_mosaic(m.first, m.second, out.violations);
+        }
+        for (const auto& t : _totals) {
+            communities[t.first].merge(t.second);
+        }
+        out.rows += _rows;
+    }
+
+    static void check_community(const std::string& code, const community_totals& c, std::vector<violation>& out) {
+        auto add = [&](const std::string& msg) { out.push_back({code, msg}); };
+        if (c.has_point_stat) {
+            mismatch(out, code, "supply != balances + sell orders", c.supply, c.balances + c.orders);
+        } else {
+            add("point stat doesn't exist");
+        }
+        if (c.has_gallery_stat) {
+            mismatch(out, code, "c.gallery balance != rewards + retained + unclaimed", c.gallery_balance,
+                     c.rewards + c.gallery_retained + c.gallery_unclaimed);
+        } else if (c.has_mosaics) {
+            add("gallery stat doesn't exist");
+        }
+        if (c.has_ctrl_stat) {
+            auto due = c.leaders_due + c.ctrl_retained;
+            if (c.ctrl_balance < due) {
+                add("c.ctrl balance < leaders rewards + retained: " + std::to_string(c.ctrl_balance) + " < " + std::to_string(due));
+            }
+            if (c.top_weight != c.leaders_top_weight || c.top_num != c.leaders_top_num) {
+                add("leaders top " + std::to_string(c.top_num) + "/" + std::to_string(c.top_weight) +
+                       " != leaders in top " + std::to_string(c.leaders_top_num) + "/" + std::to_string(c.leaders_top_weight));
+            }
+        }
+    }
+};
+
+inline report run(const options& opts) {
+    auto threads = opts.threads ? opts.threads : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    auto partitions = opts.partitions ? opts.partitions : threads;
+    threads = std::min(threads, partitions);
+
+    report ret;
+    std::map<std::string, community_totals> communities;
+    std::mutex ret_mutex;
+    std::atomic<size_t> next_partition(0);
+    std::exception_ptr error;
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&]() {
+            try {
+                for (size_t p = next_partition++; p < partitions; p = next_partition++) {
+                    auditor a(opts, p, partitions);
+                    a.aggregate();
+                    std::lock_guard<std::mutex> lock(ret_mutex);
+                    a.check(ret, communities);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(ret_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next_partition = partitions;
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    for (const auto& c : communities) {
+        auditor::check_community(c.first, c.second, ret.violations);
+    }
+    ret.communities = communities.size();
+    std::sort(ret.violations.begin(), ret.violations.end());
+    return ret;
+}
+
+}} // commun::audit
@@ -2,6 +2,7 @@
 #include "test_api_helper.hpp"
 #include "contracts.hpp"
 #include "../include/commun/config.hpp"
+#include "../include/commun/math.hpp"
 
 namespace eosio { namespace testing {
 
@@ -156,16 +157,31 @@ struct commun_ctrl_api: base_contract_api {
         return get_struct(commun_code.value, N(leader), leader, "leader_info");
     }
 
+    variant get_voter(name voter) const {
+        return get_struct(commun_code.value, N(voter), voter, "voter_info");
+    }
+
     std::vector<variant> get_all_leaders() {
         return _tester->get_all_chaindb_rows(_code, commun_code.value, N(leader), false);
     }
     
+    // includes the reward not yet added to unclaimed_points by the contract
     int64_t get_unclaimed(name leader) {
-        return get_leader(leader)["unclaimed_points"].as<int64_t>();
+        auto l = get_leader(leader);
+        auto ret = l["unclaimed_points"].as<int64_t>();
+        if (l["in_top"].as<bool>()) {
+            ret += commun::math::accrued_reward(l["total_weight"].as<uint64_t>(),
+                get_stat()["reward_per_weight"].as<unsigned __int128>(), l["reward_checkpoint"].as<unsigned __int128>());
+        }
+        return ret;
     }
     
+    variant get_stat() const {
+        return get_struct(commun_code.value, N(stat), commun_code.value, "stat");
+    }
+
     int64_t get_retained() {
-        return get_struct(commun_code.value, N(stat), commun_code.value, "stat")["retained"].as<int64_t>();
+        return get_stat()["retained"].as<int64_t>();
     }
     
     void prepare(const std::vector<name>& leaders, name voter, uint16_t pct_sum = cfg::_100percent) {
@@ -48,12 +48,14 @@ public:
             cfg::token_name, cfg::list_name, cfg::control_name, cfg::point_name, cfg::emit_name, cfg::gallery_name});
         create_accounts(leaders);
         produce_block();
-        install_contract(cfg::control_name, contracts::ctrl_wasm(), contracts::ctrl_abi());
-        install_contract(cfg::token_name, contracts::token_wasm(), contracts::token_abi());
-        install_contract(cfg::point_name, contracts::point_wasm(), contracts::point_abi());
-        install_contract(cfg::list_name, contracts::list_wasm(), contracts::list_abi());
-        install_contract(cfg::emit_name, contracts::emit_wasm(), contracts::emit_abi());
-        install_contract(cfg::gallery_name, contracts::gallery_wasm(), contracts::gallery_abi());
+        install_contracts({
+            {cfg::control_name, contracts::ctrl_wasm(), contracts::ctrl_abi()},
+            {cfg::token_name, contracts::token_wasm(), contracts::token_abi()},
+            {cfg::point_name, contracts::point_wasm(), contracts::point_abi()},
+            {cfg::list_name, contracts::list_wasm(), contracts::list_abi()},
+            {cfg::emit_name, contracts::emit_wasm(), contracts::emit_abi()},
+            {cfg::gallery_name, contracts::gallery_wasm(), contracts::gallery_abi()}
+        });
 
         set_authority(cfg::control_name, N(changepoints), create_code_authority({cfg::point_name}), "active");
         link_authority(cfg::control_name, cfg::control_name, N(changepoints), N(changepoints));
@@ -78,7 +80,7 @@ public:
         link_authority(cfg::gallery_name, cfg::gallery_name, N(init), N(init));
 
         set_authority(cfg::point_name, cfg::issue_permission, create_code_authority({cfg::emit_name}), "active");
-        link_authority(cfg::point_name, cfg::point_name, cfg::issue_permission, N(issue));
+        link_authority(cfg::point_name, cfg::point_name, cfg::issue_permission, N(mintto));
 
     }
     struct errors : contract_error_messages {
@@ -87,6 +89,7 @@ public:
 
         const string not_a_leader(account_name leader) { return amsg((leader.to_string() + " is not a leader")); }
         const string approved = amsg("already approved");
+        const string hash_mismatch = amsg("hash mismatch");
         const string authorization_failed = amsg("transaction authorization failed");
         const string no_leaders = amsg("leaders num must be positive");
         const string votes_must_be_positive = amsg("max votes must be positive");
@@ -115,6 +118,12 @@ public:
         const string there_are_votes = amsg("not possible to remove leader as there are votes");
 
         const string it_isnt_time_for_reward = amsg("it isn't time for reward");
+
+        const string unknown_param = amsg("unknown parameter");
+        const string incorrect_emission_rate = amsg("incorrect emission rate");
+        const string same_param_value = amsg("the same value already voted");
+        const string no_param_vote = amsg("no vote to remove");
+        const string leader_in_top = amsg("leader is in the top");
     } err;
 
     transaction get_point_create_trx(const vector<permission_level>& auths, name issuer, asset initial_supply, asset maximum_supply, int16_t cw, int16_t fee) {
@@ -158,9 +167,6 @@ public:
         BOOST_CHECK_EQUAL(success(), point.create(_golos, asset(0, point._symbol), asset(supply * 2, point._symbol), 10000, 1));
         BOOST_CHECK_EQUAL(success(), community.create(cfg::list_name, point_code, "The community"));
 
-        set_authority(_golos, cfg::transfer_permission, create_code_authority({cfg::emit_name}), cfg::active_name);
-        link_authority(_golos, cfg::point_name, cfg::transfer_permission, N(transfer));
-
         BOOST_CHECK_EQUAL(success(), token.transfer(_golos, cfg::point_name, asset(reserve, token._symbol), cfg::restock_prefix + point_code_str));
         BOOST_CHECK_EQUAL(success(), point.issue(_golos, asset(supply, point._symbol), std::string(point_code_str) + " issue"));
         BOOST_CHECK_EQUAL(success(), point.open(_code));
@@ -208,6 +214,10 @@ BOOST_FIXTURE_TEST_CASE(basic_tests, commun_ctrl_tester) try {
     BOOST_CHECK(point.get_params().is_null());
 
     BOOST_CHECK_EQUAL(success(), dapp_ctrl.approve(leaders[0], N(goloscreate), leaders[10]));
+    BOOST_CHECK_EQUAL(success(), dapp_ctrl.unapprove(leaders[0], N(goloscreate), leaders[10]));
+    BOOST_CHECK_EQUAL(err.hash_mismatch, dapp_ctrl.approve(leaders[0], N(goloscreate), leaders[10], fc::sha256::hash("wrong")));
+    auto packed_trx = fc::raw::pack(trx);
+    BOOST_CHECK_EQUAL(success(), dapp_ctrl.approve(leaders[0], N(goloscreate), leaders[10], fc::sha256::hash(packed_trx.data(), packed_trx.size())));
     BOOST_CHECK_EQUAL(success(), dapp_ctrl.exec(leaders[0], N(goloscreate), _bob));
 
     CHECK_MATCHING_OBJECT(point.get_params(), mvo()
@@ -279,6 +289,9 @@ BOOST_FIXTURE_TEST_CASE(unregleader_test, commun_ctrl_tester) try {
 
     BOOST_CHECK_EQUAL(success(), comm_ctrl.stop_leader(_alice));
     BOOST_CHECK_EQUAL(success(), comm_ctrl.clear_votes(_alice));
+    for (size_t u = 0; u < votes_num; u++) {
+        BOOST_CHECK(comm_ctrl.get_voter(user_name(u)).is_null());
+    }
     BOOST_CHECK_EQUAL(success(), comm_ctrl.unreg_leader(_alice));
     produce_block();
     BOOST_CHECK_EQUAL(err.leader_not_found, comm_ctrl.unreg_leader(_alice));
@@ -330,7 +343,9 @@ BOOST_FIXTURE_TEST_CASE(voteleader_test, commun_ctrl_tester) try {
 
     BOOST_CHECK_EQUAL(err.no_balance, comm_ctrl.vote_leader(_carol, _alice));
     BOOST_CHECK_EQUAL(success(), point.open(_carol));
+    BOOST_CHECK(comm_ctrl.get_voter(_carol).is_null());
     BOOST_CHECK_EQUAL(success(), comm_ctrl.vote_leader(_carol, _alice));
+    CHECK_MATCHING_OBJECT(comm_ctrl.get_voter(_carol), mvo()("votes_num", 1)("pct_sum", cfg::_100percent));
     produce_block();
     BOOST_CHECK_EQUAL(err.voted, comm_ctrl.vote_leader(_carol, _alice));
 
@@ -347,6 +362,7 @@ BOOST_FIXTURE_TEST_CASE(voteleader_test, commun_ctrl_tester) try {
     BOOST_CHECK_EQUAL(success(), comm_ctrl.unvote_leader(_carol, _alice));
     BOOST_CHECK_EQUAL(success(), comm_ctrl.vote_leader(_carol, _alice, 10  * cfg::_1percent));
     BOOST_CHECK_EQUAL(success(), comm_ctrl.vote_leader(_carol, _carol, 10  * cfg::_1percent));
+    CHECK_MATCHING_OBJECT(comm_ctrl.get_voter(_carol), mvo()("votes_num", 3)("pct_sum", 70 * cfg::_1percent));
 
     BOOST_CHECK_EQUAL(success(), comm_ctrl.reg_leader(_golos, "localhost"));
     BOOST_CHECK_EQUAL(err.votes_casted, comm_ctrl.vote_leader(_carol, _golos, 10  * cfg::_1percent));
@@ -369,6 +385,7 @@ BOOST_FIXTURE_TEST_CASE(unvotelead_test, commun_ctrl_tester) try {
     BOOST_CHECK_EQUAL(success(), point.transfer(_bob, _carol, asset(700, point._symbol)));
     BOOST_CHECK_EQUAL(success(), comm_ctrl.unvote_leader(_carol, _alice));
     BOOST_CHECK_EQUAL(comm_ctrl.get_leader(_alice)["total_weight"], 0);
+    BOOST_CHECK(comm_ctrl.get_voter(_carol).is_null());
 } FC_LOG_AND_RETHROW()
 
 BOOST_FIXTURE_TEST_CASE(clearvotes_test, commun_ctrl_tester) try {
@@ -408,6 +425,9 @@ BOOST_FIXTURE_TEST_CASE(clearvotes_test, commun_ctrl_tester) try {
 
     BOOST_CHECK_EQUAL(err.there_are_votes, comm_ctrl.unreg_leader(_alice));
     BOOST_CHECK_EQUAL(success(), comm_ctrl.clear_votes(_alice));
+    for (size_t u = 0; u < votes_num; u++) {
+        BOOST_CHECK(comm_ctrl.get_voter(user_name(u)).is_null());
+    }
     BOOST_CHECK_EQUAL(success(), comm_ctrl.unreg_leader(_alice));
 
 } FC_LOG_AND_RETHROW()
@@ -425,6 +445,11 @@ BOOST_FIXTURE_TEST_CASE(leaders_reward_test, commun_ctrl_tester) try {
 
     comm_ctrl.prepare({_bob}, _bob);
     BOOST_CHECK_EQUAL(comm_ctrl.get_all_leaders().size(), 1);
+    CHECK_MATCHING_OBJECT(comm_ctrl.get_stat(), mvo()
+        ("top_weight", supply)
+        ("top_num", 1)
+        ("leaders_num", cfg::def_comm_leaders_num)
+    );
 
     produce_block();
     produce_block(fc::seconds(cfg::def_reward_leaders_period - 3 * block_interval));
@@ -448,9 +473,12 @@ BOOST_FIXTURE_TEST_CASE(leaders_reward_test, commun_ctrl_tester) try {
     produce_block();
     BOOST_CHECK_EQUAL(err.nothing_to_claim, comm_ctrl.claim(_bob));
     BOOST_CHECK_EQUAL(err.leader_not_found, comm_ctrl.claim(_alice));
+    BOOST_CHECK(comm_ctrl.get_leader(_bob)["in_top"].as<bool>());
 
     supply += emitted;
     BOOST_CHECK_EQUAL(success(), comm_ctrl.unvote_leader(_bob, _bob));
+    BOOST_CHECK(!comm_ctrl.get_leader(_bob)["in_top"].as<bool>());
+    BOOST_CHECK_EQUAL(comm_ctrl.get_stat()["top_weight"].as<uint64_t>(), 0);
     produce_block();
     produce_block(fc::seconds(cfg::def_reward_leaders_period - 3 * block_interval));
     BOOST_CHECK_EQUAL(success(), point.open(_alice));
@@ -487,6 +515,96 @@ BOOST_FIXTURE_TEST_CASE(leaders_reward_test, commun_ctrl_tester) try {
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE(top_boundary_test, commun_ctrl_tester) try {
+    BOOST_TEST_MESSAGE("top_boundary_test");
+    init();
+    BOOST_CHECK_EQUAL(success(), point.setparams(_golos, point.args()("transfer_fee", 0)("min_transfer_fee_points", 0)));
+    BOOST_CHECK_EQUAL(success(), community.setparams(_golos, point_code, community.args()("leaders_num", 2)));
+
+    int64_t base = supply / 10;
+    std::vector<std::pair<name, int64_t>> balances = {{_carol, 3 * base}, {_bob, 2 * base}, {_alice, base}};
+    for (auto& b : balances) {
+        BOOST_CHECK_EQUAL(success(), point.open(b.first));
+        BOOST_CHECK_EQUAL(success(), point.transfer(_golos, b.first, asset(b.second, point._symbol)));
+        BOOST_CHECK_EQUAL(success(), comm_ctrl.reg_leader(b.first, "localhost"));
+        BOOST_CHECK_EQUAL(success(), comm_ctrl.vote_leader(b.first, b.first));
+    }
+    auto check_top = [&](std::set<name> top, int64_t top_weight) {
+        for (auto& b : balances) {
+            BOOST_CHECK_EQUAL(comm_ctrl.get_leader(b.first)["in_top"].as<bool>(), top.count(b.first) > 0);
+        }
+        BOOST_CHECK_EQUAL(comm_ctrl.get_stat()["top_num"].as<uint64_t>(), top.size());
+        BOOST_CHECK_EQUAL(comm_ctrl.get_stat()["top_weight"].as<int64_t>(), top_weight);
+    };
+    check_top({_carol, _bob}, 5 * base);
+
+    BOOST_TEST_MESSAGE("--- a transfer moves the lightest leader of the top out");
+    BOOST_CHECK_EQUAL(success(), point.transfer(_bob, _alice, asset(3 * base / 2, point._symbol)));
+    check_top({_carol, _alice}, 3 * base + 5 * base / 2);
+
+    BOOST_TEST_MESSAGE("--- the heaviest outsider replaces a stopped leader");
+    BOOST_CHECK_EQUAL(success(), comm_ctrl.stop_leader(_carol));
+    check_top({_alice, _bob}, 5 * base / 2 + base / 2);
+    BOOST_CHECK_EQUAL(success(), comm_ctrl.start_leader(_carol));
+    check_top({_carol, _alice}, 3 * base + 5 * base / 2);
+
+    BOOST_TEST_MESSAGE("--- an unvoted leader leaves the top");
+    BOOST_CHECK_EQUAL(success(), comm_ctrl.unvote_leader(_alice, _alice));
+    check_top({_carol, _bob}, 3 * base + base / 2);
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(voteparam_test, commun_ctrl_tester) try {
+    BOOST_TEST_MESSAGE("voteparam_test");
+    init();
+    const auto gems = N(gemsperday);
+    const auto gems_per_day = [&]() { return community.get_community(point_code)["gems_per_day"].as<uint16_t>(); };
+    const auto median = [&]() { return community.get_param_median(point_code, gems); };
+    const auto def_gems = gems_per_day();
+
+    for (auto l : {_alice, _bob, _carol}) {
+        BOOST_CHECK_EQUAL(success(), point.issue(l, asset(1000, point._symbol), ""));
+        BOOST_CHECK_EQUAL(success(), comm_ctrl.reg_leader(l, "localhost"));
+        BOOST_CHECK_EQUAL(success(), comm_ctrl.vote_leader(l, l));
+    }
+    produce_block();
+
+    BOOST_TEST_MESSAGE("--- fail if not a leader or bad param");
+    BOOST_CHECK_EQUAL(err.not_a_leader(_golos), community.vote_param(_golos, point_code, gems, 20));
+    BOOST_CHECK_EQUAL(err.unknown_param, community.vote_param(_alice, point_code, N(unknown), 20));
+    BOOST_CHECK_EQUAL(err.incorrect_emission_rate, community.vote_param(_alice, point_code, N(emissionrate), 3 * cfg::_1percent));
+    BOOST_CHECK_EQUAL(err.no_param_vote, community.vote_param(_alice, point_code, gems, {}));
+
+    BOOST_TEST_MESSAGE("--- the median is applied when more than a half of leaders voted");
+    BOOST_CHECK_EQUAL(success(), community.vote_param(_alice, point_code, gems, 20));
+    CHECK_MATCHING_OBJECT(median(), mvo()("count", 1)("value", 20)("leader", _alice.to_string()));
+    BOOST_CHECK_EQUAL(def_gems, gems_per_day());
+    BOOST_CHECK_EQUAL(err.same_param_value, community.vote_param(_alice, point_code, gems, 20));
+    BOOST_CHECK_EQUAL(success(), community.vote_param(_bob, point_code, gems, 30));
+    BOOST_CHECK_EQUAL(30, gems_per_day());
+    BOOST_CHECK_EQUAL(success(), community.vote_param(_carol, point_code, gems, 5));
+    BOOST_CHECK_EQUAL(20, gems_per_day());
+    produce_block();
+
+    BOOST_TEST_MESSAGE("--- changed and removed votes move the median");
+    BOOST_CHECK_EQUAL(success(), community.vote_param(_alice, point_code, gems, 40));
+    BOOST_CHECK_EQUAL(30, gems_per_day());
+    BOOST_CHECK_EQUAL(success(), community.vote_param(_bob, point_code, gems, 1));
+    CHECK_MATCHING_OBJECT(median(), mvo()("count", 3)("value", 5)("leader", _carol.to_string()));
+    BOOST_CHECK_EQUAL(5, gems_per_day());
+    BOOST_CHECK_EQUAL(success(), community.vote_param(_carol, point_code, gems, {}));
+    CHECK_MATCHING_OBJECT(median(), mvo()("count", 2)("value", 40)("leader", _alice.to_string()));
+    BOOST_CHECK_EQUAL(40, gems_per_day());
+
+    BOOST_TEST_MESSAGE("--- votes of former leaders can be removed by anyone");
+    BOOST_CHECK_EQUAL(err.leader_in_top, community.clr_param_vote(_carol, point_code, _bob, gems));
+    BOOST_CHECK_EQUAL(success(), comm_ctrl.stop_leader(_bob));
+    BOOST_CHECK_EQUAL(success(), community.clr_param_vote(_carol, point_code, _bob, gems));
+    CHECK_MATCHING_OBJECT(median(), mvo()("count", 1)("value", 40)("leader", _alice.to_string()));
+    BOOST_CHECK_EQUAL(40, gems_per_day());
+    BOOST_CHECK_EQUAL(success(), community.vote_param(_alice, point_code, gems, {}));
+    BOOST_CHECK(median().is_null());
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE(emit_test, commun_ctrl_tester) try {
     BOOST_TEST_MESSAGE("emit_test");
     BOOST_CHECK_EQUAL(err.no_community, comm_ctrl.emit(_alice, {_alice, cfg::active_name}));
@@ -35,11 +35,13 @@ public:
         create_accounts({_code, _commun, _golos, _alice, _bob, _carol,
             cfg::token_name, cfg::point_name, cfg::list_name, cfg::control_name, cfg::gallery_name});
         produce_block();
-        install_contract(cfg::token_name, contracts::token_wasm(), contracts::token_abi());
-        install_contract(cfg::list_name, contracts::list_wasm(), contracts::list_abi());
-        install_contract(cfg::point_name, contracts::point_wasm(), contracts::point_abi());
-        install_contract(cfg::gallery_name, contracts::gallery_wasm(), contracts::gallery_abi());
-        install_contract(_code, contracts::emit_wasm(), contracts::emit_abi());
+        install_contracts({
+            {cfg::token_name, contracts::token_wasm(), contracts::token_abi()},
+            {cfg::list_name, contracts::list_wasm(), contracts::list_abi()},
+            {cfg::point_name, contracts::point_wasm(), contracts::point_abi()},
+            {cfg::gallery_name, contracts::gallery_wasm(), contracts::gallery_abi()},
+            {_code, contracts::emit_wasm(), contracts::emit_abi()}
+        });
 
         set_authority(cfg::control_name, N(changepoints), create_code_authority({cfg::point_name}), "active");
         link_authority(cfg::control_name, cfg::control_name, N(changepoints), N(changepoints));
@@ -57,13 +59,10 @@ public:
         link_authority(cfg::gallery_name, cfg::gallery_name, N(init), N(init));
 
         set_authority(cfg::point_name, cfg::issue_permission, create_code_authority({cfg::emit_name}), "active");
-        link_authority(cfg::point_name, cfg::point_name, cfg::issue_permission, N(issue));
+        link_authority(cfg::point_name, cfg::point_name, cfg::issue_permission, N(mintto));
     }
 
     void init() {
-        set_authority(_golos, cfg::transfer_permission, create_code_authority({cfg::emit_name}), cfg::active_name);
-        link_authority(_golos, cfg::point_name, cfg::transfer_permission, N(transfer));
-
         BOOST_CHECK_EQUAL(success(), point.create(_golos, asset(0, point._symbol), asset(supply * 2, point._symbol), 10000, 0));
         BOOST_CHECK_EQUAL(success(), token.create(_commun, asset(reserve * 2, token._symbol)));
         BOOST_CHECK_EQUAL(success(), token.issue(_commun, _carol, asset(reserve, token._symbol), ""));
@@ -188,8 +187,10 @@ BOOST_FIXTURE_TEST_CASE(basic_tests, commun_emit_tester) try {
     BOOST_TEST_MESSAGE("-- waiting for mosaics reward");
     produce_block();
     produce_block(fc::seconds(cfg::def_reward_mosaics_period - block_interval));
+    auto issuer_amount = point.get_amount(_golos);
     BOOST_CHECK_EQUAL(success(), emit.issuereward(point_code, cfg::gallery_name));
     BOOST_CHECK_EQUAL(mosaic_amount, point.get_amount(cfg::gallery_name));
+    BOOST_CHECK_EQUAL(issuer_amount, point.get_amount(_golos));
 } FC_LOG_AND_RETHROW()
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -58,6 +58,14 @@ public:
         return push(N(claim), signer ? signer : gem_owner, a);
     }
 
+    action_result claimall(account_name gem_owner, uint16_t max_gems, account_name signer = account_name()) {
+        return push(N(claimall), signer ? signer : gem_owner, args()
+            ("commun_code", _symbol.to_symbol_code())
+            ("gem_owner", gem_owner)
+            ("max_gems", max_gems)
+        );
+    }
+
     // TODO: removed from MVP
     // action_result hold(uint64_t tracery, account_name gem_owner, account_name gem_creator = account_name()) {
     //     auto a = args()
@@ -87,27 +95,40 @@ public:
     //         push(N(transfer), gem_owner, a);
     // }
 
-    // TODO: removed from MVP
-    // action_result provide(account_name grantor, account_name recipient, asset quantity, 
-    //                                 std::optional<uint16_t> fee = std::optional<uint16_t>()) {
-    //     auto a = args()
-    //         ("grantor", grantor)
-    //         ("recipient", recipient)
-    //         ("quantity", quantity);
-    //     if (fee.has_value()) {
-    //         a("fee", *fee);
-    //     }
-    //     return push(N(provide), grantor, a);
-    // }
+    action_result provide(account_name grantor, account_name recipient, asset quantity, 
+                                    std::optional<uint16_t> fee = std::optional<uint16_t>()) {
+        auto a = args()
+            ("grantor", grantor)
+            ("recipient", recipient)
+            ("quantity", quantity);
+        if (fee.has_value()) {
+            a("fee", *fee);
+        }
+        return push(N(provide), grantor, a);
+    }
 
-    // TODO: removed from MVP
-    // action_result advise(account_name leader, std::vector<uint64_t> favorites) { // vector is to test if duplicated
-    //     return push(N(advise), leader, args()
-    //         ("commun_code", _symbol.to_symbol_code())
-    //         ("leader", leader)
-    //         ("favorites", favorites)
-    //     );
-    // }
+    action_result advise(account_name leader, std::vector<uint64_t> favorites) { // vector is to test if duplicated
+        return push(N(advise), leader, args()
+            ("commun_code", _symbol.to_symbol_code())
+            ("leader", leader)
+            ("favorites", favorites)
+        );
+    }
+
+    action_result deactmosaics(account_name signer, uint16_t max_steps) {
+        return push(N(deactmosaics), signer, args()
+            ("commun_code", _symbol.to_symbol_code())
+            ("max_steps", max_steps)
+        );
+    }
+
+    action_result schedgems(account_name payer, uint16_t max_gems) {
+        return push(N(schedgems), payer, args()
+            ("commun_code", _symbol.to_symbol_code())
+            ("payer", payer)
+            ("max_gems", max_gems)
+        );
+    }
 
     action_result update(account_name creator, uint64_t tracery) {
         return push(N(update), creator, args()
@@ -7,10 +7,15 @@
 #include "contracts.hpp"
 #include "../commun.point/include/commun.point/config.hpp"
 #include "../commun.gallery/include/commun.gallery/config.hpp"
+#include "../commun.gallery/include/commun.gallery/pool.hpp"
+#include "../commun.gallery/include/commun.gallery/advice.hpp"
 #include "../commun.emit/include/commun.emit/config.hpp"
 #include "../commun.list/include/commun.list/config.hpp"
 using int128_t = fc::int128_t;
 #include "../include/commun/util.hpp"
+#include "audit/commun_audit.hpp"
+#include "genesis/commun_genesis.hpp"
+#include <fc/filesystem.hpp>
 
 namespace cfg = commun::config;
 using namespace eosio::testing;
@@ -48,12 +53,14 @@ public:
         create_accounts({_commun, _golos, _alice, _bob, _carol,
             cfg::token_name, cfg::control_name, cfg::point_name, cfg::list_name, cfg::gallery_name, cfg::emit_name});
         produce_block();
-        install_contract(cfg::control_name, contracts::ctrl_wasm(), contracts::ctrl_abi());
-        install_contract(cfg::point_name, contracts::point_wasm(), contracts::point_abi());
-        install_contract(cfg::emit_name, contracts::emit_wasm(), contracts::emit_abi());
-        install_contract(cfg::token_name, contracts::token_wasm(), contracts::token_abi());
-        install_contract(cfg::list_name, contracts::list_wasm(), contracts::list_abi());
-        install_contract(_code, contracts::gallery_wasm(), contracts::gallery_abi());
+        install_contracts({
+            {cfg::control_name, contracts::ctrl_wasm(), contracts::ctrl_abi()},
+            {cfg::point_name, contracts::point_wasm(), contracts::point_abi()},
+            {cfg::emit_name, contracts::emit_wasm(), contracts::emit_abi()},
+            {cfg::token_name, contracts::token_wasm(), contracts::token_abi()},
+            {cfg::list_name, contracts::list_wasm(), contracts::list_abi()},
+            {_code, contracts::gallery_wasm(), contracts::gallery_abi()}
+        });
 
         set_authority(cfg::emit_name, cfg::reward_perm_name, create_code_authority({_code}), "active");
         link_authority(cfg::emit_name, cfg::emit_name, cfg::reward_perm_name, N(issuereward));
@@ -68,7 +75,7 @@ public:
         link_authority(cfg::gallery_name, cfg::gallery_name, N(init), N(init));
 
         set_authority(cfg::point_name, cfg::issue_permission, create_code_authority({cfg::emit_name}), "active");
-        link_authority(cfg::point_name, cfg::point_name, cfg::issue_permission, N(issue));
+        link_authority(cfg::point_name, cfg::point_name, cfg::issue_permission, N(mintto));
 
         set_authority(cfg::gallery_name, cfg::transfer_permission, create_code_authority({_code}), "active");
         link_authority(cfg::gallery_name, cfg::point_name, cfg::transfer_permission, N(transfer));
@@ -90,9 +97,6 @@ public:
         BOOST_CHECK_EQUAL(success(), token.create(_commun, asset(reserve, token._symbol)));
         BOOST_CHECK_EQUAL(success(), token.issue(_commun, _carol, asset(reserve, token._symbol), ""));
 
-        set_authority(_golos, cfg::transfer_permission, create_code_authority({cfg::emit_name}), cfg::active_name);
-        link_authority(_golos, cfg::point_name, cfg::transfer_permission, N(transfer));
-
         BOOST_CHECK_EQUAL(success(), point.create(_golos, asset(0, point._symbol), asset(supply * 2, point._symbol), 10000, 1));
         BOOST_CHECK_EQUAL(success(), point.setfreezer(cfg::gallery_name));
 
@@ -108,6 +112,44 @@ public:
             ("opuses", std::set<opus_info>{gallery.default_opus} )));
     }
 
+    // writes the tables checked by commun_audit in the layout of mongoexport, returns the options to audit them
+    commun::audit::options dump_tables(const fc::path& dir, std::vector<account_name> accounts) {
+        auto code_scope = point_code.to_string();
+        auto write = [&](account_name code, name tbl, const std::vector<std::pair<uint64_t, std::string>>& scopes) {
+            auto db = code.to_string();
+            std::replace(db.begin(), db.end(), '.', '_');
+            auto db_dir = dir / ("_CYBERWAY_" + db);
+            fc::create_directories(db_dir);
+            std::ofstream out((db_dir / (tbl.to_string() + ".json")).generic_string(), std::ios::app);
+            for (const auto& scope : scopes) {
+                for (const auto& row : get_all_chaindb_rows(code, scope.first, tbl, false)) {
+                    fc::mutable_variant_object o(row.get_object());
+                    out << fc::json::to_string(o("scope", scope.second)) << "\n";
+                }
+            }
+        };
+        std::vector<std::pair<uint64_t, std::string>> account_scopes;
+        for (auto a : accounts) {
+            account_scopes.emplace_back(a.value, a.to_string());
+        }
+        std::vector<std::pair<uint64_t, std::string>> code_scopes = {{point_code.value, code_scope}};
+        write(cfg::point_name, N(stat), code_scopes);
+        write(cfg::point_name, N(accounts), account_scopes);
+        write(cfg::point_name, N(order), code_scopes);
+        write(_code, N(stat), code_scopes);
+        write(_code, N(statshard), code_scopes);
+        write(_code, N(mosaic), code_scopes);
+        write(_code, N(gem), code_scopes);
+        write(_code, N(inclusion), account_scopes);
+        write(cfg::control_name, N(stat), code_scopes);
+        write(cfg::control_name, N(leader), code_scopes);
+
+        commun::audit::options opts;
+        opts.dir = dir.generic_string();
+        opts.threads = 2;
+        return opts;
+    }
+
     int64_t supply;
     int64_t reserve;
     uint16_t royalty;
@@ -150,59 +192,73 @@ BOOST_FIXTURE_TEST_CASE(basic_tests, commun_gallery_tester) try {
 
 } FC_LOG_AND_RETHROW()
 
-// TODO: removed from MVP
-// BOOST_FIXTURE_TEST_CASE(provide_test, commun_gallery_tester) try {
-//     BOOST_TEST_MESSAGE("Provide test");
-//     init();
-//     BOOST_CHECK_EQUAL(success(), community.setsysparams( point_code, community.sysparams()("refill_gem_enabled", true)));
-//     int64_t init_amount = supply / 2;
-//     uint16_t fee = 5000;
-
-//     BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _alice, asset(init_amount, point._symbol)));
-//     BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _carol, asset(init_amount, point._symbol)));
-//     BOOST_CHECK_EQUAL(success(), point.open(_bob));
-
-//     BOOST_CHECK_EQUAL(errgallery.no_points_provided, gallery.provide(_alice, _carol, asset(0, point._symbol)));
-//     BOOST_CHECK_EQUAL(errgallery.symbol_precision, gallery.provide(_alice, _carol, asset(0, _point_wrong)));
-//     BOOST_CHECK_EQUAL(success(), gallery.provide(_alice, _bob, asset(init_amount, point._symbol), fee));
-//     BOOST_CHECK_EQUAL(success(), gallery.provide(_carol, _bob, asset(init_amount, point._symbol), fee));
-
-//     BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_bob, 1, gallery.default_opus.name, asset(0, point._symbol), royalty, {std::make_pair(_alice, init_amount / 2)}));
-//     produce_block();
-//     produce_block(fc::seconds(cfg::def_reward_mosaics_period - block_interval));
-
-//     BOOST_CHECK_EQUAL(success(), gallery.addtomosaic(1, asset(0, point._symbol), false, _bob, {std::make_pair(_alice, init_amount / 2)}));
-//     produce_block();
-//     produce_block(fc::seconds(cfg::def_reward_mosaics_period - block_interval));
-
-//     //while creating this mosaic - the previous one receives a reward
-//     BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_bob, 2, gallery.default_opus.name, asset(0, point._symbol), royalty, {std::make_pair(_carol, init_amount)}));
-
-//     produce_block();
-//     auto archive_date = cfg::def_collection_period + cfg::def_moderation_period + cfg::def_extra_reward_period;
-//     produce_block(fc::seconds(archive_date - (2 * cfg::def_reward_mosaics_period) - block_interval));
-
-//     BOOST_CHECK_EQUAL(errgallery.overdrawn_balance, gallery.createmosaic(_bob, 3, gallery.default_opus.name, asset(0, point._symbol), royalty, {std::make_pair(_alice, init_amount)}));
-//     produce_block();
-//     BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_bob, 3, gallery.default_opus.name, asset(0, point._symbol), royalty, {std::make_pair(_alice, init_amount)}));
-//     produce_block();
-//     auto reward = point.get_amount(_bob) * 2;
-//     BOOST_CHECK(reward > 0);
-//     BOOST_TEST_MESSAGE("--- reward = " << reward);
-//     BOOST_CHECK_EQUAL((point.get_amount(_alice) - init_amount), reward / 2); // fee == 50%
+BOOST_FIXTURE_TEST_CASE(provide_test, commun_gallery_tester) try {
+    BOOST_TEST_MESSAGE("Provide test");
+    init();
+    int64_t init_amount = supply / 2;
+    int64_t provided = init_amount / 4;
+    uint16_t fee = 5000;
 
-//     produce_block(fc::seconds(cfg::forced_chopping_delay + cfg::def_reward_mosaics_period - block_interval));
-//     BOOST_CHECK_EQUAL(gallery.get_frozen(_carol), init_amount);
+    BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _alice, asset(init_amount, point._symbol)));
+    BOOST_CHECK_EQUAL(success(), point.open(_bob));
+    BOOST_CHECK_EQUAL(success(), point.open(_carol));
+
+    BOOST_CHECK_EQUAL(errgallery.no_points_provided, gallery.provide(_alice, _carol, asset(0, point._symbol)));
+    BOOST_CHECK_EQUAL(errgallery.symbol_precision, gallery.provide(_alice, _carol, asset(0, _point_wrong)));
+    BOOST_CHECK_EQUAL(success(), gallery.provide(_alice, _carol, asset(provided, point._symbol), fee));
+    BOOST_CHECK_EQUAL(success(), gallery.provide(_alice, _bob, asset(provided, point._symbol), fee));
+
+    auto check_pool = [&](std::map<account_name, std::pair<int64_t, int64_t> > slices) { // recipient -> (total, frozen)
+        auto pool = get_provider_pool(_code, _point, _alice);
+        BOOST_TEST_REQUIRE(!pool.is_null());
+        int64_t frozen = 0;
+        auto slice = slices.begin();
+        BOOST_TEST_REQUIRE(pool["slices"].get_array().size() == slices.size());
+        for (const auto& s : pool["slices"].get_array()) { // sorted by recipient
+            BOOST_CHECK_EQUAL(s["recipient"].as<account_name>(), slice->first);
+            BOOST_CHECK_EQUAL(s["fee"].as<uint16_t>(), fee);
+            BOOST_CHECK_EQUAL(s["total"].as<int64_t>(), slice->second.first);
+            BOOST_CHECK_EQUAL(s["frozen"].as<int64_t>(), slice->second.second);
+            frozen += slice->second.second;
+            ++slice;
+        }
+        BOOST_CHECK_EQUAL(pool["frozen"].as<int64_t>(), frozen);
+        BOOST_CHECK_EQUAL(gallery.get_frozen(_alice), frozen);
+    };
+    check_pool({{_bob, {provided, 0}}, {_carol, {provided, 0}}});
 
-//     produce_block(fc::seconds(cfg::def_reward_mosaics_period));
+    BOOST_TEST_MESSAGE("--- votes with provided points freeze them in the slices");
+    int64_t bob_points = provided / 2;
+    int64_t carol_points = provided / 4;
+    BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_bob, 1, gallery.default_opus.name, asset(0, point._symbol), royalty, {std::make_pair(_alice, bob_points)}));
+    BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_carol, 2, gallery.default_opus.name, asset(0, point._symbol), royalty, {std::make_pair(_alice, carol_points)}));
+    check_pool({{_bob, {provided, bob_points}}, {_carol, {provided, carol_points}}});
 
-//     BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_bob, 4, gallery.default_opus.name, asset(reward / 2, point._symbol), royalty));
-//     BOOST_CHECK(point.get_amount(_bob) > reward / 2);
+    BOOST_CHECK_EQUAL(errgallery.not_enough_provided, gallery.addtomosaic(1, asset(0, point._symbol), false, _bob, {std::make_pair(_alice, provided - bob_points + 1)}));
+    BOOST_CHECK_EQUAL(success(), gallery.addtomosaic(1, asset(0, point._symbol), false, _bob, {std::make_pair(_alice, provided - bob_points)}));
+    check_pool({{_bob, {provided, provided}}, {_carol, {provided, carol_points}}});
 
-//     //carol points are unfrozen now, but she did not receive a reward
-//     BOOST_CHECK_EQUAL(point.get_amount(_carol), init_amount);
-//     BOOST_CHECK_EQUAL(gallery.get_frozen(_carol), 0);
-// } FC_LOG_AND_RETHROW()
+    BOOST_TEST_MESSAGE("--- chopped gems unfreeze the slices and add the rewards to them");
+    produce_block();
+    produce_block(fc::seconds(cfg::def_collection_period + cfg::def_moderation_period + cfg::def_extra_reward_period));
+    BOOST_CHECK_EQUAL(success(), gallery.claim(1, _alice, _bob));
+    BOOST_CHECK_EQUAL(success(), gallery.claim(2, _alice, _carol));
+    BOOST_CHECK(get_gem(_code, _point, 1, _bob, _alice).is_null());
+    BOOST_CHECK(get_gem(_code, _point, 2, _carol, _alice).is_null());
+    auto pool = get_provider_pool(_code, _point, _alice);
+    auto bob_reward = pool["slices"][0]["total"].as<int64_t>() - provided;
+    auto carol_reward = pool["slices"][1]["total"].as<int64_t>() - provided;
+    BOOST_CHECK_GE(bob_reward, 0);
+    BOOST_CHECK_GE(carol_reward, 0);
+    BOOST_CHECK_EQUAL(point.get_amount(_alice), init_amount + bob_reward + carol_reward);
+    check_pool({{_bob, {provided + bob_reward, 0}}, {_carol, {provided + carol_reward, 0}}});
+
+    BOOST_TEST_MESSAGE("--- the pool is erased with its last slice");
+    BOOST_CHECK_EQUAL(success(), gallery.provide(_alice, _bob, asset(0, point._symbol)));
+    check_pool({{_carol, {provided + carol_reward, 0}}});
+    BOOST_CHECK_EQUAL(success(), gallery.provide(_alice, _carol, asset(0, point._symbol)));
+    BOOST_CHECK(get_provider_pool(_code, _point, _alice).is_null());
+} FC_LOG_AND_RETHROW()
 
 BOOST_FIXTURE_TEST_CASE(reward_the_top_test, commun_gallery_tester) try {
     BOOST_TEST_MESSAGE("Reward the top");
@@ -309,41 +365,62 @@ BOOST_FIXTURE_TEST_CASE(addtomosaic_tests, commun_gallery_tester) try {
     BOOST_CHECK_EQUAL(success(), gallery.addtomosaic(1, asset(point.get_amount(_carol), point._symbol), false, _carol));
 } FC_LOG_AND_RETHROW()
 
-// TODO: removed from MVP
-// BOOST_FIXTURE_TEST_CASE(advise_test, commun_gallery_tester) try {
-//     BOOST_TEST_MESSAGE("Advise mosaic by leader testing.");
-//     uint64_t tracery = 1;
-//     BOOST_CHECK_EQUAL(errgallery.no_community, gallery.advise(_bob, {tracery}));
-//     init();
-//     int64_t init_amount = supply / 2;
-//     BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _alice, asset(init_amount, point._symbol)));
-//     BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _bob, asset(init_amount, point._symbol)));
-//     ctrl.prepare({_bob}, _alice);
-//     BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_alice, tracery, gallery.default_opus.name, asset(min_gem_points, point._symbol), royalty));
-
-//     BOOST_CHECK_EQUAL(errgallery.no_mosaic, gallery.advise(_bob, {tracery+2}));
-//     BOOST_CHECK_EQUAL(errgallery.not_a_leader(_alice), gallery.advise(_alice, {tracery}));
-
-//     std::vector<uint64_t> too_many;
-//     for (int i = 0; i < cfg::advice_weight.size() + 1; ++i) {
-//         too_many.push_back(tracery + i);
-//     }
-//     BOOST_CHECK_EQUAL(errgallery.advice_surfeit, gallery.advise(_bob, too_many));
-
-//     std::vector<uint64_t> duplicated;
-//     duplicated.push_back(tracery);
-//     duplicated.push_back(tracery);
-//     BOOST_CHECK_EQUAL(success(), gallery.advise(_bob, duplicated));
-//     produce_block();
-//     BOOST_CHECK_EQUAL(get_mosaic(_code, _point, tracery)["lead_rating"], cfg::advice_weight[0]);
-//     BOOST_CHECK_EQUAL(get_advice(_code, _point, _bob)["favorites"].as<std::set<uint64_t>>().size(), 1);
-//     BOOST_CHECK_EQUAL(errgallery.no_changes_favorites, gallery.advise(_bob, duplicated));
-
-//     BOOST_CHECK_EQUAL(success(), gallery.advise(_bob, std::vector<uint64_t>()));
-//     produce_block();
-//     BOOST_CHECK(get_advice(_code, _point, _bob).is_null());
-//     BOOST_CHECK_EQUAL(errgallery.no_changes_favorites, gallery.advise(_bob, std::vector<uint64_t>()));
-// } FC_LOG_AND_RETHROW()
+BOOST_FIXTURE_TEST_CASE(advise_test, commun_gallery_tester) try {
+    BOOST_TEST_MESSAGE("Advise mosaic by leader testing.");
+    init();
+    int64_t init_amount = supply / 2;
+    BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _alice, asset(init_amount, point._symbol)));
+    BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _bob, asset(init_amount, point._symbol)));
+    ctrl.prepare({_bob}, _alice);
+    for (uint64_t tracery = 1; tracery <= 3; tracery++) {
+        BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_alice, tracery, gallery.default_opus.name, asset(min_gem_points, point._symbol), royalty));
+    }
+    auto check_ratings = [&](const std::set<uint64_t>& favorites) {
+        auto weight = commun::advice::favorite_weight(cfg::advice_weight, favorites.size());
+        for (uint64_t tracery = 1; tracery <= 3; tracery++) {
+            BOOST_CHECK_EQUAL(get_mosaic(_code, _point, tracery)["lead_rating"].as<int64_t>(), favorites.count(tracery) ? weight : 0);
+        }
+    };
+
+    BOOST_CHECK_EQUAL(errgallery.no_mosaic, gallery.advise(_bob, {4}));
+    BOOST_CHECK_EQUAL(errgallery.not_a_leader(_alice), gallery.advise(_alice, {1}));
+
+    std::vector<uint64_t> too_many;
+    for (int i = 0; i < cfg::advice_weight.size() + 1; ++i) {
+        too_many.push_back(1 + i);
+    }
+    BOOST_CHECK_EQUAL(errgallery.advice_surfeit, gallery.advise(_bob, too_many));
+
+    BOOST_CHECK_EQUAL(success(), gallery.advise(_bob, {1, 1}));
+    produce_block();
+    check_ratings({1});
+    BOOST_CHECK_EQUAL(get_advice(_code, _point, _bob)["favorites"].as<std::set<uint64_t>>().size(), 1);
+
+    BOOST_TEST_MESSAGE("--- unchanged favorites");
+    BOOST_CHECK_EQUAL(errgallery.no_changes_favorites, gallery.advise(_bob, {1}));
+    check_ratings({1});
+
+    BOOST_TEST_MESSAGE("--- grown favorites");
+    BOOST_CHECK_EQUAL(success(), gallery.advise(_bob, {1, 2, 3}));
+    produce_block();
+    check_ratings({1, 2, 3});
+
+    BOOST_TEST_MESSAGE("--- shrunk favorites");
+    BOOST_CHECK_EQUAL(success(), gallery.advise(_bob, {3}));
+    produce_block();
+    check_ratings({3});
+
+    BOOST_TEST_MESSAGE("--- replaced favorites");
+    BOOST_CHECK_EQUAL(success(), gallery.advise(_bob, {1, 2}));
+    produce_block();
+    check_ratings({1, 2});
+
+    BOOST_CHECK_EQUAL(success(), gallery.advise(_bob, std::vector<uint64_t>()));
+    produce_block();
+    check_ratings({});
+    BOOST_CHECK(get_advice(_code, _point, _bob).is_null());
+    BOOST_CHECK_EQUAL(errgallery.no_changes_favorites, gallery.advise(_bob, std::vector<uint64_t>()));
+} FC_LOG_AND_RETHROW()
 
 BOOST_FIXTURE_TEST_CASE(claim_tests, commun_gallery_tester) try {
     BOOST_TEST_MESSAGE("claim tests");
@@ -365,6 +442,157 @@ BOOST_FIXTURE_TEST_CASE(claim_tests, commun_gallery_tester) try {
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE(claimall_tests, commun_gallery_tester) try {
+    BOOST_TEST_MESSAGE("claimall tests");
+    init();
+    int64_t init_amount = supply / 2;
+    BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _alice, asset(init_amount, point._symbol)));
+    BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _carol, asset(init_amount, point._symbol)));
+    for (uint64_t tracery = 1; tracery <= 3; tracery++) {
+        BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_alice, tracery, gallery.default_opus.name, asset(min_gem_points, point._symbol), royalty));
+        BOOST_CHECK_EQUAL(success(), gallery.addtomosaic(tracery, asset(min_gem_points, point._symbol), false, _carol));
+    }
+    produce_block();
+    BOOST_CHECK_EQUAL(errgallery.nothing_to_claim, gallery.claimall(_carol, 3));
+
+    // the mosaics get rewards while they are in the collection period
+    produce_block(fc::seconds(cfg::def_reward_mosaics_period));
+    BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_alice, 4, gallery.default_opus.name, asset(min_gem_points, point._symbol), royalty));
+    produce_block(fc::seconds(cfg::def_collection_period + cfg::def_moderation_period + cfg::def_extra_reward_period));
+    produce_blocks(2);
+
+    // the rewards and the unfrozen points of carol's gems in the first two mosaics, computed from the rows
+    int64_t rewards = 0;
+    int64_t unfrozen = 0;
+    for (uint64_t tracery = 1; tracery <= 2; tracery++) {
+        auto mosaic = get_mosaic(_code, _point, tracery);
+        auto gem = get_gem(_code, _point, tracery, _carol);
+        BOOST_TEST_REQUIRE(!gem.is_null());
+        rewards += static_cast<int64_t>(static_cast<__int128>(mosaic["reward"].as<int64_t>()) * gem["shares"].as<int64_t>() / mosaic["shares"].as<int64_t>());
+        unfrozen += gem["points"].as<int64_t>() + gem["pledge_points"].as<int64_t>();
+    }
+    BOOST_CHECK_GT(rewards, 0);
+    auto carol_balance = point.get_amount(_carol);
+    auto carol_frozen = gallery.get_frozen(_carol);
+    auto gallery_balance = point.get_amount(_code);
+    auto cur_supply = point.get_supply();
+
+    BOOST_CHECK_EQUAL(success(), gallery.claimall(_carol, 2, _bob));
+    produce_block();
+    BOOST_CHECK(get_gem(_code, _point, 1, _carol).is_null());
+    BOOST_CHECK(get_gem(_code, _point, 2, _carol).is_null());
+    BOOST_CHECK(!get_gem(_code, _point, 3, _carol).is_null());
+
+    BOOST_TEST_MESSAGE("--- carol gets the rewards of both gems, the gallery pays nothing else");
+    BOOST_CHECK_EQUAL(point.get_amount(_carol) - carol_balance, rewards);
+    BOOST_CHECK_EQUAL(carol_frozen - gallery.get_frozen(_carol), unfrozen);
+    auto issued = point.get_supply() - cur_supply;  // the reward issued to the gallery by the claim, if any
+    BOOST_CHECK_EQUAL(gallery_balance + issued - point.get_amount(_code), rewards);
+
+    BOOST_CHECK_EQUAL(success(), gallery.claimall(_carol, 2, _bob));
+    produce_block();
+    BOOST_CHECK(get_gem(_code, _point, 3, _carol).is_null());
+    BOOST_CHECK_EQUAL(errgallery.nothing_to_claim, gallery.claimall(_carol, 2, _bob));
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(claimall_postponed_tests, commun_gallery_tester) try {
+    BOOST_TEST_MESSAGE("claimall postponed tests");
+    init();
+    int64_t init_amount = supply / 2;
+    BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _alice, asset(init_amount, point._symbol)));
+    BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _carol, asset(init_amount, point._symbol)));
+    BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_alice, 1, gallery.default_opus.name, asset(min_gem_points, point._symbol), royalty));
+    BOOST_CHECK_EQUAL(success(), gallery.addtomosaic(1, asset(min_gem_points, point._symbol), false, _carol));
+
+    // the gem of the second mosaic gets the earliest claim date while the moderation period is short,
+    // and the restored period makes its mosaic claimable only after the first one
+    BOOST_CHECK_EQUAL(success(), community.setsysparams(point_code, community.sysparams()
+        ("moderation_period", cfg::def_moderation_period / 3)));
+    auto gap = cfg::def_moderation_period / 3;
+    produce_block(fc::seconds(gap));
+    BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_alice, 2, gallery.default_opus.name, asset(min_gem_points, point._symbol), royalty));
+    BOOST_CHECK_EQUAL(success(), gallery.addtomosaic(2, asset(min_gem_points, point._symbol), false, _carol));
+    BOOST_CHECK_EQUAL(success(), community.setsysparams(point_code, community.sysparams()
+        ("moderation_period", cfg::def_moderation_period)));
+    auto first_claim_date = get_gem(_code, _point, 1, _carol)["claim_date"].as<fc::time_point>();
+    auto second_claim_date = get_gem(_code, _point, 2, _carol)["claim_date"].as<fc::time_point>();
+    BOOST_CHECK(second_claim_date < first_claim_date);
+
+    produce_block(fc::seconds(cfg::def_collection_period + cfg::def_moderation_period));
+    produce_blocks(2);
+
+    BOOST_TEST_MESSAGE("--- the earliest gem is postponed, the later one is claimed");
+    BOOST_CHECK_EQUAL(success(), gallery.claimall(_carol, 2, _bob));
+    produce_block();
+    BOOST_CHECK(get_gem(_code, _point, 1, _carol).is_null());
+    auto postponed = get_gem(_code, _point, 2, _carol);
+    BOOST_TEST_REQUIRE(!postponed.is_null());
+    BOOST_CHECK(postponed["claim_date"].as<fc::time_point>() > first_claim_date);
+    BOOST_CHECK_EQUAL(errgallery.nothing_to_claim, gallery.claimall(_carol, 2, _bob));
+
+    produce_block(fc::seconds(gap));
+    BOOST_CHECK_EQUAL(success(), gallery.claimall(_carol, 2, _bob));
+    produce_block();
+    BOOST_CHECK(get_gem(_code, _point, 2, _carol).is_null());
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(deactmosaics_tests, commun_gallery_tester) try {
+    BOOST_TEST_MESSAGE("deactmosaics tests");
+    init();
+    BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _alice, asset(supply / 2, point._symbol)));
+    for (uint64_t tracery = 1; tracery <= 4; tracery++) {
+        BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_alice, tracery, gallery.default_opus.name, asset(min_gem_points, point._symbol), royalty));
+    }
+    produce_block();
+    BOOST_CHECK_EQUAL(errgallery.nothing_to_deactivate, gallery.deactmosaics(_bob, 8));
+
+    produce_block(fc::seconds(cfg::def_collection_period + cfg::def_moderation_period + cfg::def_extra_reward_period));
+    produce_blocks(2);
+
+    BOOST_CHECK_EQUAL(success(), gallery.deactmosaics(_bob, 3));
+    produce_block();
+    size_t moderate_num = 0;
+    for (uint64_t tracery = 1; tracery <= 4; tracery++) {
+        moderate_num += get_mosaic(_code, _point, tracery)["status"].as<uint8_t>() == uint8_t(MODERATE);
+    }
+    BOOST_CHECK_EQUAL(moderate_num, 3);
+
+    BOOST_CHECK_EQUAL(success(), gallery.deactmosaics(_bob, 5));
+    produce_block();
+    for (uint64_t tracery = 1; tracery <= 4; tracery++) {
+        BOOST_CHECK_EQUAL(get_mosaic(_code, _point, tracery)["status"].as<uint8_t>(), uint8_t(ARCHIVED));
+    }
+    BOOST_CHECK_EQUAL(errgallery.nothing_to_deactivate, gallery.deactmosaics(_bob, 8));
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(forced_chopping_test, commun_gallery_tester) try {
+    BOOST_TEST_MESSAGE("Forced chopping of old gems");
+    init();
+    BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _alice, asset(supply / 2, point._symbol)));
+    BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _bob, asset(supply / 2, point._symbol)));
+    BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_alice, 1, gallery.default_opus.name, asset(min_gem_points, point._symbol), royalty));
+    produce_block();
+    auto buckets = get_all_chaindb_rows(_code, _point.to_symbol_code().value, N(gembucket), false);
+    BOOST_CHECK_EQUAL(buckets.size(), 1);
+    BOOST_CHECK_EQUAL(buckets[0]["gems"].get_array().size(), 1);
+
+    produce_block(fc::seconds(cfg::def_collection_period + cfg::def_moderation_period + cfg::def_extra_reward_period +
+        cfg::forced_chopping_delay + cfg::gem_bucket_period));
+    BOOST_CHECK(!get_gem(_code, _point, 1, _alice).is_null());
+
+    BOOST_TEST_MESSAGE("--- the gem is chopped when another account votes");
+    BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_bob, 2, gallery.default_opus.name, asset(min_gem_points, point._symbol), royalty));
+    BOOST_CHECK(get_gem(_code, _point, 1, _alice).is_null());
+    BOOST_CHECK_EQUAL(gallery.get_frozen(_alice), 0);
+    BOOST_CHECK(!get_gem(_code, _point, 2, _bob).is_null());
+    buckets = get_all_chaindb_rows(_code, _point.to_symbol_code().value, N(gembucket), false);
+    BOOST_CHECK_EQUAL(buckets.size(), 1);
+
+    BOOST_TEST_MESSAGE("--- a new gallery has no gems to add to buckets");
+    BOOST_CHECK_EQUAL(get_stat(_code, _point)["unscheduled_gem_id"].as<uint64_t>(), std::numeric_limits<uint64_t>::max());
+    BOOST_CHECK_EQUAL(errgallery.all_gems_scheduled, gallery.schedgems(_bob, 10));
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE(lock_tests, commun_gallery_tester) try {
     BOOST_TEST_MESSAGE("Lock mosaic by leader testing");
     uint64_t tracery = 1;
@@ -426,4 +654,331 @@ BOOST_FIXTURE_TEST_CASE(lock_tests, commun_gallery_tester) try {
     BOOST_CHECK(get_mosaic(_code, _point, tracery).is_null());
 } FC_LOG_AND_RETHROW()
 
+
+BOOST_FIXTURE_TEST_CASE(stat_shards_test, commun_gallery_tester) try {
+    BOOST_TEST_MESSAGE("Unclaimed points are kept in the stat shards until the reward of the gallery");
+    init();
+    BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _alice, asset(supply / 2, point._symbol)));
+    uint64_t tracery = cfg::stat_shards_num + 1;
+    uint64_t shard = 1;
+    BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_alice, tracery, gallery.default_opus.name, asset(min_gem_points, point._symbol), royalty));
+    produce_block();
+    produce_block(fc::seconds(cfg::def_reward_mosaics_period - block_interval));
+    BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_alice, tracery + 1, gallery.default_opus.name, asset(min_gem_points, point._symbol), royalty));
+    auto reward = get_mosaic(_code, _point, tracery)["reward"].as<int64_t>();
+    BOOST_CHECK_GT(reward, 0);
+    auto unclaimed = get_stat(_code, _point)["unclaimed"].as<int64_t>();
+
+    BOOST_TEST_MESSAGE("--- the reward of the removed mosaic goes to its shard");
+    BOOST_CHECK(get_stat_shard(_code, _point, shard).is_null());
+    BOOST_CHECK_EQUAL(success(), gallery.claim(tracery, _alice, _alice, true)); // premature, the gem gets nothing
+    BOOST_CHECK(get_mosaic(_code, _point, tracery).is_null());
+    BOOST_CHECK_EQUAL(get_stat_shard(_code, _point, shard)["unclaimed"].as<int64_t>(), reward);
+    BOOST_CHECK_EQUAL(get_stat(_code, _point)["unclaimed"].as<int64_t>(), unclaimed);
+
+    BOOST_TEST_MESSAGE("--- the shards are folded into the stat by the next reward");
+    produce_block();
+    produce_block(fc::seconds(cfg::def_reward_mosaics_period - block_interval));
+    BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_alice, tracery + 2, gallery.default_opus.name, asset(min_gem_points, point._symbol), royalty));
+    BOOST_CHECK_EQUAL(get_stat(_code, _point)["unclaimed"].as<int64_t>(), unclaimed + reward);
+    BOOST_CHECK_EQUAL(get_stat_shard(_code, _point, shard)["unclaimed"].as<int64_t>(), 0);
+} FC_LOG_AND_RETHROW()
+
+struct test_slice {
+    account_name recipient;
+    uint16_t fee;
+    int64_t total  = 0;
+    int64_t frozen = 0;
+};
+
+struct test_pool {
+    int64_t frozen = 0;
+    std::vector<test_slice> slices;
+};
+
+BOOST_FIXTURE_TEST_CASE(provider_pool_test, commun_gallery_tester) try {
+    BOOST_TEST_MESSAGE("Provider pool bookkeeping");
+    namespace pool = commun::pool;
+    test_pool p;
+    pool::insert_slice(p.slices, test_slice{_carol, 0, 10});
+    pool::insert_slice(p.slices, test_slice{_alice, 100, 100});
+    pool::insert_slice(p.slices, test_slice{_bob, 5000, 50});
+
+    BOOST_TEST_MESSAGE("--- slices are sorted by recipient");
+    BOOST_TEST_REQUIRE(p.slices.size() == 3);
+    BOOST_CHECK_EQUAL(p.slices[0].recipient, _alice);
+    BOOST_CHECK_EQUAL(p.slices[1].recipient, _bob);
+    BOOST_CHECK_EQUAL(p.slices[2].recipient, _carol);
+    BOOST_TEST_REQUIRE(pool::get_slice(p.slices, _bob) != nullptr);
+    BOOST_CHECK_EQUAL(pool::get_slice(p.slices, _bob)->fee, 5000);
+    BOOST_CHECK(pool::get_slice(p.slices, _golos) == nullptr);
+
+    BOOST_TEST_MESSAGE("--- freezing and chopping change the slice and the pool sum");
+    BOOST_CHECK(pool::change_slice(p, _bob, 0, 30));
+    BOOST_CHECK(pool::change_slice(p, _alice, 0, 20));
+    BOOST_CHECK_EQUAL(p.frozen, 50);
+    BOOST_CHECK(pool::change_slice(p, _bob, -10, -30));
+    BOOST_CHECK_EQUAL(pool::get_slice(p.slices, _bob)->total, 40);
+    BOOST_CHECK_EQUAL(pool::get_slice(p.slices, _bob)->frozen, 0);
+    BOOST_CHECK_EQUAL(p.frozen, 20);
+    BOOST_CHECK(!pool::change_slice(p, _golos, 1, 1));
+    BOOST_CHECK_EQUAL(p.frozen, 20);
+
+    BOOST_TEST_MESSAGE("--- removed slice returns its frozen points");
+    BOOST_CHECK_EQUAL(pool::erase_slice(p.slices, _alice), 20);
+    BOOST_CHECK_EQUAL(pool::erase_slice(p.slices, _alice), 0);
+    BOOST_TEST_REQUIRE(p.slices.size() == 2);
+    BOOST_CHECK_EQUAL(p.slices[0].recipient, _bob);
+    BOOST_CHECK_EQUAL(p.slices[1].recipient, _carol);
+
+    BOOST_TEST_MESSAGE("--- a pool can serve all providers of a vote");
+    BOOST_CHECK_GE(cfg::max_pool_slices, cfg::max_providers_num);
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(advice_deltas_test, commun_gallery_tester) try {
+    BOOST_TEST_MESSAGE("Lead rating changes of advised mosaics");
+    auto deltas = [](const std::set<uint64_t>& prev, const std::set<uint64_t>& cur) {
+        std::string ret;
+        for (const auto& d : commun::advice::rating_deltas(cfg::advice_weight, prev, cur)) {
+            ret += (ret.empty() ? "" : " ") + std::to_string(d.first) + ":" + std::to_string(d.second);
+        }
+        return ret;
+    };
+    BOOST_CHECK_EQUAL(cfg::advice_weight[0], 10000);  // weights of 1, 2 and 3 favorites
+    BOOST_CHECK_EQUAL(cfg::advice_weight[1], 7071);
+    BOOST_CHECK_EQUAL(cfg::advice_weight[2], 5774);
+
+    BOOST_TEST_MESSAGE("--- first advice");
+    BOOST_CHECK_EQUAL(deltas({}, {1, 2}), "1:7071 2:7071");
+    BOOST_TEST_MESSAGE("--- unchanged set touches nothing");
+    BOOST_CHECK_EQUAL(deltas({1, 2}, {1, 2}), "");
+    BOOST_TEST_MESSAGE("--- grown set");
+    BOOST_CHECK_EQUAL(deltas({1, 2}, {1, 2, 3}), "1:-1297 2:-1297 3:5774");
+    BOOST_TEST_MESSAGE("--- shrunk set");
+    BOOST_CHECK_EQUAL(deltas({1, 2, 3}, {3}), "1:-5774 2:-5774 3:4226");
+    BOOST_TEST_MESSAGE("--- replaced mosaic of the same size set, the kept one is untouched");
+    BOOST_CHECK_EQUAL(deltas({1, 2}, {2, 5}), "1:-7071 5:7071");
+    BOOST_TEST_MESSAGE("--- removed advice");
+    BOOST_CHECK_EQUAL(deltas({3}, {}), "3:-10000");
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(typed_rows_test, commun_gallery_tester) try {
+    BOOST_TEST_MESSAGE("Typed readers return the same rows as the variant ones");
+    init();
+    BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _alice, asset(supply / 4, point._symbol)));
+    BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _carol, asset(supply / 4, point._symbol)));
+    for (uint64_t tracery = 1; tracery <= 5; tracery++) {
+        BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_alice, tracery, gallery.default_opus.name, asset(min_gem_points, point._symbol), royalty));
+        BOOST_CHECK_EQUAL(success(), gallery.addtomosaic(tracery, asset(min_gem_points * tracery, point._symbol), tracery == 5, _carol));
+    }
+    produce_block();
+
+    BOOST_TEST_MESSAGE("--- scan of all gems");
+    auto gems = get_all_chaindb_rows(_code, point_code.value, N(gem), true);
+    size_t n = 0;
+    for (const auto& g : get_gem_rows(_code, _point)) {
+        BOOST_TEST_REQUIRE(n < gems.size());
+        const auto& v = gems[n++];
+        BOOST_CHECK_EQUAL(g.id, v["id"].as<uint64_t>());
+        BOOST_CHECK_EQUAL(g.tracery, v["tracery"].as<uint64_t>());
+        BOOST_CHECK(g.claim_date == v["claim_date"].as<fc::time_point>());
+        BOOST_CHECK_EQUAL(g.points, v["points"].as<int64_t>());
+        BOOST_CHECK_EQUAL(g.shares, v["shares"].as<int64_t>());
+        BOOST_CHECK_EQUAL(g.pledge_points, v["pledge_points"].as<int64_t>());
+        BOOST_CHECK_EQUAL(g.owner, v["owner"].as<name>());
+        BOOST_CHECK_EQUAL(g.creator, v["creator"].as<name>());
+    }
+    BOOST_CHECK_EQUAL(n, 10);
+
+    BOOST_TEST_MESSAGE("--- scans from a primary key and from an index key");
+    auto from_id = gems[4]["id"].as<uint64_t>();
+    auto rows = get_gem_rows(_code, _point, from_id);
+    BOOST_CHECK_EQUAL(size_t(std::distance(rows.begin(), rows.end())), gems.size() - 4);
+    auto by_key = scan_chaindb_rows<gem_row>(_code, point_code.value, N(gem), N(bykey), std::make_pair(uint64_t(3), std::make_pair(_carol, _carol)));
+    BOOST_TEST_REQUIRE(!by_key.empty());
+    BOOST_CHECK_EQUAL(by_key.begin()->tracery, 3);
+    BOOST_CHECK_EQUAL(by_key.begin()->owner, _carol);
+
+    BOOST_TEST_MESSAGE("--- single rows");
+    BOOST_CHECK_EQUAL(point.get_balance_row(_alice)->balance.to_string(), point.get_account(_alice)["balance"].as<std::string>());
+    BOOST_CHECK(!point.get_balance_row(_bob));
+    BOOST_CHECK(get_gem_rows(_code, symbol(3, "BAD")).empty());
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(state_audit_test, commun_gallery_tester) try {
+    BOOST_TEST_MESSAGE("Audit of the state dumped from the test chain");
+    init();
+    BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _alice, asset(supply / 4, point._symbol)));
+    BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _carol, asset(supply / 4, point._symbol)));
+    for (uint64_t tracery = 1; tracery <= 3; tracery++) {
+        BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_alice, tracery, gallery.default_opus.name, asset(min_gem_points, point._symbol), royalty));
+        BOOST_CHECK_EQUAL(success(), gallery.addtomosaic(tracery, asset(min_gem_points * tracery, point._symbol), tracery == 3, _carol));
+    }
+    produce_block();
+    produce_block(fc::seconds(cfg::def_reward_mosaics_period));
+    BOOST_CHECK_EQUAL(success(), gallery.createmosaic(_carol, 4, gallery.default_opus.name, asset(min_gem_points, point._symbol), royalty));
+    produce_block(fc::seconds(cfg::def_collection_period + cfg::def_moderation_period + cfg::def_extra_reward_period));
+    produce_blocks(2);
+    BOOST_CHECK_EQUAL(success(), gallery.claim(1, _alice));
+    produce_block();
+
+    std::vector<account_name> accounts = {_commun, _golos, _alice, _bob, _carol,
+        cfg::control_name, cfg::point_name, cfg::gallery_name, cfg::emit_name, cfg::list_name, cfg::token_name};
+    fc::temp_directory dir;
+    auto opts = dump_tables(dir.path(), accounts);
+    auto r = commun::audit::run(opts);
+    BOOST_CHECK_EQUAL(r.communities, 1);
+    BOOST_CHECK_GT(r.rows, 0);
+    for (const auto& v : r.violations) {
+        BOOST_TEST_MESSAGE("--- " << v.community << ": " << v.message);
+    }
+    BOOST_CHECK(r.violations.empty());
+
+    BOOST_TEST_MESSAGE("--- an extra gem is found");
+    std::ofstream((dir.path() / "_CYBERWAY_c_gallery" / "gem.json").generic_string(), std::ios::app)
+        << "{\"id\":100,\"tracery\":2,\"points\":1,\"shares\":1,\"pledge_points\":0,\"owner\":\"carol\",\"creator\":\"carol\",\"scope\":\"" << point_code_str << "\"}\n";
+    r = commun::audit::run(opts);
+    std::set<std::string> messages;
+    for (const auto& v : r.violations) {
+        messages.insert(v.message);
+    }
+    BOOST_CHECK(messages.count("mosaic 2 gem_count: 2 != 3"));
+    BOOST_CHECK(messages.count("inclusion of carol != points in gems: " +
+        std::to_string(gallery.get_frozen(_carol)) + " != " + std::to_string(gallery.get_frozen(_carol) + 1)));
+
+    BOOST_TEST_MESSAGE("--- the result doesn't depend on the partitions");
+    for (size_t partitions : {1, 5, 16}) {
+        opts.partitions = partitions;
+        auto p = commun::audit::run(opts);
+        BOOST_CHECK_EQUAL(p.communities, 1);
+        BOOST_CHECK_EQUAL(p.violations.size(), r.violations.size());
+        for (size_t i = 0; i < std::min(p.violations.size(), r.violations.size()); i++) {
+            BOOST_CHECK_EQUAL(p.violations[i].message, r.violations[i].message);
+        }
+    }
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(genesis_rows_test, commun_gallery_tester) try {
+    BOOST_TEST_MESSAGE("Genesis rows of a snapshot");
+    BOOST_CHECK_EQUAL(success(), point.create(_golos, asset(0, point._symbol), asset(10000000000, point._symbol), 10000, 1));
+    BOOST_CHECK_EQUAL(success(), community.create(cfg::list_name, point_code, "community 1"));
+    produce_block();
+
+    fc::temp_directory dir;
+    commun::genesis::gen_params params;
+    params.snapshot = (dir.path() / "snapshot.csv").generic_string();
+    params.out = (dir.path() / "genesis-tables.json").generic_string();
+    params.time = emit.get_stat(point_code)["reward_receivers"].get_array().at(0)["time"].as_string();
+    params.threads = 2;
+    params.batch_lines = 2;
+    std::ofstream(params.snapshot)
+        << "point," << point_code_str << ",3,10000000000,10000,1,golos,community 1\n"
+        << "leader,GLS,alice\n" << "leader,GLS,bob\n"
+        << "vote,GLS,carol,alice,10000\n" << "vote,GLS,bob,alice,5000\n" << "vote,GLS,alice,bob,2000\n"
+        << "balance,GLS,golos,1000\n" << "balance,GLS,alice,200000\n" << "balance,GLS,bob,30000\n" << "balance,GLS,carol,4000\n";
+    auto s = commun::genesis::generate(params);
+    BOOST_CHECK_EQUAL(s.balances, 4);
+    BOOST_CHECK_EQUAL(s.points.at(point_code_str).supply, 235000);
+
+    std::ifstream in(params.out);
+    std::string tables((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    tables = "[" + tables.substr(0, tables.find_last_of(',')) + "]";  // the entries end with commas
+
+    // the genesis format of assets isn't accepted by the abi serializer
+    std::function<variant(const variant&)> to_abi_format = [&](const variant& v) -> variant {
+        if (v.is_array()) {
+            variants ret;
+            for (const auto& item : v.get_array()) {
+                ret.push_back(to_abi_format(item));
+            }
+            return ret;
+        }
+        if (!v.is_object()) {
+            return v;
+        }
+        const auto& o = v.get_object();
+        if (o.contains("_amount")) {
+            return asset(o["_amount"].as_int64(), symbol(o["_decs"].as_uint64(), o["_sym"].as_string().c_str())).to_string();
+        }
+        mutable_variant_object ret;
+        for (const auto& field : o) {
+            ret(field.key(), to_abi_format(field.value()));
+        }
+        return ret;
+    };
+    auto normalize = [&](account_name code, const std::string& type, const variant& v) {
+        const auto& abi = _abis.at(code);
+        return fc::json::to_string(abi.binary_to_variant(type, abi.variant_to_binary(type, v, abi_serializer_max_time), abi_serializer_max_time));
+    };
+
+    BOOST_TEST_MESSAGE("--- rows are serialized by the ABIs");
+    std::map<std::tuple<std::string, std::string, std::string, uint64_t>, std::string> rows;
+    for (const auto& entry : fc::json::from_string(tables).get_array()) {
+        account_name code(entry["code"].as_string());
+        auto table = entry["table"].as_string();
+        auto type = entry["abi_type"].as_string();
+        BOOST_CHECK_EQUAL(_abis.at(code).get_table_type(table), type);
+        auto db = code.to_string();
+        std::replace(db.begin(), db.end(), '.', '_');
+        fc::create_directories(dir.path() / "dump" / ("_CYBERWAY_" + db));
+        std::ofstream dump((dir.path() / "dump" / ("_CYBERWAY_" + db) / (table + ".json")).generic_string(), std::ios::app);
+        for (const auto& row : entry["rows"].get_array()) {
+            std::string data;
+            BOOST_CHECK_NO_THROW(data = normalize(code, type, to_abi_format(row["data"])));
+            rows[std::make_tuple(code.to_string(), table, row["scope"].as_string(), row["pk"].as_uint64())] = data;
+            dump << fc::json::to_string(mutable_variant_object(row["data"].get_object())("scope", row["scope"])) << "\n";
+        }
+    }
+
+    BOOST_TEST_MESSAGE("--- rows are the same as the ones created by the actions");
+    auto check_row = [&](account_name code, const std::string& table, const std::string& scope, uint64_t pk, const variant& created) {
+        auto row = rows.find(std::make_tuple(code.to_string(), table, scope, pk));
+        BOOST_REQUIRE(row != rows.end());
+        BOOST_CHECK_EQUAL(row->second, normalize(code, _abis.at(code).get_table_type(table), created));
+    };
+    check_row(cfg::point_name, "param", cfg::point_name.to_string(), point_code.value, point.get_params());
+    check_row(cfg::list_name, "dapp", cfg::list_name.to_string(), 0, get_chaindb_struct(cfg::list_name, cfg::list_name.value, N(dapp), 0, "dapp"));
+    check_row(cfg::list_name, "community", cfg::list_name.to_string(), point_code.value, community.get_community(point_code));
+    check_row(cfg::emit_name, "stat", point_code_str, point_code.value, emit.get_stat(point_code));
+    check_row(_code, "stat", point_code_str, point_code.value, get_stat(_code, _point));
+
+    BOOST_TEST_MESSAGE("--- rows pass the audit");
+    commun::audit::options opts;
+    opts.dir = (dir.path() / "dump").generic_string();
+    opts.threads = 2;
+    auto r = commun::audit::run(opts);
+    BOOST_CHECK_EQUAL(r.communities, 1);
+    for (const auto& v : r.violations) {
+        BOOST_TEST_MESSAGE("--- " << v.community << ": " << v.message);
+    }
+    BOOST_CHECK(r.violations.empty());
+} FC_LOG_AND_RETHROW()
+
+// c.gallery and c.publication share the gallery engine. The sizes of their modules are checked against the budgets
+// set at the configuration of the tests (see GALLERY_WASM_SIZE); the instantiation time depends on the host and is only reported
+BOOST_FIXTURE_TEST_CASE(module_size_benchmark, commun_gallery_tester) try {
+    BOOST_TEST_MESSAGE("Size and instantiation time of the gallery modules");
+    auto measure = [&](account_name acc, const std::vector<uint8_t>& wasm, const std::vector<char>& abi, size_t budget) {
+        if (budget) {
+            BOOST_CHECK_LE(wasm.size(), budget);
+        }
+        create_accounts({acc});
+        produce_block();
+        install_contract(acc, wasm, abi);
+        auto init = [&]() {
+            auto started = fc::time_point::now();
+            push_action(acc, N(init), acc, mvo()("commun_code", "BENCH"));  // the result doesn't matter
+            auto elapsed = (fc::time_point::now() - started).count();
+            produce_block();
+            return elapsed;
+        };
+        auto cold = init();  // the first action instantiates the module
+        auto warm = init();
+        BOOST_TEST_MESSAGE("--- " << acc << ": " << wasm.size() << " bytes (budget " << (budget ? std::to_string(budget) : "isn't set")
+            << "), cold action " << cold << " us, warm action " << warm << " us");
+    };
+    measure(N(bench.gall), contracts::gallery_wasm(), contracts::gallery_abi(), gallery_wasm_budget);
+    measure(N(bench.publ), contracts::publication_wasm(), contracts::publication_abi(), publication_wasm_budget);
+} FC_LOG_AND_RETHROW()
+
 BOOST_AUTO_TEST_SUITE_END()
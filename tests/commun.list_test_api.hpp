@@ -59,6 +59,33 @@ struct commun_list_api: base_contract_api {
         );
     }
 
+    action_result vote_param(name leader, symbol_code commun_code, name param, std::optional<int64_t> value) {
+        auto a = args()
+            ("commun_code", commun_code)
+            ("leader", leader)
+            ("param", param);
+        if (value) {
+            a("value", *value);
+        }
+        return push(N(voteparam), leader, a);
+    }
+
+    action_result clr_param_vote(name signer, symbol_code commun_code, name leader, name param) {
+        return push(N(clrparamvote), signer, args()
+            ("commun_code", commun_code)
+            ("leader", leader)
+            ("param", param)
+        );
+    }
+
+    variant get_community(symbol_code commun_code) const {
+        return get_struct(_code, N(community), commun_code.value, "community");
+    }
+
+    variant get_param_median(symbol_code commun_code, name param) const {
+        return get_struct(commun_code.value, N(parammedian), param.value, "param_median");
+    }
+
     action_result follow(symbol_code commun_code, name follower, name client) {
         return push_maybe_msig(N(follow), follower, args()
             ("commun_code", commun_code)
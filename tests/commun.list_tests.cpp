@@ -28,9 +28,11 @@ public:
         create_accounts({_commun, _golos, _alice, _bob, _carol, _nicolas, _client,
             cfg::control_name, cfg::point_name, cfg::list_name, cfg::emit_name, cfg::gallery_name});
         produce_block();
-        install_contract(cfg::point_name, contracts::point_wasm(), contracts::point_abi());
-        install_contract(cfg::gallery_name, contracts::gallery_wasm(), contracts::gallery_abi());
-        install_contract(cfg::list_name, contracts::list_wasm(), contracts::list_abi());
+        install_contracts({
+            {cfg::point_name, contracts::point_wasm(), contracts::point_abi()},
+            {cfg::gallery_name, contracts::gallery_wasm(), contracts::gallery_abi()},
+            {cfg::list_name, contracts::list_wasm(), contracts::list_abi()}
+        });
         
         set_authority(cfg::emit_name, N(init), create_code_authority({cfg::list_name}), "active");
         link_authority(cfg::emit_name, cfg::emit_name, N(init), N(init));
@@ -26,8 +26,10 @@ public:
         , point2({this, _code, _point2}) {
         create_accounts({_dapp, _gls_com, _tst_com, _alice, _bob, _carol, cfg::token_name, cfg::point_name});
         produce_block();
-        install_contract(cfg::token_name, contracts::token_wasm(), contracts::token_abi());
-        install_contract(_code, contracts::point_wasm(), contracts::point_abi());
+        install_contracts({
+            {cfg::token_name, contracts::token_wasm(), contracts::token_abi()},
+            {_code, contracts::point_wasm(), contracts::point_abi()}
+        });
     }
 
 protected:
@@ -93,6 +95,11 @@ public:
         const string period_le0 = amsg("period must be > 0");
         const string period_gt_max = amsg("period must be <= " + std::to_string(cfg::safe_max_delay));
         const string period_le_cur = amsg("new unlock time must be greater than current");
+        const string safes_counted = amsg("Safes count is up to date");
+        const string all_safes_counted = amsg("Safes are already counted");
+        const string max_le0 = amsg("max must be positive");
+        const string no_ready_mods = amsg("No ready safe mods");
+        const string nothing_to_sweep = amsg("Nothing to sweep");
     } err;
 };
 
@@ -138,8 +145,11 @@ BOOST_FIXTURE_TEST_CASE(disable, commun_point_safe_tester) try {
     BOOST_CHECK_EQUAL(err.disabled, point.disable_safe(_bob, mod_id));
 
     BOOST_TEST_MESSAGE("--- enable for " << point.name());
+    BOOST_CHECK(point.get_global_lock(_bob).is_null());
     BOOST_CHECK_EQUAL(success(), point.enable_safe(_bob, 0, _delay));
     CHECK_MATCHING_OBJECT(point.get_safe(_bob), point.make_safe(0, _delay));
+    BOOST_CHECK_EQUAL(point.get_global_lock(_bob)["safes"].as<uint16_t>(), 1);
+    BOOST_CHECK_EQUAL(err.safes_counted, point.recount_safes(_bob, _alice, _alice));
     produce_block();
 
     BOOST_TEST_MESSAGE("--- still fail for " << point2.name());
@@ -171,6 +181,7 @@ BOOST_FIXTURE_TEST_CASE(disable, commun_point_safe_tester) try {
     BOOST_CHECK_EQUAL(err.disabled, point.disable_safe(_bob, mod_id));
     BOOST_CHECK(point.get_safe(_bob).is_null());
     BOOST_CHECK(point.get_safe_mod(_bob, mod_id).is_null());
+    BOOST_CHECK(point.get_global_lock(_bob).is_null());
 
     BOOST_TEST_MESSAGE("--- fail on re-enabling with existing mod");
     BOOST_CHECK_EQUAL(err.have_mods, point.enable_safe(_bob, 0, _delay));
@@ -182,6 +193,7 @@ BOOST_FIXTURE_TEST_CASE(disable, commun_point_safe_tester) try {
     BOOST_CHECK_EQUAL(success(), point.cancel_safe_mod(_bob, mod2_id));
     BOOST_CHECK_EQUAL(success(), point.enable_safe(_bob, 0, _delay));
     CHECK_MATCHING_OBJECT(point.get_safe(_bob), point.make_safe(0, _delay));
+    BOOST_CHECK_EQUAL(point.get_global_lock(_bob)["safes"].as<uint16_t>(), 2);
 } FC_LOG_AND_RETHROW()
 
 BOOST_FIXTURE_TEST_CASE(lock_unlock, commun_point_safe_tester) try {
@@ -485,6 +497,74 @@ BOOST_FIXTURE_TEST_CASE(apply_cancel, commun_point_safe_tester) try {
     // change params requirements on apply already tested in "modify"
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE(apply_ready, commun_point_safe_tester) try {
+    BOOST_TEST_MESSAGE("Apply ready mods and sweep stale ones");
+    init();
+    const double one = 1;
+    const auto mod1 = N(mod1), mod2 = N(mod2), mod3 = N(mod3), mod4 = N(mod4), dis = N(dis);
+    BOOST_CHECK_EQUAL(success(), point.enable_safe(_bob, 0, _delay));
+    BOOST_CHECK_EQUAL(success(), point2.enable_safe(_bob, 0, _delay));
+
+    BOOST_TEST_MESSAGE("--- fail on bad params or if nothing to apply");
+    BOOST_CHECK_EQUAL(err.max_le0, point.apply_ready(_bob, 0));
+    BOOST_CHECK_EQUAL(err.max_le0, point.sweep_mods(_bob, 0, _carol));
+    BOOST_CHECK_EQUAL(err.no_ready_mods, point.apply_ready(_bob, 10));
+
+    BOOST_TEST_MESSAGE("--- apply only ready mods of both safes");
+    BOOST_CHECK_EQUAL(success(), point.unlock_safe(_bob, mod1, one));
+    BOOST_CHECK_EQUAL(success(), point2.unlock_safe(_bob, mod2, one));
+    const auto blocks = commun::seconds_to_blocks(_delay);
+    produce_blocks(blocks / 2);
+    BOOST_CHECK_EQUAL(success(), point.unlock_safe(_bob, mod3, one));
+    BOOST_CHECK_EQUAL(err.no_ready_mods, point.apply_ready(_bob, 10));
+    produce_blocks(blocks - blocks / 2);
+    BOOST_CHECK_EQUAL(success(), point.apply_ready(_bob, 10));
+    CHECK_MATCHING_OBJECT(point.get_safe(_bob), point.make_safe(one, _delay));
+    CHECK_MATCHING_OBJECT(point2.get_safe(_bob), point2.make_safe(one, _delay));
+    BOOST_CHECK(point.get_safe_mod(_bob, mod1).is_null());
+    BOOST_CHECK(point.get_safe_mod(_bob, mod2).is_null());
+    BOOST_CHECK(!point.get_safe_mod(_bob, mod3).is_null());
+    BOOST_CHECK_EQUAL(err.nothing_to_sweep, point.sweep_mods(_bob, 10, _carol));
+
+    BOOST_TEST_MESSAGE("--- mods of a safe disabled in the same pass are removed");
+    BOOST_CHECK_EQUAL(success(), point2.disable_safe(_bob, dis));
+    BOOST_CHECK_EQUAL(success(), point2.unlock_safe(_bob, mod4, one));
+    produce_blocks(blocks);
+    BOOST_CHECK_EQUAL(success(), point.apply_ready(_bob, 10));
+    CHECK_MATCHING_OBJECT(point.get_safe(_bob), point.make_safe(one + one, _delay));
+    BOOST_CHECK(point2.get_safe(_bob).is_null());
+    BOOST_CHECK(point.get_safe_mod(_bob, mod3).is_null());
+    BOOST_CHECK(point.get_safe_mod(_bob, dis).is_null());
+    BOOST_CHECK(point.get_safe_mod(_bob, mod4).is_null());
+    BOOST_CHECK_EQUAL(point.get_global_lock(_bob)["safes"].as<uint16_t>(), 1);
+
+    BOOST_TEST_MESSAGE("--- mods are applied in the order they became ready");
+    const auto zmod = N(zmod), amod = N(amod);
+    BOOST_CHECK_EQUAL(success(), point.modify_safe(_bob, zmod, _delay * 2));
+    produce_block();
+    BOOST_CHECK_EQUAL(success(), point.modify_safe(_bob, amod, _delay * 3));
+    produce_blocks(blocks);
+    BOOST_CHECK_EQUAL(success(), point.apply_ready(_bob, 10));
+    CHECK_MATCHING_OBJECT(point.get_safe(_bob), point.make_safe(one + one, _delay * 3));
+    BOOST_CHECK(point.get_safe_mod(_bob, zmod).is_null());
+    BOOST_CHECK(point.get_safe_mod(_bob, amod).is_null());
+
+    BOOST_TEST_MESSAGE("--- anyone can sweep mods of a disabled safe");
+    BOOST_CHECK_EQUAL(success(), point2.enable_safe(_bob, 0, _delay, _alice));
+    BOOST_CHECK_EQUAL(success(), point2.unlock_safe(_bob, mod1, one));
+    BOOST_CHECK_EQUAL(err.nothing_to_sweep, point.sweep_mods(_bob, 10, _carol));
+    BOOST_CHECK_EQUAL(success(), point2.disable_safe2(_bob, _alice));
+    BOOST_CHECK_EQUAL(success(), point.sweep_mods(_bob, 10, _carol));
+    BOOST_CHECK(point.get_safe_mod(_bob, mod1).is_null());
+    BOOST_CHECK_EQUAL(err.nothing_to_sweep, point.sweep_mods(_bob, 10, _carol));
+
+    BOOST_TEST_MESSAGE("--- fail if locked globally");
+    BOOST_CHECK_EQUAL(success(), point.unlock_safe(_bob, mod2, one));
+    produce_blocks(blocks);
+    BOOST_CHECK_EQUAL(success(), point.global_lock(_bob, _delay));
+    BOOST_CHECK_EQUAL(err.mod_global_lock, point.apply_ready(_bob, 10));
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE(trusted, commun_point_safe_tester) try {
     BOOST_TEST_MESSAGE("Instant actions with trusted account");
     init();
@@ -735,6 +815,39 @@ BOOST_FIXTURE_TEST_CASE(global_lock, commun_point_safe_tester) try {
     BOOST_CHECK_EQUAL(success(), point.apply_safe_mod(_alice, N(off)));
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE(safes_count, commun_point_safe_tester) try {
+    BOOST_TEST_MESSAGE("Count of safes in the guard record");
+    init();
+    const double money = 100;
+    BOOST_CHECK_EQUAL(success(), point.issue(_gls_com, 2*money));
+    BOOST_CHECK_EQUAL(success(), point.transfer(_gls_com, _alice, money));
+    BOOST_CHECK_EQUAL(success(), point.transfer(_gls_com, _bob, money));
+
+    BOOST_TEST_MESSAGE("--- guard record created by global lock has no count");
+    BOOST_CHECK_EQUAL(success(), point.global_lock(_alice, _delay));
+    BOOST_CHECK(point.get_global_lock(_alice)["safes"].is_null());
+    BOOST_CHECK_EQUAL(err.missing_auth(_alice), point.recount_safes(_alice, _bob));
+    BOOST_CHECK_EQUAL(err.missing_auth(_carol), point.recount_safes(_alice, _bob, _carol));
+    BOOST_CHECK_EQUAL(success(), point.recount_safes(_alice, _bob, _bob));
+    BOOST_CHECK_EQUAL(point.get_global_lock(_alice)["safes"].as<uint16_t>(), 0);
+    BOOST_CHECK_EQUAL(err.safes_counted, point.recount_safes(_alice, _alice));
+    BOOST_CHECK_EQUAL(err.safes_counted, point.recount_safes(_bob, _alice, _alice));
+
+    BOOST_TEST_MESSAGE("--- only the contract marks all safes counted");
+    BOOST_CHECK(point.get_global_params()["safes_counted"].is_null());
+    BOOST_CHECK_EQUAL(err.missing_auth(_code), point.safes_counted(_alice));
+    BOOST_CHECK_EQUAL(success(), point.safes_counted(_code));
+    BOOST_CHECK_EQUAL(point.get_global_params()["safes_counted"].as<bool>(), true);
+    produce_block();
+    BOOST_CHECK_EQUAL(err.all_safes_counted, point.safes_counted(_code));
+
+    BOOST_TEST_MESSAGE("--- safes are still checked after marking");
+    BOOST_CHECK_EQUAL(success(), point.enable_safe(_bob, money / 2, _delay));
+    BOOST_CHECK_EQUAL(err.balance_lock, point.transfer(_bob, _alice, money / 2 + 1));
+    BOOST_CHECK_EQUAL(success(), point.transfer(_bob, _alice, money / 4));
+    BOOST_CHECK_EQUAL(err.balance_lock, point.transfer(_bob, _alice, money / 4 + 1));
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE(unlock_overflow, commun_point_safe_tester) try {
     BOOST_TEST_MESSAGE("Unlocked overflow");
     init();
@@ -4,6 +4,10 @@
 
 namespace eosio { namespace testing {
 
+// native mirror of structures::account_struct for the typed readers (see chaindb_rows)
+struct point_balance_row {
+    asset balance;
+};
 
 struct commun_point_api: base_contract_api {
 private:
@@ -99,6 +103,13 @@ public:
         return _tester->push_tx(tx_actions, signers, false /*produce_and_check*/);
     }
 
+    action_result mintto(account_name receiver, asset quantity, account_name signer = {}) {
+        return push(N(mintto), signer ? signer : _code, args()
+            ("receiver", receiver)
+            ("quantity", quantity)
+        );
+    }
+
     action_result retire(account_name from, double quantity, string memo="") {
         return retire(from, make_asset(quantity), memo);
     }
@@ -153,6 +164,13 @@ public:
         );
     }
 
+    action_result settle(account_name signer, uint16_t max_orders) {
+        return push(N(settle), signer, args()
+            ("commun_code", _symbol_code)
+            ("max_orders", max_orders)
+        );
+    }
+
     // safe
     action_result enable_safe(name owner, double unlock, uint32_t delay, name trusted = {}) {
         return enable_safe(owner, make_asset(unlock), delay, trusted);
@@ -243,6 +261,19 @@ public:
         return _apply_safe_mod(owner, mod_id, {owner, signer});
     }
 
+    action_result recount_safes(name owner, name signer, std::optional<name> ram_payer = {}) {
+        auto a = args()
+            ("owner", owner);
+        if (ram_payer.has_value()) {
+            a("ram_payer", *ram_payer);
+        }
+        return push(N(recountsafes), signer, a);
+    }
+
+    action_result safes_counted(name signer) {
+        return push(N(safescounted), signer, args());
+    }
+
     action_result cancel_safe_mod(name owner, name mod_id) {
         return push(N(cancelsafemod), owner, args()
             ("owner", owner)
@@ -250,6 +281,20 @@ public:
         );
     }
 
+    action_result apply_ready(name owner, uint16_t max) {
+        return push(N(applyready), owner, args()
+            ("owner", owner)
+            ("max", max)
+        );
+    }
+
+    action_result sweep_mods(name owner, uint16_t max, name signer) {
+        return push(N(sweepmods), signer, args()
+            ("owner", owner)
+            ("max", max)
+        );
+    }
+
     action_result global_lock(name owner, uint32_t period) {
         return push(N(globallock), owner, args()
             ("owner", owner)
@@ -303,6 +348,20 @@ public:
         return 0;
     }
 
+    int64_t get_reserve() {
+        auto sname = _symbol_code.value;
+        auto v = get_struct(sname, N(stat), sname, "");
+        if (v.is_object()) {
+            auto o = mvo(v);
+            return o["reserve"].as<asset>().get_amount();
+        }
+        return 0;
+    }
+
+    variant get_order(uint64_t id) {
+        return get_struct(_symbol_code.value, N(order), id, "");
+    }
+
     int64_t get_amount(account_name acc) {
         auto v = get_struct(acc, N(accounts), _symbol_code.value, "");
         if (v.is_object()) {
@@ -322,6 +381,10 @@ public:
         return v;
     }
 
+    std::optional<point_balance_row> get_balance_row(account_name acc) const {
+        return _tester->get_chaindb_row<point_balance_row>(_code, acc, N(accounts), _symbol_code.value);
+    }
+
     std::vector<variant> get_accounts(account_name user) {
         return _tester->get_all_chaindb_rows(_code, user, N(accounts), false);
     }
@@ -389,3 +452,5 @@ public:
 
 
 }} // eosio::testing
+
+FC_REFLECT(eosio::testing::point_balance_row, (balance))
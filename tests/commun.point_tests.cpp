@@ -3,6 +3,7 @@
 #include "cyber.token_test_api.hpp"
 #include "contracts.hpp"
 #include "../commun.point/include/commun.point/config.hpp"
+#include "../include/commun/math.hpp"
 
 
 namespace cfg = commun::config;
@@ -28,8 +29,10 @@ public:
         create_accounts({_commun, _golos, _alice, _bob, _carol,
             cfg::token_name, cfg::point_name, cfg::gallery_name});
         produce_block();
-        install_contract(cfg::token_name, contracts::token_wasm(), contracts::token_abi());
-        install_contract(_code, contracts::point_wasm(), contracts::point_abi());
+        install_contracts({
+            {cfg::token_name, contracts::token_wasm(), contracts::token_abi()},
+            {_code, contracts::point_wasm(), contracts::point_abi()}
+        });
     }
 
     void init() {
@@ -83,6 +86,7 @@ public:
         const string balance_not_exists = amsg("Balance row already deleted or never existed. Action won't have any effect.");
         const string to_not_exists = amsg("to account does not exist");
         const string freezer_not_exists = amsg("freezer account does not exist");
+        const string receiver_not_exists = amsg("receiver account does not exist");
         const string not_reserve_symbol = amsg("invalid reserve token symbol");
 
         const string no_changes = amsg("No params changed");
@@ -97,6 +101,8 @@ public:
         const string min_order_negative = amsg("minimum amount cannot be negative");
         const string min_order = amsg("converted value is lesser than minimum order");
         const string fee_only = amsg("the entire amount is spent on fee");
+        const string max_orders_not_positive = amsg("max_orders must be positive");
+        const string no_orders = amsg("no orders to settle");
     } err;
 };
 
@@ -214,6 +220,77 @@ BOOST_FIXTURE_TEST_CASE(cw05_test, commun_point_tester) try {
     BOOST_CHECK_EQUAL(reserve, 0);
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE(math_conformance_test, commun_point_tester) try {
+    BOOST_TEST_MESSAGE("commun::math quotes match the point contract");
+
+    int64_t supply = 200000;
+    int64_t reserve = 100000;
+    int64_t balance = 100000;
+    uint16_t cw = 3333;
+    uint16_t fee = 150;
+    BOOST_CHECK_EQUAL(success(), token.create(_commun, asset(1000000, token._symbol)));
+    BOOST_CHECK_EQUAL(success(), token.issue(_commun, _golos, asset(reserve, token._symbol), ""));
+    BOOST_CHECK_EQUAL(success(), token.issue(_commun, _alice, asset(balance, token._symbol), ""));
+
+    BOOST_CHECK_EQUAL(success(), point.create(_golos, asset(0, point._symbol), asset(999999, point._symbol), cw, fee));
+    BOOST_CHECK_EQUAL(success(), point.setparams(_golos, point.args()("transfer_fee", 0)("min_transfer_fee_points", 0)));
+    BOOST_CHECK_EQUAL(success(), token.transfer(_golos, _code, asset(reserve, token._symbol), cfg::restock_prefix + point_code_str));
+    BOOST_CHECK_EQUAL(success(), point.issue(_golos, asset(supply, point._symbol), std::string(point_code_str) + " issue"));
+    BOOST_CHECK_EQUAL(success(), point.open(_alice));
+
+    auto get_token_balance = [&](account_name acc) {
+        return asset::from_string(token.get_account(acc)["balance"].as_string()).get_amount();
+    };
+
+    for (int64_t price : {1000, 7777, 12345}) {
+        int64_t cur_supply = point.get_supply();
+        int64_t cur_reserve = point.get_reserve();
+        int64_t tokens = 0;
+        commun::math::quote(commun::math::buy_batch{&cur_reserve, &cur_supply, &cw, &fee, &price, &tokens, 1});
+        BOOST_TEST_MESSAGE("--- alice buys " << tokens << " for " << price);
+
+        auto prev_amount = point.get_amount(_alice);
+        BOOST_CHECK_EQUAL(success(), token.transfer(_alice, _code, asset(price, token._symbol), point_code_str));
+        BOOST_CHECK_EQUAL(point.get_amount(_alice) - prev_amount, tokens);
+        produce_block();
+    }
+
+    for (int64_t amount : {500, 3210, point.get_amount(_alice) - 3710}) {
+        int64_t cur_supply = point.get_supply();
+        int64_t cur_reserve = point.get_reserve();
+        int64_t tokens = 0;
+        int64_t fee_amount = 0;
+        commun::math::quote(commun::math::sell_batch{&cur_reserve, &cur_supply, &cw, &fee, &amount, &tokens, &fee_amount, 1});
+        BOOST_TEST_MESSAGE("--- alice sells " << amount << " for " << tokens << " (fee " << fee_amount << ")");
+
+        auto prev_balance = get_token_balance(_alice);
+        BOOST_CHECK_EQUAL(success(), point.transfer(_alice, _code, asset(amount, point._symbol)));
+        BOOST_CHECK_EQUAL(get_token_balance(_alice) - prev_balance, tokens);
+        produce_block();
+    }
+
+    BOOST_TEST_MESSAGE("--- batch quotes match the precomputed values");
+    // the values are computed with 50 significant digits: 200000*(1.12345^0.3333 - 1) = 7912.0019,
+    // 100000*(1 - (1 - 12345/200000)^(1/0.3333)) = 17399.6034, 3*((1 + 2/5e9)^0.0001 - 1) = 1.2e-13
+    const auto invalid = commun::math::invalid_quote;
+    std::vector<int64_t> reserves{100000, 1, 5000000000, 0, 77};
+    std::vector<int64_t> supplies{200000, 1000, 3, 1000, 77};
+    std::vector<uint16_t> cws{3333, 10000, 1, 5000, 10000};
+    std::vector<uint16_t> fees{0, 10000, 150, 1, 9999};
+    std::vector<int64_t> amounts{12345, 1000, 3, 1001, 77};
+    // buying: the fee takes all of [1] and [4], [2] gets less than a point, [3] has no reserve
+    std::vector<int64_t> expected_bought{7912, invalid, 0, invalid, invalid};
+    // selling: all of the supply gets all of the reserve in [1], [2] and [4], [3] sells more than the supply
+    std::vector<int64_t> expected_sold{17399, 0, 4925000000, invalid, 0};
+    std::vector<int64_t> expected_fees{0, 1, 75000000, 0, 77};
+    std::vector<int64_t> bought(amounts.size()), sold(amounts.size()), sell_fees(amounts.size());
+    commun::math::quote(commun::math::buy_batch{reserves.data(), supplies.data(), cws.data(), fees.data(), amounts.data(), bought.data(), amounts.size()});
+    commun::math::quote(commun::math::sell_batch{reserves.data(), supplies.data(), cws.data(), fees.data(), amounts.data(), sold.data(), sell_fees.data(), amounts.size()});
+    BOOST_CHECK_EQUAL_COLLECTIONS(bought.begin(), bought.end(), expected_bought.begin(), expected_bought.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(sold.begin(), sold.end(), expected_sold.begin(), expected_sold.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(sell_fees.begin(), sell_fees.end(), expected_fees.begin(), expected_fees.end());
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE(create_tests, commun_point_tester) try {
     BOOST_TEST_MESSAGE("create tests");
     auto init_supply = asset(0, point._symbol);
@@ -279,6 +356,18 @@ BOOST_FIXTURE_TEST_CASE(issue_tests, commun_point_tester) try {
     BOOST_CHECK_EQUAL(success(), point.issue(_golos, supply, ""));
     BOOST_CHECK_EQUAL(success(), point.issue(_golos, supply, big_memo));
     BOOST_CHECK_EQUAL(err.memo_too_long, point.issue(_golos, supply, super_big_memo));
+
+    BOOST_TEST_MESSAGE("-- mintto credits the receiver directly");
+    auto issuer_amount = point.get_amount(_golos);
+    auto cur_supply = point.get_supply();
+    BOOST_CHECK_EQUAL(err.missing_auth(_code), point.mintto(_alice, supply, _golos));
+    BOOST_CHECK_EQUAL(err.receiver_not_exists, point.mintto(N(nobody), supply));
+    BOOST_CHECK_EQUAL(err.quantity_not_positive_issue, point.mintto(_alice, asset(0, point._symbol)));
+    BOOST_CHECK_EQUAL(err.quantity_exceeds_supply, point.mintto(_alice, max_supply));
+    BOOST_CHECK_EQUAL(success(), point.mintto(_alice, supply));
+    BOOST_CHECK_EQUAL(point.get_amount(_alice), supply.get_amount());
+    BOOST_CHECK_EQUAL(point.get_amount(_golos), issuer_amount);
+    BOOST_CHECK_EQUAL(point.get_supply(), cur_supply + supply.get_amount());
 } FC_LOG_AND_RETHROW()
 
 BOOST_FIXTURE_TEST_CASE(retire_tests, commun_point_tester) try {
@@ -565,6 +654,87 @@ BOOST_FIXTURE_TEST_CASE(transfer_min_order, commun_point_tester) try {
     BOOST_CHECK_EQUAL(err.not_reserve_symbol, point.transfer(_carol, _code, asset(100, point._symbol), "minimum: 1.0 CMN"));
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE(batch_exchange_test, commun_point_tester) try {
+    BOOST_TEST_MESSAGE("Batch exchange mode");
+
+    int64_t supply = 200000;
+    int64_t reserve = 100000;
+    uint16_t cw = 3333;
+    uint16_t fee = 150;
+    BOOST_CHECK_EQUAL(success(), token.create(_commun, asset(1000000, token._symbol)));
+    BOOST_CHECK_EQUAL(success(), token.issue(_commun, _golos, asset(reserve, token._symbol), ""));
+    BOOST_CHECK_EQUAL(success(), token.issue(_commun, _alice, asset(50000, token._symbol), ""));
+    BOOST_CHECK_EQUAL(success(), token.issue(_commun, _bob, asset(50000, token._symbol), ""));
+
+    BOOST_CHECK_EQUAL(success(), point.create(_golos, asset(0, point._symbol), asset(999999, point._symbol), cw, fee));
+    BOOST_CHECK_EQUAL(success(), point.setparams(_golos, point.args()("transfer_fee", 0)("min_transfer_fee_points", 0)));
+    BOOST_CHECK_EQUAL(success(), token.transfer(_golos, _code, asset(reserve, token._symbol), cfg::restock_prefix + point_code_str));
+    BOOST_CHECK_EQUAL(success(), point.issue(_golos, asset(supply, point._symbol), std::string(point_code_str) + " issue"));
+    BOOST_CHECK_EQUAL(success(), point.open(_alice));
+    BOOST_CHECK_EQUAL(success(), point.open(_bob));
+    BOOST_CHECK_EQUAL(success(), point.transfer(_golos, _carol, asset(10000, point._symbol)));
+
+    auto get_token_balance = [&](account_name acc) {
+        return asset::from_string(token.get_account(acc)["balance"].as_string()).get_amount();
+    };
+
+    BOOST_CHECK_EQUAL(success(), point.setparams(_golos, point.args()("batch_exchange", true)));
+    BOOST_CHECK_EQUAL(err.no_orders, point.settle(_alice, 10));
+
+    BOOST_TEST_MESSAGE("-- orders are queued");
+    BOOST_CHECK_EQUAL(success(), token.transfer(_alice, _code, asset(1000, token._symbol), point_code_str));
+    BOOST_CHECK_EQUAL(success(), token.transfer(_alice, _code, asset(3000, token._symbol), point_code_str));
+    BOOST_CHECK_EQUAL(success(), token.transfer(_bob, _code, asset(2000, token._symbol), "minimum: " + asset(999999, point._symbol).to_string()));
+    BOOST_CHECK_EQUAL(success(), point.transfer(_carol, _code, asset(5000, point._symbol)));
+    BOOST_CHECK_EQUAL(err.symbol_precision, token.transfer(_bob, _code, asset(100, token._symbol), "minimum: 1.0 GLS"));
+    BOOST_CHECK_EQUAL(err.not_reserve_symbol, point.transfer(_carol, _code, asset(100, point._symbol), "minimum: 0.100 GLS"));
+    BOOST_CHECK_EQUAL(point.get_amount(_alice), 0);
+    BOOST_CHECK_EQUAL(point.get_amount(_carol), 5000);
+    BOOST_CHECK_EQUAL(point.get_supply(), supply);
+    BOOST_CHECK_EQUAL(point.get_reserve(), reserve);
+    BOOST_CHECK(point.get_order(0).is_object());
+    BOOST_CHECK(point.get_order(3).is_object());
+
+    BOOST_TEST_MESSAGE("-- orders are executed at one price for each side");
+    BOOST_CHECK_EQUAL(err.max_orders_not_positive, point.settle(_alice, 0));
+    auto net1 = commun::math::sub_fee(1000, fee);
+    auto net2 = commun::math::sub_fee(3000, fee);
+    auto tokens = static_cast<int64_t>(commun::math::bancor_supply_after_buy(reserve, supply, commun::math::cw_to_double(cw), net1 + net2)) - supply;
+    auto bought = commun::math::prop(tokens, net1, net1 + net2) + commun::math::prop(tokens, net2, net1 + net2);
+    auto initial = commun::math::bancor_sell(reserve + net1 + net2, supply + bought, cw, 5000);
+    auto prev_carol = get_token_balance(_carol);
+
+    BOOST_CHECK_EQUAL(success(), point.settle(_carol, 10));
+    BOOST_CHECK_EQUAL(point.get_amount(_alice), bought);
+    BOOST_CHECK_EQUAL(get_token_balance(_carol) - prev_carol, commun::math::sub_fee(initial, fee));
+    BOOST_CHECK_EQUAL(point.get_supply(), supply + bought - 5000);
+    BOOST_CHECK_EQUAL(point.get_reserve(), reserve + net1 + net2 - initial);
+
+    BOOST_TEST_MESSAGE("-- an order with unreachable minimum is returned");
+    BOOST_CHECK_EQUAL(point.get_amount(_bob), 0);
+    BOOST_CHECK_EQUAL(get_token_balance(_bob), 50000);
+    BOOST_CHECK(point.get_order(2).is_null());
+    BOOST_CHECK_EQUAL(err.no_orders, point.settle(_alice, 10));
+    produce_block();
+
+    BOOST_TEST_MESSAGE("-- settle is limited by max_orders");
+    BOOST_CHECK_EQUAL(success(), token.transfer(_bob, _code, asset(1000, token._symbol), point_code_str));
+    BOOST_CHECK_EQUAL(success(), token.transfer(_bob, _code, asset(1500, token._symbol), point_code_str));
+    BOOST_CHECK_EQUAL(success(), point.settle(_alice, 1));
+    auto bob_amount = point.get_amount(_bob);
+    BOOST_CHECK_GT(bob_amount, 0);
+    BOOST_CHECK_EQUAL(success(), point.settle(_alice, 1));
+    BOOST_CHECK_GT(point.get_amount(_bob), bob_amount);
+    BOOST_CHECK_EQUAL(err.no_orders, point.settle(_alice, 1));
+
+    BOOST_TEST_MESSAGE("-- exchange is immediate when the mode is disabled");
+    BOOST_CHECK_EQUAL(success(), point.setparams(_golos, point.args()("batch_exchange", false)));
+    auto prev_alice = point.get_amount(_alice);
+    BOOST_CHECK_EQUAL(success(), token.transfer(_alice, _code, asset(1000, token._symbol), point_code_str));
+    BOOST_CHECK_GT(point.get_amount(_alice), prev_alice);
+    BOOST_CHECK_EQUAL(err.no_orders, point.settle(_alice, 10));
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE(withdraw_tests, commun_point_tester) try {
     BOOST_TEST_MESSAGE("withdraw tests");
     init();
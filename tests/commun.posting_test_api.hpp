@@ -272,6 +272,20 @@ struct commun_posting_api: base_contract_api {
         );
     }
 
+    action_result deactmosaics(account_name signer, uint16_t max_steps) {
+        return push(N(deactmosaics), signer, args()
+            ("commun_code", commun_code)
+            ("max_steps", max_steps)
+        );
+    }
+
+    action_result fold_replies(account_name signer, uint16_t max_steps) {
+        return push(N(foldreplies), signer, args()
+            ("commun_code", commun_code)
+            ("max_steps", max_steps)
+        );
+    }
+
     variant get_vertex(mssgid message_id) {
         return get_struct(commun_code.value, N(vertex), message_id.tracery(), "vertex");
     }
@@ -52,12 +52,14 @@ public:
         create_accounts({_code, _commun, _golos, cfg::token_name, cfg::point_name, cfg::list_name,
             cfg::emit_name, cfg::control_name, _client});
         produce_block();
-        install_contract(cfg::control_name, contracts::ctrl_wasm(), contracts::ctrl_abi());
-        install_contract(cfg::point_name, contracts::point_wasm(), contracts::point_abi());
-        install_contract(cfg::emit_name, contracts::emit_wasm(), contracts::emit_abi());
-        install_contract(cfg::token_name, contracts::token_wasm(), contracts::token_abi());
-        install_contract(cfg::list_name, contracts::list_wasm(), contracts::list_abi());
-        install_contract(cfg::publish_name, contracts::publication_wasm(), contracts::publication_abi());
+        install_contracts({
+            {cfg::control_name, contracts::ctrl_wasm(), contracts::ctrl_abi()},
+            {cfg::point_name, contracts::point_wasm(), contracts::point_abi()},
+            {cfg::emit_name, contracts::emit_wasm(), contracts::emit_abi()},
+            {cfg::token_name, contracts::token_wasm(), contracts::token_abi()},
+            {cfg::list_name, contracts::list_wasm(), contracts::list_abi()},
+            {cfg::publish_name, contracts::publication_wasm(), contracts::publication_abi()}
+        });
 
         set_authority(cfg::emit_name, cfg::reward_perm_name, create_code_authority({_code}), "active");
         link_authority(cfg::emit_name, cfg::emit_name, cfg::reward_perm_name, N(issuereward));
@@ -77,7 +79,7 @@ public:
         set_authority(cfg::gallery_name, cfg::transfer_permission, create_code_authority(transfer_perm_accs), "active");
         set_authority(cfg::control_name, N(changepoints), create_code_authority({cfg::point_name}), "active");
 
-        link_authority(cfg::point_name, cfg::point_name, cfg::issue_permission, N(issue));
+        link_authority(cfg::point_name, cfg::point_name, cfg::issue_permission, N(mintto));
         link_authority(cfg::gallery_name, cfg::point_name, cfg::transfer_permission, N(transfer));
         link_authority(cfg::control_name, cfg::control_name, N(changepoints), N(changepoints));
 
@@ -107,9 +109,6 @@ public:
         BOOST_CHECK_EQUAL(success(), token.create(_commun, asset(reserve, token._symbol)));
         BOOST_CHECK_EQUAL(success(), token.issue(_commun, _golos, asset(reserve, token._symbol), ""));
 
-        set_authority(_golos, cfg::transfer_permission, create_code_authority({cfg::emit_name}), cfg::active_name);
-        link_authority(_golos, cfg::point_name, cfg::transfer_permission, N(transfer));
-
         BOOST_CHECK_EQUAL(success(), point.create(_golos, asset(0, point._symbol), asset(supply * 2, point._symbol), 10000, 1));
         BOOST_CHECK_EQUAL(success(), point.setfreezer(commun::config::gallery_name));
 
@@ -191,6 +190,7 @@ public:
 
         const string already_removed       = amsg("Message already removed.");
         const string parent_removed        = amsg("Parent message removed.");
+        const string nothing_to_fold       = amsg("nothing to fold");
 
         const string vote_weight_0         = amsg("Weight equal to 0" + auth_self);
         const string vote_weight_gt100     = amsg("weight can't be more than 100%.");
@@ -272,11 +272,24 @@ BOOST_FIXTURE_TEST_CASE(create_message, commun_publication_tester) try {
         ("level", 1)
         ("childcount", 0)
     );
+    BOOST_TEST_MESSAGE("--- comments count is changed by the next message.");
     CHECK_MATCHING_OBJECT(post.get_vertex({N(brucelee), "permlink"}), mvo()
         ("parent_tracery", 0)
         ("level", 0)
         ("childcount", 1)
     );
+    BOOST_CHECK_EQUAL(err.nothing_to_fold, post.fold_replies(N(jackiechan), 8));
+
+    BOOST_TEST_MESSAGE("--- or by foldreplies.");
+    BOOST_CHECK_EQUAL(success(), post.create({N(jackiechan), "child2"}, {N(brucelee), "permlink"}));
+    CHECK_MATCHING_OBJECT(post.get_vertex({N(brucelee), "permlink"}), mvo()
+        ("childcount", 1)
+    );
+    BOOST_CHECK_EQUAL(success(), post.fold_replies(N(jackiechan), 8));
+    CHECK_MATCHING_OBJECT(post.get_vertex({N(brucelee), "permlink"}), mvo()
+        ("childcount", 2)
+    );
+    BOOST_CHECK_EQUAL(err.nothing_to_fold, post.fold_replies(N(jackiechan), 8));
 } FC_LOG_AND_RETHROW()
 
 BOOST_FIXTURE_TEST_CASE(nesting_level_test, commun_publication_tester) try {
@@ -329,6 +342,7 @@ BOOST_FIXTURE_TEST_CASE(remove_message, commun_publication_tester) try {
     init();
     BOOST_CHECK_EQUAL(success(), post.create({N(brucelee), "permlink"}));
     BOOST_CHECK_EQUAL(success(), post.create({N(jackiechan), "child"}, {N(brucelee), "permlink"}));
+    BOOST_CHECK_EQUAL(success(), post.fold_replies(N(jackiechan), 8));
 
     BOOST_TEST_MESSAGE("--- fail then remove non-existing post and post with child");
     BOOST_CHECK_EQUAL(err.no_message, post.remove({N(jackiechan), "permlink1"}));
@@ -342,6 +356,10 @@ BOOST_FIXTURE_TEST_CASE(remove_message, commun_publication_tester) try {
     BOOST_CHECK_EQUAL(success(), post.remove({N(jackiechan), "child"}));
     BOOST_CHECK(get_mosaic(_code, _point, mssgid{N(jackiechan), "child"}.tracery()).is_null());
     BOOST_CHECK(post.get_vertex({N(jackiechan), "child"}).is_null());
+    CHECK_MATCHING_OBJECT(post.get_vertex({N(brucelee), "permlink"}), mvo()
+       ("childcount", 1)
+    );
+    BOOST_CHECK_EQUAL(success(), post.fold_replies(N(jackiechan), 8));
     CHECK_MATCHING_OBJECT(post.get_vertex({N(brucelee), "permlink"}), mvo()
        ("childcount", 0)
     );
@@ -354,6 +372,22 @@ BOOST_FIXTURE_TEST_CASE(remove_message, commun_publication_tester) try {
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE(archive_message, commun_publication_tester) try {
+    BOOST_TEST_MESSAGE("Archive message testing.");
+    init();
+    BOOST_CHECK_EQUAL(success(), post.create({N(brucelee), "permlink"}));
+    BOOST_CHECK_EQUAL(success(), post.create({N(jackiechan), "child"}, {N(brucelee), "permlink"}));
+    BOOST_CHECK_EQUAL(success(), post.fold_replies(N(jackiechan), 8));
+    produce_block(fc::seconds(mosaic_active_period));
+    produce_block();
+
+    BOOST_TEST_MESSAGE("--- the vertices are removed, the removed parent gets no change of its comments count");
+    BOOST_CHECK_EQUAL(success(), post.deactmosaics(N(jackiechan), 8));
+    BOOST_CHECK(post.get_vertex({N(brucelee), "permlink"}).is_null());
+    BOOST_CHECK(post.get_vertex({N(jackiechan), "child"}).is_null());
+    BOOST_CHECK_EQUAL(err.nothing_to_fold, post.fold_replies(N(jackiechan), 8));
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE(report_message, commun_publication_tester) try {
     BOOST_TEST_MESSAGE("Report message testing.");
     init();
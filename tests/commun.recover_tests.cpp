@@ -40,8 +40,10 @@ public:
     {
         create_accounts({cfg::recover_name, cfg::point_name, _alice, _bob});
         produce_block();
-        install_contract(cfg::recover_name, contracts::recover_wasm(), contracts::recover_abi());
-        install_contract(cfg::point_name, contracts::point_wasm(), contracts::point_abi());
+        install_contracts({
+            {cfg::recover_name, contracts::recover_wasm(), contracts::recover_abi()},
+            {cfg::point_name, contracts::point_wasm(), contracts::point_abi()}
+        });
 
         set_authority(_alice, cfg::owner_name,
             authority(1, {{.key = get_public_key(_alice, "owner"), .weight = 1}},
@@ -3,6 +3,18 @@
 
 namespace eosio { namespace testing {
 
+// native mirror of gallery_types::gem_struct for the typed readers (see chaindb_rows)
+struct gem_row {
+    uint64_t id;
+    uint64_t tracery;
+    fc::time_point claim_date;
+    int64_t points;
+    int64_t shares;
+    int64_t pledge_points;
+    name owner;
+    name creator;
+};
+
 class gallery_tester : public golos_tester {
 public:
     gallery_tester(name code, bool push_genesis = true)
@@ -29,6 +41,8 @@ public:
         const string points_negative = amsg("points must be positive");
         const string wrong_gem_type = amsg("gem type mismatch");
         const string nothing_to_claim = amsg("nothing to claim");
+        const string nothing_to_deactivate = amsg("nothing to deactivate");
+        const string all_gems_scheduled = amsg("all gems are scheduled");
         const string no_authority = amsg("lack of necessary authority");
         const string already_done = amsg("already done");
         const string mosaic_is_inactive = amsg("mosaic is inactive");
@@ -68,13 +82,25 @@ public:
         return variant();
     }
 
+    chaindb_rows<gem_row> get_gem_rows(name code, symbol point, uint64_t from_id = 0) const {
+        return scan_chaindb_rows<gem_row>(code, point.to_symbol_code().value, N(gem), from_id);
+    }
+
     variant get_advice(name code, symbol point, name leader) {
         return get_chaindb_struct(code, point.to_symbol_code().value, N(advice), leader.value, "advice");
     }
     
+    variant get_provider_pool(name code, symbol point, name grantor) {
+        return get_chaindb_struct(code, point.to_symbol_code().value, N(provpool), grantor.value, "provpool");
+    }
+    
     variant get_stat(name code, symbol point) {
         return get_chaindb_struct(code, point.to_symbol_code().value, N(stat), point.to_symbol_code().value, "stat");
     }
+
+    variant get_stat_shard(name code, symbol point, uint64_t id) {
+        return get_chaindb_struct(code, point.to_symbol_code().value, N(statshard), id, "statshard");
+    }
     
     int64_t calc_bancor_amount(int64_t current_reserve, int64_t current_supply, double cw, int64_t reserve_amount) {
         if (!current_reserve) { return reserve_amount; }
@@ -85,3 +111,5 @@ public:
 };
 
 }} // eosio::testing
+
+FC_REFLECT(eosio::testing::gem_row, (id)(tracery)(claim_date)(points)(shares)(pledge_points)(owner)(creator))
@@ -0,0 +1,108 @@
+// Genesis state generator for communities migrated with their holders.
+//
+// Turns a snapshot of points, holder balances, leaders and votes into the rows of c.point, c.list, c.emit, c.gallery
+// and c.ctrl in the "tables" format of genesis-info.json. The rows are the same as the ones created by c.point create,
+// open and transfer, c.list create (with the init of c.emit, c.ctrl and c.gallery), c.ctrl regleader and voteleader,
+// so a community starts with its holders instead of pushing millions of actions after the launch.
+//
+// Usage: commun_genesis --snapshot=<file> --out=<file> --time=<genesis time> [--name=value ...], see print_usage().
+// Snapshot lines are csv ('#' starts a comment) or JSON objects with the same fields and the "kind" field:
+//   point,<code>,<precision>,<max_supply>,<cw>,<fee>,<issuer>,<community name>
+//   balance,<code>,<account>,<amount>
+//   leader,<code>,<account>
+//   vote,<code>,<voter>,<leader>,<pct>
+// Amounts are in the smallest units of the point, pct is in 1/100 of percent as in voteleader.
+//
+// The snapshot is read twice. The first pass keeps points, leaders and votes, the second one streams batches of lines
+// through a bounded queue to worker threads, which write the balances to their own part files and sum the supplies,
+// so the memory doesn't depend on the number of holders. The output is a list of table entries ending with commas,
+// create-genesis.sh inserts it into the "tables" of genesis-info.json (see GENESIS_TABLES there).
+//
+// Holder accounts must exist in the genesis and every holder must be listed once per point. Reserves aren't migrated:
+// points start with zero reserve, it's restocked after the launch by a transfer with the "restock: <code>" memo.
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "commun_genesis.hpp"
+
+using namespace commun;
+using namespace commun::genesis;
+
+namespace {
+
+void print_usage() {
+    gen_params d;
+    std::cout << "commun_genesis --snapshot=<file> --out=<file> --time=<YYYY-MM-DDThh:mm:ss.sss>\n"
+        << "  --threads=<cores>  --batch_lines=" << d.batch_lines << "  --holder_payer=" << d.holder_payer << "\n"
+        << "The time should be INITIAL_TIMESTAMP of create-genesis.sh, emission periods start from it.\n";
+}
+
+gen_params parse_params(int argc, char** argv) {
+    gen_params p;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto eq = arg.find('=');
+        if (arg.compare(0, 2, "--") || eq == std::string::npos) {
+            throw std::invalid_argument(arg);
+        }
+        auto key = arg.substr(2, eq - 2);
+        auto value = arg.substr(eq + 1);
+        if (key == "snapshot") {
+            p.snapshot = value;
+        } else if (key == "out") {
+            p.out = value;
+        } else if (key == "time") {
+            p.time = value;
+        } else if (key == "holder_payer") {
+            p.holder_payer = value;
+        } else if (key == "threads") {
+            p.threads = std::stoull(value);
+        } else if (key == "batch_lines") {
+            p.batch_lines = std::stoull(value);
+        } else {
+            throw std::invalid_argument(arg);
+        }
+    }
+    if (p.snapshot.empty() || p.out.empty() || p.time.empty() || !p.batch_lines) {
+        throw std::invalid_argument("snapshot, out and time must be set");
+    }
+    name_value(p.holder_payer);
+    if (!p.threads) {
+        p.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return p;
+}
+
+
+} // namespace
+
+int main(int argc, char** argv) {
+    gen_params p;
+    try {
+        if (argc > 1 && (std::string(argv[1]) == "--help" || std::string(argv[1]) == "-h")) {
+            print_usage();
+            return 0;
+        }
+        p = parse_params(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << "\n";
+        print_usage();
+        return 1;
+    }
+
+    try {
+        auto s = generate(p);
+        for (const auto& pt : s.points) {
+            std::cout << pt.first << ": supply " << pt.second.supply << ", leaders " << pt.second.leaders.size()
+                      << ", votes " << pt.second.votes.size() << "\n";
+        }
+        std::cout << "points " << s.points.size() << ", balances " << s.balances << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,678 @@
+#pragma once
+// Genesis state generator for communities migrated with their holders, see commun_genesis.cpp for the tool.
+//
+// The generator doesn't depend on the chain, it's compiled into the tool and into the unit tests, which check
+// the generated rows against the ABIs and the rows made by the actions. The default parameters of the rows are
+// taken from the config headers of the contracts.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <commun/math.hpp>
+#include <commun/defaults.hpp>
+#include "../../commun.ctrl/include/commun.ctrl/config.hpp"
+#include "../audit/commun_audit.hpp"
+
+namespace commun { namespace genesis {
+
+struct gen_params {
+    std::string snapshot;
+    std::string out;
+    std::string time;
+    std::string holder_payer = "c.point";
+    size_t threads = 0;
+    size_t batch_lines = 10000;
+};
+
+struct gen_error : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// sha256 of c.list validate_name, only the first 8 bytes are used as the community hash
+class sha256 {
+    static constexpr std::array<uint32_t, 64> k = {{
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2}};
+
+    static uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+    static void block(std::array<uint32_t, 8>& h, const unsigned char* p) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (uint32_t(p[4 * i]) << 24) | (uint32_t(p[4 * i + 1]) << 16) | (uint32_t(p[4 * i + 2]) << 8) | p[4 * i + 3];
+        }
+        for (int i = 16; i < 64; i++) {
+            auto s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            auto s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        auto v = h;
+        for (int i = 0; i < 64; i++) {
+            auto s1 = rotr(v[4], 6) ^ rotr(v[4], 11) ^ rotr(v[4], 25);
+            auto ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+            auto t1 = v[7] + s1 + ch + k[i] + w[i];
+            auto s0 = rotr(v[0], 2) ^ rotr(v[0], 13) ^ rotr(v[0], 22);
+            auto maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+            auto t2 = s0 + maj;
+            v = {{t1 + t2, v[0], v[1], v[2], v[3] + t1, v[4], v[5], v[6]}};
+        }
+        for (int i = 0; i < 8; i++) {
+            h[i] += v[i];
+        }
+    }
+
+public:
+    static std::array<unsigned char, 32> hash(const std::string& data) {
+        std::array<uint32_t, 8> h = {{
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19}};
+        std::string msg = data;
+        msg.push_back(static_cast<char>(0x80));
+        while (msg.size() % 64 != 56) {
+            msg.push_back(0);
+        }
+        uint64_t bits = static_cast<uint64_t>(data.size()) * 8;
+        for (int i = 7; i >= 0; i--) {
+            msg.push_back(static_cast<char>(bits >> (8 * i)));
+        }
+        for (size_t i = 0; i < msg.size(); i += 64) {
+            block(h, reinterpret_cast<const unsigned char*>(msg.data()) + i);
+        }
+        std::array<unsigned char, 32> ret;
+        for (int i = 0; i < 8; i++) {
+            for (int j = 0; j < 4; j++) {
+                ret[4 * i + j] = static_cast<unsigned char>(h[i] >> (24 - 8 * j));
+            }
+        }
+        return ret;
+    }
+};
+
+inline uint64_t community_hash(const std::string& community_name) {
+    auto digest = sha256::hash(community_name);
+    uint64_t ret = 0;
+    for (int i = 7; i >= 0; i--) {
+        ret = (ret << 8) | digest[i];
+    }
+    return ret;
+}
+
+// the same encoding as eosio::name
+inline uint64_t name_value(const std::string& s) {
+    if (s.size() > 13) {
+        throw gen_error("invalid name: " + s);
+    }
+    uint64_t ret = 0;
+    for (size_t i = 0; i < s.size(); i++) {
+        auto c = s[i];
+        uint64_t v = c == '.' ? 0 : (c >= '1' && c <= '5') ? c - '1' + 1 : (c >= 'a' && c <= 'z') ? c - 'a' + 6 : 32;
+        if (v > (i < 12 ? 31 : 15)) {
+            throw gen_error("invalid name: " + s);
+        }
+        ret |= i < 12 ? v << (64 - 5 * (i + 1)) : v;
+    }
+    return ret;
+}
+
+inline uint64_t symbol_code_value(const std::string& s) {
+    if (s.empty() || s.size() > 7) {
+        throw gen_error("invalid symbol code: " + s);
+    }
+    uint64_t ret = 0;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] < 'A' || s[i] > 'Z') {
+            throw gen_error("invalid symbol code: " + s);
+        }
+        ret |= uint64_t(s[i]) << (8 * i);
+    }
+    return ret;
+}
+
+struct record {
+    std::string kind;
+    std::vector<std::string> fields;    // fields after the kind
+};
+
+// a csv line or a JSON object, returns false for empty lines and comments
+inline bool parse_record(const std::string& line, record& r) {
+    static const std::map<std::string, std::vector<std::string>> json_fields = {
+        {"point", {"code", "precision", "max_supply", "cw", "fee", "issuer", "community"}},
+        {"balance", {"code", "account", "amount"}},
+        {"leader", {"code", "account"}},
+        {"vote", {"code", "voter", "leader", "pct"}}};
+    auto first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos || line[first] == '#') {
+        return false;
+    }
+    r.fields.clear();
+    if (line[first] == '{') {
+        std::istringstream in(line);
+        audit::json_reader reader(in, "snapshot");
+        audit::value v;
+        reader.next(v);
+        r.kind = audit::as_string(v.at("kind"));
+        auto f = json_fields.find(r.kind);
+        if (f == json_fields.end()) {
+            throw gen_error("unknown record kind " + r.kind);
+        }
+        for (const auto& key : f->second) {
+            const auto& item = audit::unwrap_number(v.at(key));
+            r.fields.push_back(item.text);
+        }
+        return true;
+    }
+    size_t pos = first;
+    auto comma = line.find(',', pos);
+    r.kind = line.substr(pos, comma - pos);
+    auto f = json_fields.find(r.kind);
+    if (f == json_fields.end()) {
+        throw gen_error("unknown record kind " + r.kind);
+    }
+    while (comma != std::string::npos) {
+        pos = comma + 1;
+        // the community name is the rest of the line and can contain commas
+        comma = r.fields.size() + 1 < f->second.size() ? line.find(',', pos) : std::string::npos;
+        auto end = comma == std::string::npos ? line.find_last_not_of("\r") + 1 : comma;
+        r.fields.push_back(line.substr(pos, end - pos));
+    }
+    if (r.fields.size() != f->second.size()) {
+        throw gen_error(r.kind + " must have " + std::to_string(f->second.size()) + " fields");
+    }
+    return true;
+}
+
+inline int64_t to_int64(const std::string& s, int64_t min, int64_t max, const char* what) {
+    size_t pos = 0;
+    long long v = 0;
+    try {
+        v = std::stoll(s, &pos);
+    } catch (const std::exception&) {
+        pos = 0;
+    }
+    if (!pos || pos != s.size() || v < min || v > max) {
+        throw gen_error(std::string("invalid ") + what + ": " + s);
+    }
+    return v;
+}
+
+struct leader_t {
+    uint64_t weight = 0;
+    uint64_t votes = 0;
+    bool in_top = false;
+};
+
+struct vote_t {
+    std::string voter;
+    std::string leader;
+    uint16_t pct;
+};
+
+struct voter_t {
+    uint8_t votes_num = 0;
+    uint16_t pct_sum = 0;
+    int64_t balance = 0;
+};
+
+struct point_t {
+    std::string code;
+    int precision;
+    int64_t max_supply;
+    int16_t cw;
+    int16_t fee;
+    std::string issuer;
+    std::string community;
+    int64_t supply = 0;
+    bool issuer_listed = false;
+    std::map<std::string, leader_t> leaders;
+    std::vector<vote_t> votes;
+    std::map<std::string, voter_t> voters;
+};
+
+using points_t = std::map<std::string, point_t>;
+
+inline std::string asset_json(int64_t amount, int precision, const std::string& code) {
+    return "{\"_amount\": " + std::to_string(amount) + ", \"_decs\": " + std::to_string(precision) + ", \"_sym\": \"" + code + "\"}";
+}
+
+// writes entries of the genesis "tables" list
+class table_writer {
+    std::ostream& _out;
+    bool _open = false;
+    bool _first_row = true;
+public:
+    explicit table_writer(std::ostream& out): _out(out) {}
+    ~table_writer() { close(); }
+
+    void open(const std::string& code, const std::string& table, const std::string& abi_type) {
+        close();
+        _out << "{\"code\": \"" << code << "\", \"table\": \"" << table << "\", \"abi_type\": \"" << abi_type << "\", \"rows\": [\n";
+        _open = true;
+        _first_row = true;
+    }
+    void row(const std::string& scope, const std::string& payer, uint64_t pk, const std::string& data) {
+        _out << (_first_row ? "" : ",\n") << "    {\"scope\": \"" << scope << "\", \"payer\": \"" << payer
+             << "\", \"pk\": " << pk << ", \"data\": " << data << "}";
+        _first_row = false;
+    }
+    void close() {
+        if (_open) {
+            _out << "\n]},\n";
+            _open = false;
+        }
+    }
+};
+
+inline std::string account_json(int64_t amount, const point_t& p) {
+    return "{\"balance\": " + asset_json(amount, p.precision, p.code) + "}";
+}
+
+inline void read_definitions(const gen_params& params, points_t& points) {
+    std::ifstream in(params.snapshot);
+    if (!in) {
+        throw gen_error("can't open " + params.snapshot);
+    }
+    std::set<std::string> issuers;
+    std::string line;
+    record r;
+    for (uint64_t n = 1; std::getline(in, line); n++) {
+        try {
+            if (!parse_record(line, r) || r.kind == "balance") {
+                continue;
+            }
+            const auto& code = r.fields[0];
+            symbol_code_value(code);
+            if (r.kind == "point") {
+                point_t p;
+                p.code = code;
+                p.precision = static_cast<int>(to_int64(r.fields[1], 0, 18, "precision"));
+                p.max_supply = to_int64(r.fields[2], 1, std::numeric_limits<int64_t>::max(), "max_supply");
+                p.cw = static_cast<int16_t>(to_int64(r.fields[3], 1, math::pct_base, "cw"));
+                p.fee = static_cast<int16_t>(to_int64(r.fields[4], 0, math::pct_base, "fee"));
+                p.issuer = r.fields[5];
+                name_value(p.issuer);
+                p.community = r.fields[6];
+                if (p.community.empty() || p.community.front() == ' ' || p.community.back() == ' ') {
+                    throw gen_error("invalid community name");
+                }
+                if (!issuers.insert(p.issuer).second) {
+                    throw gen_error("issuer already has a point");
+                }
+                if (!points.emplace(code, std::move(p)).second) {
+                    throw gen_error("point already exists");
+                }
+                continue;
+            }
+            auto point = points.find(code);
+            if (point == points.end()) {
+                throw gen_error("point " + code + " must be defined before its leaders and votes");
+            }
+            auto& p = point->second;
+            if (r.kind == "leader") {
+                name_value(r.fields[1]);
+                if (!p.leaders.emplace(r.fields[1], leader_t()).second) {
+                    throw gen_error("leader already registered");
+                }
+            } else if (r.kind == "vote") {
+                name_value(r.fields[1]);
+                auto pct = static_cast<uint16_t>(to_int64(r.fields[3], config::vote_pct_step, math::pct_base, "pct"));
+                if (pct % config::vote_pct_step) {
+                    throw gen_error("incorrect pct");
+                }
+                auto& voter = p.voters[r.fields[1]];
+                if (voter.votes_num >= config::def_comm_max_votes) {
+                    throw gen_error("all allowed votes already casted");
+                }
+                if (voter.pct_sum + pct > math::pct_base) {
+                    throw gen_error("all votes exceed 100%");
+                }
+                voter.votes_num++;
+                voter.pct_sum += pct;
+                p.votes.push_back({r.fields[1], r.fields[2], pct});
+            }
+        } catch (const std::exception& e) {
+            throw gen_error(params.snapshot + ":" + std::to_string(n) + ": " + e.what());
+        }
+    }
+    for (auto& p : points) {
+        std::set<std::pair<std::string, std::string>> voted;
+        for (const auto& v : p.second.votes) {
+            auto leader = p.second.leaders.find(v.leader);
+            if (leader == p.second.leaders.end()) {
+                throw gen_error(p.first + ": " + v.leader + " voted by " + v.voter + " is not a leader");
+            }
+            if (!voted.emplace(v.voter, v.leader).second) {
+                throw gen_error(p.first + ": " + v.voter + " already voted for " + v.leader);
+            }
+            leader->second.votes++;
+        }
+    }
+}
+
+struct batch_t {
+    uint64_t first_line;
+    std::vector<std::string> lines;
+};
+
+// results of a worker, merged when all balances are written
+struct part_t {
+    std::string file;
+    std::unordered_map<std::string, int64_t> supply;
+    std::map<std::pair<std::string, std::string>, int64_t> voter_balances;
+    std::set<std::string> issuers_listed;
+    uint64_t rows = 0;
+};
+
+class balance_writer {
+    const gen_params& _params;
+    const points_t& _points;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::vector<batch_t> _queue;
+    bool _done = false;
+    std::string _error;
+
+    bool pop(batch_t& b) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv.wait(lock, [&]() { return !_queue.empty() || _done; });
+        if (_queue.empty()) {
+            return false;
+        }
+        b = std::move(_queue.back());
+        _queue.pop_back();
+        _cv.notify_all();
+        return true;
+    }
+
+    void work(part_t& part) {
+        std::ofstream out(part.file);
+        table_writer writer(out);
+        batch_t b;
+        record r;
+        while (pop(b)) {
+            for (size_t i = 0; i < b.lines.size(); i++) {
+                try {
+                    if (!parse_record(b.lines[i], r) || r.kind != "balance") {
+                        continue;
+                    }
+                    auto p = _points.find(r.fields[0]);
+                    if (p == _points.end()) {
+                        throw gen_error("point " + r.fields[0] + " isn't defined");
+                    }
+                    const auto& account = r.fields[1];
+                    if (account == "c.gallery" || account == "c.ctrl") {
+                        throw gen_error("balances of c.gallery and c.ctrl are created empty");
+                    }
+                    auto amount = to_int64(r.fields[2], 0, p->second.max_supply, "amount");
+                    auto& supply = part.supply[p->first];
+                    if (amount > p->second.max_supply - supply) {
+                        throw gen_error("quantity exceeds available supply");
+                    }
+                    supply += amount;
+                    if (account == p->second.issuer) {
+                        part.issuers_listed.insert(p->first);
+                    }
+                    if (p->second.voters.count(account)) {
+                        part.voter_balances[std::make_pair(p->first, account)] += amount;
+                    }
+                    if (!part.rows) {
+                        writer.open("c.point", "accounts", "account_struct");
+                    }
+                    writer.row(account, _params.holder_payer, symbol_code_value(p->first), account_json(amount, p->second));
+                    part.rows++;
+                } catch (const std::exception& e) {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    if (_error.empty()) {
+                        _error = _params.snapshot + ":" + std::to_string(b.first_line + i) + ": " + e.what();
+                    }
+                    _done = true;
+                    _queue.clear();
+                    _cv.notify_all();
+                    return;
+                }
+            }
+        }
+    }
+
+public:
+    balance_writer(const gen_params& params, const points_t& points): _params(params), _points(points) {}
+
+    std::vector<part_t> run() {
+        std::vector<part_t> parts(_params.threads);
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < parts.size(); t++) {
+            parts[t].file = _params.out + ".part" + std::to_string(t);
+            workers.emplace_back([this, &parts, t]() { work(parts[t]); });
+        }
+        std::ifstream in(_params.snapshot);
+        batch_t b{1, {}};
+        std::string line;
+        uint64_t n = 0;
+        auto push = [&]() {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait(lock, [&]() { return _queue.size() < 2 * parts.size() || _done; });
+            if (!_done) {
+                _queue.push_back(std::move(b));
+                _cv.notify_all();
+            }
+            b = batch_t{n + 1, {}};
+        };
+        while (std::getline(in, line) && !_done) {
+            n++;
+            b.lines.push_back(std::move(line));
+            if (b.lines.size() == _params.batch_lines) {
+                push();
+            }
+        }
+        push();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _done = true;
+            _cv.notify_all();
+        }
+        for (auto& w : workers) {
+            w.join();
+        }
+        if (!_error.empty()) {
+            for (const auto& p : parts) {
+                std::remove(p.file.c_str());
+            }
+            throw gen_error(_error);
+        }
+        return parts;
+    }
+};
+
+inline void merge_parts(points_t& points, const std::vector<part_t>& parts) {
+    for (const auto& part : parts) {
+        for (const auto& s : part.supply) {
+            auto& p = points.at(s.first);
+            if (s.second > p.max_supply - p.supply) {
+                throw gen_error(s.first + ": quantity exceeds available supply");
+            }
+            p.supply += s.second;
+        }
+        for (const auto& v : part.voter_balances) {
+            points.at(v.first.first).voters.at(v.first.second).balance += v.second;
+        }
+        for (const auto& code : part.issuers_listed) {
+            points.at(code).issuer_listed = true;
+        }
+    }
+    for (auto& p : points) {
+        for (const auto& v : p.second.votes) {
+            p.second.leaders.at(v.leader).weight += math::pct(v.pct, p.second.voters.at(v.voter).balance);
+        }
+        std::vector<std::pair<std::string, leader_t*>> ranked;
+        for (auto& l : p.second.leaders) {
+            ranked.emplace_back(l.first, &l.second);
+        }
+        std::stable_sort(ranked.begin(), ranked.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.second->weight != rhs.second->weight ? lhs.second->weight > rhs.second->weight :
+                                                              name_value(lhs.first) < name_value(rhs.first);
+        });
+        for (size_t i = 0; i < ranked.size() && i < config::def_comm_leaders_num && ranked[i].second->weight; i++) {
+            ranked[i].second->in_top = true;
+        }
+    }
+}
+
+inline void write_definitions(const gen_params& params, const points_t& points, std::ostream& out) {
+    table_writer w(out);
+    auto time = "\"" + params.time + "\"";
+    const std::string zero_time = "\"1970-01-01T00:00:00.000\"";
+
+    w.open("c.point", "param", "param_struct");
+    for (const auto& p : points) {
+        w.row("c.point", "c.point", symbol_code_value(p.first), "{\"max_supply\": " + asset_json(p.second.max_supply, p.second.precision, p.first) +
+            ", \"cw\": " + std::to_string(p.second.cw) + ", \"fee\": " + std::to_string(p.second.fee) +
+            ", \"issuer\": \"" + p.second.issuer + "\", \"transfer_fee\": " + std::to_string(config::def_transfer_fee) +
+            ", \"min_transfer_fee_points\": " + std::to_string(config::def_min_transfer_fee_points) + ", \"batch_exchange\": false}");
+    }
+    w.open("c.point", "stat", "stat_struct");
+    for (const auto& p : points) {
+        w.row(p.first, "c.point", symbol_code_value(p.first), "{\"supply\": " + asset_json(p.second.supply, p.second.precision, p.first) +
+            ", \"reserve\": " + asset_json(0, 4, "CMN") + "}");
+    }
+    w.open("c.point", "accounts", "account_struct");
+    for (const auto& p : points) {
+        auto pk = symbol_code_value(p.first);
+        for (const char* acc : {"c.gallery", "c.ctrl"}) {
+            w.row(acc, "c.point", pk, account_json(0, p.second));
+        }
+        if (!p.second.issuer_listed) {
+            w.row(p.second.issuer, "c.point", pk, account_json(0, p.second));
+        }
+    }
+
+    w.open("c.list", "dapp", "dapp");
+    w.row("c.list", "c.list", 0, "{\"id\": 0, \"control_param\": {\"leaders_num\": " + std::to_string(config::def_dapp_leaders_num) +
+        ", \"max_votes\": " + std::to_string(config::def_dapp_max_votes) + ", \"custom_thresholds\": []}}");
+    w.open("c.list", "community", "community");
+    std::set<uint64_t> hashes;
+    for (const auto& p : points) {
+        auto hash = community_hash(p.second.community);
+        if (!hashes.insert(hash).second) {
+            throw gen_error(p.first + ": community exists");
+        }
+        std::ostringstream data;
+        data << "{\"commun_symbol\": \"" << p.second.precision << "," << p.first << "\", \"community_hash\": " << hash
+             << ", \"control_param\": {\"leaders_num\": " << int(config::def_comm_leaders_num) << ", \"max_votes\": " << int(config::def_comm_max_votes)
+             << ", \"custom_thresholds\": []}, \"emission_rate\": " << config::def_emission_rate
+             << ", \"emission_receivers\": [{\"contract\": \"c.ctrl\", \"period\": " << config::def_reward_leaders_period << ", \"percent\": " << config::def_leaders_percent
+             << "}, {\"contract\": \"c.gallery\", \"period\": " << config::def_reward_mosaics_period << ", \"percent\": " << math::pct_base - config::def_leaders_percent
+             << "}], \"author_percent\": " << config::def_author_percent << ", \"collection_period\": " << config::def_collection_period
+             << ", \"moderation_period\": " << config::def_moderation_period << ", \"extra_reward_period\": " << config::def_extra_reward_period
+             << ", \"gems_per_day\": " << config::def_gems_per_day << ", \"rewarded_mosaic_num\": " << int(config::def_rewarded_mosaic_num)
+             << ", \"min_lead_rating\": " << config::def_min_lead_rating
+             << ", \"opuses\": [{\"name\": \"comment\", \"mosaic_pledge\": 0, \"min_mosaic_inclusion\": 0, \"min_gem_inclusion\": 1}"
+             << ", {\"name\": \"post\", \"mosaic_pledge\": 0, \"min_mosaic_inclusion\": 0, \"min_gem_inclusion\": 1}]"
+             << std::boolalpha << ", \"damned_gem_reward_enabled\": " << config::def_damned_gem_reward_enabled
+             << ", \"refill_gem_enabled\": " << config::def_refill_gem_enabled
+             << ", \"custom_gem_size_enabled\": " << config::def_custom_gem_size_enabled << "}";
+        w.row("c.list", "c.list", symbol_code_value(p.first), data.str());
+    }
+
+    w.open("c.emit", "stat", "stat_struct");
+    for (const auto& p : points) {
+        auto pk = symbol_code_value(p.first);
+        w.row(p.first, "c.emit", pk, "{\"id\": " + std::to_string(pk) + ", \"reward_receivers\": [{\"contract\": \"c.ctrl\", \"time\": " +
+            time + "}, {\"contract\": \"c.gallery\", \"time\": " + time + "}]}");
+    }
+    // the watermarks and unscheduled_gem_id are binary extensions, all of them are written to keep the later ones readable
+    w.open("c.gallery", "stat", "stat_struct");
+    for (const auto& p : points) {
+        auto pk = symbol_code_value(p.first);
+        w.row(p.first, "c.gallery", pk, "{\"id\": " + std::to_string(pk) + ", \"unclaimed\": 0, \"retained\": 0, \"last_reward_date\": " +
+            time + ", \"next_moderate_date\": " + zero_time + ", \"next_archive_date\": " + zero_time +
+            ", \"unscheduled_gem_id\": \"18446744073709551615\"}");   // no gems before genesis
+    }
+
+    w.open("c.ctrl", "stat", "stat_struct");
+    for (const auto& p : points) {
+        uint64_t top_weight = 0;
+        int top_num = 0;
+        for (const auto& l : p.second.leaders) {
+            if (l.second.in_top) {
+                top_weight += l.second.weight;
+                top_num++;
+            }
+        }
+        auto pk = symbol_code_value(p.first);
+        w.row(p.first, "c.ctrl", pk, "{\"id\": " + std::to_string(pk) + ", \"retained\": 0, \"reward_per_weight\": \"0\", \"top_weight\": " +
+            std::to_string(top_weight) + ", \"top_num\": " + std::to_string(top_num) + ", \"leaders_num\": " + std::to_string(config::def_comm_leaders_num) + ", \"reward_dust\": \"0\"}");
+    }
+    w.open("c.ctrl", "leader", "leader_info");
+    for (const auto& p : points) {
+        for (const auto& l : p.second.leaders) {
+            w.row(p.first, l.first, name_value(l.first), "{\"name\": \"" + l.first + "\", \"active\": true, \"total_weight\": " +
+                std::to_string(l.second.weight) + ", \"counter_votes\": " + std::to_string(l.second.votes) +
+                ", \"unclaimed_points\": 0, \"in_top\": " + (l.second.in_top ? "true" : "false") + ", \"reward_checkpoint\": \"0\"}");
+        }
+    }
+    w.open("c.ctrl", "leadervote", "leader_voter");
+    for (const auto& p : points) {
+        uint64_t id = 0;
+        for (const auto& v : p.second.votes) {
+            w.row(p.first, v.voter, id, "{\"id\": " + std::to_string(id) + ", \"voter\": \"" + v.voter + "\", \"leader\": \"" +
+                v.leader + "\", \"pct\": " + std::to_string(v.pct) + "}");
+            id++;
+        }
+    }
+    w.open("c.ctrl", "voter", "voter_info");
+    for (const auto& p : points) {
+        for (const auto& v : p.second.voters) {
+            w.row(p.first, v.first, name_value(v.first), "{\"voter\": \"" + v.first + "\", \"votes_num\": " +
+                std::to_string(v.second.votes_num) + ", \"pct_sum\": " + std::to_string(v.second.pct_sum) + "}");
+        }
+    }
+}
+
+struct summary {
+    points_t points;
+    uint64_t balances = 0;
+};
+
+// writes the rows of the snapshot to params.out
+inline summary generate(const gen_params& params) {
+    summary ret;
+    read_definitions(params, ret.points);
+    auto parts = balance_writer(params, ret.points).run();
+    merge_parts(ret.points, parts);
+
+    std::ofstream out(params.out, std::ios::binary);
+    write_definitions(params, ret.points, out);
+    for (const auto& part : parts) {
+        if (part.rows) {
+            std::ifstream in(part.file, std::ios::binary);
+            out << in.rdbuf();
+        }
+        std::remove(part.file.c_str());
+        ret.balances += part.rows;
+    }
+    if (!out) {
+        throw gen_error("can't write " + params.out);
+    }
+    return ret;
+}
+
+} } // commun::genesis
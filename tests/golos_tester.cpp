@@ -25,12 +25,35 @@ void golos_tester::install_contract(
     set_abi (acc, abi.data(), signer);
     if (produce)
         produce_block();
-    const auto& accnt = _chaindb.get<account_object>(acc);
-    abi_def abi_d;
-    BOOST_CHECK_EQUAL(abi_serializer::to_abi(accnt.abi, abi_d), true);
-    _abis[acc].set_abi(abi_d, abi_serializer_max_time);
+    load_abi(acc);
 };
 
+void golos_tester::install_contracts(const vector<contract_code>& codes) {
+    for (const auto& c : codes) {
+        set_code(c.account, c.wasm);
+        set_abi (c.account, c.abi.data());
+    }
+    produce_block();
+    for (const auto& c : codes) {
+        load_abi(c.account);
+    }
+}
+
+// the same abi is installed by every test case, so the serializer is built once per process
+void golos_tester::load_abi(account_name acc) {
+    static std::map<fc::sha256, abi_serializer> cache;
+
+    const auto& accnt = _chaindb.get<account_object>(acc);
+    auto hash = fc::sha256::hash(accnt.abi.data(), accnt.abi.size());
+    auto itr = cache.find(hash);
+    if (itr == cache.end()) {
+        abi_def abi_d;
+        BOOST_CHECK_EQUAL(abi_serializer::to_abi(accnt.abi, abi_d), true);
+        itr = cache.emplace(hash, abi_serializer(abi_d, abi_serializer_max_time)).first;
+    }
+    _abis[acc] = itr->second;
+}
+
 vector<permission> golos_tester::get_account_permissions(account_name a) {
     vector<permission> r;
     auto table = _chaindb.get_table<permission_object>();
@@ -3,6 +3,9 @@
 #include <eosio/testing/tester.hpp>
 #include <eosio/chain/abi_serializer.hpp>
 #include <fc/variant_object.hpp>
+#include <fc/io/raw.hpp>
+#include <iterator>
+#include <optional>
 
 #define UNIT_TEST_ENV
 
@@ -43,12 +46,90 @@ struct action_data {
     variant_object data;
 };
 
+struct contract_code {
+    account_name account;
+    std::vector<uint8_t> wasm;
+    std::vector<char> abi;
+};
+
 struct contract_error_messages {
     string missing_auth(name arg) { return "missing authority of " + arg.to_string(); };
 protected:
     const string amsg(const string& x) { return base_tester::wasm_assert_msg(x); }
 };
 
+// Rows of a table read through a chaindb cursor as native structs. The binary data of a row (the same data
+// that multi_index of a contract reads) is unpacked with fc::raw into one reused object, no variants are built.
+// T should have the fields of the table struct in the ABI order and be declared with FC_REFLECT.
+// The iterators are input ones: they share the cursor of the range and are invalidated by ++.
+template<typename T>
+class chaindb_rows {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        explicit iterator(chaindb_rows* rows = nullptr): _rows(rows) {}
+        const T& operator*() const { return _rows->_row; }
+        const T* operator->() const { return &_rows->_row; }
+        iterator& operator++() {
+            if (!_rows->next()) {
+                _rows = nullptr;
+            }
+            return *this;
+        }
+        bool operator==(const iterator& other) const { return _rows == other._rows; }
+        bool operator!=(const iterator& other) const { return _rows != other._rows; }
+    private:
+        chaindb_rows* _rows;
+    };
+
+    chaindb_rows(cyberway::chaindb::chaindb_controller& chaindb, cyberway::chaindb::cursor_request cursor)
+    : _chaindb(chaindb), _cursor(cursor) {
+        _valid = read();
+    }
+    chaindb_rows(const chaindb_rows&) = delete;
+    chaindb_rows& operator=(const chaindb_rows&) = delete;
+
+    iterator begin() { return iterator(_valid ? this : nullptr); }
+    iterator end() { return iterator(); }
+
+    bool empty() const { return !_valid; }
+    uint64_t pk() const { return _pk; }  // primary key of the current row
+
+private:
+    bool next() {
+        if (_valid) {
+            _chaindb.next(_cursor);
+            _valid = read();
+        }
+        return _valid;
+    }
+
+    bool read() {
+        _pk = _chaindb.current(_cursor);
+        if (_pk == cyberway::chaindb::primary_key::End) {
+            return false;
+        }
+        auto size = _chaindb.datasize(_cursor);
+        _buffer.resize(size);
+        _chaindb.data(_cursor, _buffer.data(), _buffer.size());
+        fc::datastream<const char*> ds(_buffer.data(), _buffer.size());
+        fc::raw::unpack(ds, _row);
+        return true;
+    }
+
+    cyberway::chaindb::chaindb_controller& _chaindb;
+    cyberway::chaindb::cursor_request _cursor;
+    std::vector<char> _buffer;
+    T _row;
+    uint64_t _pk = cyberway::chaindb::primary_key::End;
+    bool _valid = false;
+};
 
 class golos_tester : public tester {
 protected:
@@ -67,6 +148,11 @@ public:
     }
 
     void install_contract(account_name acc, const std::vector<uint8_t>& wasm, const std::vector<char>& abi, bool produce = true, const private_key_type* signer = nullptr);
+    // sets code and abi of all contracts within one block;
+    // each test case still bootstraps its chain: chaindb of the tests runs on MongoDB and the controller
+    // can neither snapshot nor restore it, so a bootstrapped state can't be shared between the test cases
+    // until cyberway supports that (a separate request)
+    void install_contracts(const std::vector<contract_code>& codes);
 
     std::vector<permission> get_account_permissions(account_name a);
 
@@ -93,10 +179,36 @@ public:
         return r;
     }
 
+    // typed readers, see chaindb_rows; they are much faster than the variant ones on large tables
+    template<typename T>
+    chaindb_rows<T> scan_chaindb_rows(name code, uint64_t scope, name tbl, uint64_t from_pk = 0) const {
+        const auto& info = _chaindb.lower_bound({code, scope, tbl}, cyberway::chaindb::cursor_kind::ManyRecords, from_pk);
+        return chaindb_rows<T>(_chaindb, {code, info.cursor});
+    }
+
+    template<typename T, typename Key>
+    chaindb_rows<T> scan_chaindb_rows(name code, uint64_t scope, name tbl, name indx, const Key& key) const {
+        bytes data = fc::raw::pack(key);
+        const auto& info = _chaindb.lower_bound({code, scope, tbl, indx}, cyberway::chaindb::cursor_kind::ManyRecords, data.data(), data.size());
+        return chaindb_rows<T>(_chaindb, {code, info.cursor});
+    }
+
+    template<typename T>
+    std::optional<T> get_chaindb_row(name code, uint64_t scope, name tbl, uint64_t pk) const {
+        auto rows = scan_chaindb_rows<T>(code, scope, tbl, pk);
+        if (rows.empty() || rows.pk() != pk) {
+            return {};
+        }
+        return *rows.begin();
+    }
+
     fc::variant get_chaindb_struct(name code, uint64_t scope, name tbl, uint64_t id, const std::string& n) const;
     fc::variant get_chaindb_singleton(name code, uint64_t scope, name tbl, const std::string& n) const;
     std::vector<fc::variant> get_all_chaindb_rows(name code, uint64_t scope, name tbl, bool strict) const;
     signed_block_ptr wait_block(const uint32_t n);
+
+private:
+    void load_abi(account_name acc);
 };
 
 
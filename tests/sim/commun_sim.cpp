@@ -0,0 +1,671 @@
+// Reward distribution simulator.
+//
+// Replays vote streams of many communities without a chain and reports how the emission is split between
+// mosaics, gems and leaders, how many gems and mosaics are kept in tables and how many rows the actions touch.
+// The economic formulas come from include/commun/math.hpp and the grades from c.gallery config, so the numbers
+// follow the contracts. Every community is independent and is simulated by one worker thread.
+//
+// Usage: commun_sim [--name=value ...], see print_usage() for the options.
+// Recorded streams are csv files with the lines: time,community,account,action,tracery,points
+// where time is in seconds from the start and action is one of post, up, down, ban (account and points are ignored).
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#define UNIT_TEST_ENV
+#include <commun/math.hpp>
+#include <commun.gallery/config.hpp>
+
+using namespace commun;
+
+namespace {
+
+// defaults of c.list
+struct sim_params {
+    size_t  communities = 16;
+    size_t  threads = 0;
+    int64_t days = 30;
+    size_t  accounts = 1000;
+    size_t  posts_per_day = 50;
+    size_t  votes_per_day = 2000;
+    int64_t down_percent = 5 * 100;
+    int64_t ban_percent = 1 * 100;
+    int64_t min_vote = 10;
+    int64_t max_vote = 10000;
+    int64_t initial_supply = 100000000;
+    int64_t emission_rate = 20 * 100;
+    int64_t leaders_percent = 3 * 100;
+    int64_t author_percent = 50 * 100;
+    size_t  rewarded_mosaic_num = 10;
+    size_t  leaders_num = 3;
+    size_t  leader_candidates = 10;
+    int64_t collection_period = 7 * 24 * 60 * 60;
+    int64_t moderation_period = 3 * 24 * 60 * 60;
+    int64_t reward_mosaics_period = 60 * 60;
+    int64_t reward_leaders_period = 24 * 60 * 60;
+    bool    damned_gem_reward_enabled = false;
+    uint64_t seed = 1;
+    std::string votes_file;
+};
+
+enum class event_kind { post, up, down, ban };
+
+struct vote_event {
+    int64_t time;
+    uint32_t account;
+    event_kind kind;
+    uint64_t tracery;
+    int64_t points;
+};
+
+struct gem {
+    uint32_t owner;
+    int64_t points;
+    int64_t shares;
+};
+
+struct mosaic {
+    uint32_t creator;
+    int64_t collection_end;
+    int64_t points = 0;
+    int64_t shares = 0;
+    int64_t damn_points = 0;
+    int64_t damn_shares = 0;
+    int64_t comm_rating = 0;
+    int64_t reward = 0;
+    int64_t last_top_date = -1;
+    bool banned = false;
+    std::vector<gem> gems;
+};
+
+// rows read or written by the modeled actions, a proxy of their cost on the chain
+struct action_cost {
+    uint64_t calls = 0;
+    uint64_t rows = 0;
+    uint64_t max_rows = 0;
+
+    void add(uint64_t r) {
+        calls++;
+        rows += r;
+        max_rows = std::max(max_rows, r);
+    }
+    void merge(const action_cost& c) {
+        calls += c.calls;
+        rows += c.rows;
+        max_rows = std::max(max_rows, c.max_rows);
+    }
+};
+
+struct community_result {
+    int64_t supply_before = 0;
+    int64_t supply_after = 0;
+    int64_t mosaics_emission = 0;
+    int64_t leaders_emission = 0;
+    int64_t paid_to_gems = 0;
+    int64_t paid_to_leaders = 0;
+    int64_t gallery_retained = 0;
+    int64_t leaders_retained = 0;
+    int64_t unclaimed = 0;
+    uint64_t mosaics_created = 0;
+    uint64_t gems_created = 0;
+    uint64_t rejected_votes = 0;
+    uint64_t peak_mosaics = 0;
+    uint64_t peak_gems = 0;
+    action_cost post_cost, vote_cost, mosaics_reward_cost, leaders_reward_cost, chop_cost;
+    std::vector<int64_t> account_rewards;   // nonzero rewards of accounts, gems and leaders
+};
+
+class community_sim {
+    const sim_params& _p;
+    community_result& _r;
+    std::unordered_map<uint64_t, mosaic> _mosaics;
+    std::multimap<int64_t, uint64_t> _claims;   // claim date -> tracery
+    std::unordered_map<uint32_t, int64_t> _rewards;
+    std::vector<int64_t> _leader_weights;
+    int64_t _supply;
+    int64_t _gallery_retained = 0;
+    int64_t _leaders_retained = 0;
+    math::reward_acc_t _leaders_reward_per_weight = 0;
+    __int128 _leaders_reward_dust = 0;     // negative until the shares are accrued, as in c.ctrl
+    int64_t _last_reward_date = -1;
+    uint64_t _live_gems = 0;
+
+public:
+    community_sim(const sim_params& p, community_result& r, std::mt19937_64& rnd): _p(p), _r(r), _supply(p.initial_supply) {
+        std::uniform_int_distribution<int64_t> weight(1, 1000000);
+        for (size_t i = 0; i < p.leader_candidates; i++) {
+            _leader_weights.push_back(weight(rnd));
+        }
+        std::sort(_leader_weights.begin(), _leader_weights.end(), std::greater<int64_t>());
+        _r.supply_before = _supply;
+    }
+
+    void run(const std::vector<vote_event>& events) {
+        int64_t end = _p.days * 24 * 60 * 60;
+        int64_t next_mosaics_reward = _p.reward_mosaics_period;
+        int64_t next_leaders_reward = _p.reward_leaders_period;
+        auto ev = events.begin();
+        for (int64_t now = 0; now <= end; now = std::min({next_mosaics_reward, next_leaders_reward, end + 1})) {
+            for (; ev != events.end() && ev->time <= now; ++ev) {
+                apply(*ev);
+            }
+            chop_ready(now);
+            if (now == next_mosaics_reward) {
+                reward_mosaics(now);
+                next_mosaics_reward += _p.reward_mosaics_period;
+            }
+            if (now == next_leaders_reward) {
+                reward_leaders();
+                next_leaders_reward += _p.reward_leaders_period;
+            }
+        }
+        settle_leaders();
+        _r.supply_after = _supply;
+        _r.gallery_retained = _gallery_retained;
+        _r.leaders_retained = _leaders_retained;
+        for (const auto& a : _rewards) {
+            if (a.second) {
+                _r.account_rewards.push_back(a.second);
+            }
+        }
+    }
+
+private:
+    void update_peaks() {
+        _r.peak_mosaics = std::max<uint64_t>(_r.peak_mosaics, _mosaics.size());
+        _r.peak_gems = std::max(_r.peak_gems, _live_gems);
+    }
+
+    void apply(const vote_event& e) {
+        if (e.kind == event_kind::ban) {
+            auto itr = _mosaics.find(e.tracery);
+            if (itr != _mosaics.end()) {
+                itr->second.banned = true;
+            }
+            return;
+        }
+        if (e.kind == event_kind::post) {
+            if (_mosaics.count(e.tracery)) {
+                _r.rejected_votes++;
+                return;
+            }
+            mosaic m;
+            m.creator = e.account;
+            m.collection_end = e.time + _p.collection_period;
+            m.points = e.points;
+            m.shares = e.points;
+            m.comm_rating = e.points;
+            m.gems.push_back(gem{e.account, e.points, e.points});
+            _mosaics.emplace(e.tracery, std::move(m));
+            _claims.emplace(e.time + _p.collection_period + _p.moderation_period, e.tracery);
+            _r.mosaics_created++;
+            _r.gems_created++;
+            _live_gems++;
+            _r.post_cost.add(3);    // mosaic, gem, stat
+            update_peaks();
+            return;
+        }
+        auto itr = _mosaics.find(e.tracery);
+        if (itr == _mosaics.end() || e.time > itr->second.collection_end || itr->second.banned) {
+            _r.rejected_votes++;
+            return;
+        }
+        auto& m = itr->second;
+        bool damn = e.kind == event_kind::down;
+        int64_t shares_abs = 0;
+        math::shares_batch q{config::shares_cw, damn ? &m.damn_points : &m.points, damn ? &m.damn_shares : &m.shares,
+                             &e.points, &shares_abs, 1};
+        math::quote(q);
+        if (shares_abs == math::invalid_quote) {
+            _r.rejected_votes++;
+            return;
+        }
+        uint64_t rows = 3;  // mosaic, gem, stat
+        if (!damn) {
+            // pay_royalties: the creator's gems share the royalty proportionally to their shares
+            auto royalty = math::pct(shares_abs, _p.author_percent);
+            int64_t pre_shares_sum = 0;
+            for (const auto& g : m.gems) {
+                if (g.owner == m.creator) {
+                    pre_shares_sum += std::max<int64_t>(g.shares, 0);
+                    rows++;
+                }
+            }
+            int64_t paid = 0;
+            for (auto& g : m.gems) {
+                if (g.owner != m.creator || paid == royalty) {
+                    continue;
+                }
+                int64_t cur = g.shares > 0 ? math::prop(royalty, g.shares, pre_shares_sum) : (!pre_shares_sum ? royalty : 0);
+                if (cur > 0) {
+                    g.shares += cur;
+                    paid += cur;
+                }
+            }
+            m.shares += paid;
+            shares_abs -= paid;
+            m.points += e.points;
+            m.shares += shares_abs;
+            m.comm_rating += e.points;
+        }
+        else {
+            m.damn_points += e.points;
+            m.damn_shares += shares_abs;
+            m.comm_rating -= e.points;
+        }
+        m.gems.push_back(gem{e.account, e.points, damn ? -shares_abs : shares_abs});
+        _r.gems_created++;
+        _live_gems++;
+        _r.vote_cost.add(rows);
+        update_peaks();
+    }
+
+    // on_points_transfer of c.gallery; lead grades are not modeled, the simulator has no leader advice
+    void reward_mosaics(int64_t now) {
+        auto amount = math::emission_amount(_supply, _p.emission_rate, _p.reward_mosaics_period,
+                                            math::pct_base - _p.leaders_percent);
+        _supply += amount;
+        _r.mosaics_emission += amount;
+
+        std::vector<std::pair<uint64_t, const mosaic*>> active;
+        for (const auto& m : _mosaics) {
+            if (now <= m.second.collection_end && m.second.comm_rating > 0) {
+                active.emplace_back(m.first, &m.second);
+            }
+        }
+        auto by_comm_max = std::min(config::default_comm_grades.size(), active.size());
+        std::partial_sort(active.begin(), active.begin() + by_comm_max, active.end(), [](const auto& l, const auto& r) {
+            return l.second->comm_rating != r.second->comm_rating ? l.second->comm_rating > r.second->comm_rating : l.first > r.first;
+        });
+        active.resize(by_comm_max);
+
+        int64_t points_sum = 0;
+        for (const auto& m : active) {
+            points_sum += m.second->comm_rating;
+        }
+        std::vector<std::pair<uint64_t, int64_t>> top_mosaics;
+        for (size_t i = 0; i < active.size(); i++) {
+            top_mosaics.emplace_back(active[i].first, math::comm_grade_weight(config::default_comm_grades[i],
+                config::default_comm_points_grade_sum, active[i].second->comm_rating, points_sum));
+        }
+        auto middle = top_mosaics.begin() + std::min(_p.rewarded_mosaic_num, top_mosaics.size());
+        std::partial_sort(top_mosaics.begin(), middle, top_mosaics.end(),
+            [](const auto& lhs, const auto& rhs) { return lhs.second > rhs.second; });
+
+        int64_t grades_sum = 0;
+        for (auto itr = top_mosaics.begin(); itr != middle; itr++) {
+            grades_sum += itr->second;
+        }
+        auto total_reward = amount + _gallery_retained;
+        auto left_reward = total_reward;
+        for (auto itr = top_mosaics.begin(); itr != middle; itr++) {
+            auto& m = _mosaics.at(itr->first);
+            if (m.last_top_date == _last_reward_date) {
+                auto cur_reward = math::prop(total_reward, itr->second, grades_sum);
+                m.reward += cur_reward;
+                left_reward -= cur_reward;
+            }
+            m.last_top_date = now;
+        }
+        _gallery_retained = left_reward;
+        _last_reward_date = now;
+        _r.mosaics_reward_cost.add(active.size() + (middle - top_mosaics.begin()) + 1);
+    }
+
+    // on_points_transfer of c.ctrl with a static set of leaders, the shares are settled once at the end
+    void reward_leaders() {
+        auto amount = math::emission_amount(_supply, _p.emission_rate, _p.reward_leaders_period, _p.leaders_percent);
+        _supply += amount;
+        _r.leaders_emission += amount;
+
+        size_t l = std::min(_p.leaders_num, _leader_weights.size());
+        uint64_t weight_sum = 0;
+        for (size_t i = 0; i < l; i++) {
+            weight_sum += _leader_weights[i];
+        }
+        auto left_reward = amount + _leaders_retained;
+        if (weight_sum) {
+            auto reward_sum = math::leaders_reward_pool(left_reward, l, _p.leaders_num);
+            auto reward_per_weight = math::reward_per_weight(reward_sum, weight_sum);
+            _leaders_reward_per_weight += reward_per_weight;
+            _leaders_reward_dust -= static_cast<__int128>(math::reward_per_weight_excess(reward_sum, weight_sum));
+            left_reward -= reward_sum;
+        }
+        _leaders_retained = left_reward;
+        _r.leaders_reward_cost.add(1);
+    }
+
+    void settle_leaders() {
+        size_t l = std::min(_p.leaders_num, _leader_weights.size());
+        for (size_t i = 0; i < l; i++) {
+            auto leader_reward = math::accrued_reward(_leader_weights[i], _leaders_reward_per_weight, 0);
+            _leaders_reward_dust += math::accrued_remainder(_leader_weights[i], _leaders_reward_per_weight, 0);
+            // leaders are numbered after the accounts
+            _rewards[static_cast<uint32_t>(_p.accounts + i)] += leader_reward;
+            _r.paid_to_leaders += leader_reward;
+        }
+        const __int128 scale = math::reward_per_weight_scale;
+        if (_leaders_reward_dust >= scale) {
+            _leaders_retained += static_cast<int64_t>(_leaders_reward_dust / scale);
+            _leaders_reward_dust %= scale;
+        }
+    }
+
+    void chop_ready(int64_t now) {
+        auto end = _claims.upper_bound(now);
+        for (auto itr = _claims.begin(); itr != end; itr = _claims.erase(itr)) {
+            auto m_itr = _mosaics.find(itr->second);
+            auto& m = m_itr->second;
+            int64_t paid = 0;
+            for (const auto& g : m.gems) {
+                auto reward = math::gem_reward(m.reward, m.shares, m.damn_shares, g.shares,
+                                               m.banned, _p.damned_gem_reward_enabled);
+                if (reward) {
+                    _rewards[g.owner] += reward;
+                    paid += reward;
+                }
+                _r.chop_cost.add(3);   // gem, mosaic, stat
+            }
+            _r.paid_to_gems += paid;
+            _r.unclaimed += m.reward - paid;
+            _live_gems -= m.gems.size();
+            _mosaics.erase(m_itr);
+        }
+    }
+};
+
+std::vector<vote_event> generate_events(const sim_params& p, std::mt19937_64& rnd) {
+    std::vector<vote_event> events;
+    int64_t day = 24 * 60 * 60;
+    std::uniform_int_distribution<int64_t> time_of_day(0, day - 1);
+    std::uniform_int_distribution<uint32_t> account(0, static_cast<uint32_t>(p.accounts - 1));
+    std::uniform_int_distribution<int64_t> pct(0, math::pct_base - 1);
+    // vote sizes and post popularity are heavy tailed
+    std::lognormal_distribution<double> vote_size(std::log(static_cast<double>(p.min_vote) * 10), 1.0);
+    std::geometric_distribution<size_t> post_age(0.02);
+
+    uint64_t tracery = 0;
+    std::vector<std::pair<int64_t, uint64_t>> posts;
+    for (int64_t d = 0; d < p.days; d++) {
+        for (size_t i = 0; i < p.posts_per_day; i++) {
+            auto t = d * day + time_of_day(rnd);
+            events.push_back(vote_event{t, account(rnd), event_kind::post, ++tracery, p.min_vote});
+        }
+    }
+    std::sort(events.begin(), events.end(), [](const auto& l, const auto& r) { return l.time < r.time; });
+    for (const auto& e : events) {
+        posts.emplace_back(e.time, e.tracery);
+    }
+    // leaders ban some posts during the moderation period
+    for (const auto& post : posts) {
+        if (pct(rnd) < p.ban_percent) {
+            auto t = post.first + p.collection_period + std::min<int64_t>(p.moderation_period / 2, 60 * 60);
+            events.push_back(vote_event{t, 0, event_kind::ban, post.second, 0});
+        }
+    }
+    if (posts.empty()) {
+        return events;
+    }
+    for (int64_t d = 0; d < p.days; d++) {
+        for (size_t i = 0; i < p.votes_per_day; i++) {
+            auto t = d * day + time_of_day(rnd);
+            auto last = std::upper_bound(posts.begin(), posts.end(), std::make_pair(t, UINT64_MAX));
+            if (last == posts.begin()) {
+                continue;
+            }
+            auto age = std::min<size_t>(post_age(rnd), last - posts.begin() - 1);
+            auto points = std::clamp(static_cast<int64_t>(vote_size(rnd)), p.min_vote, p.max_vote);
+            auto kind = pct(rnd) < p.down_percent ? event_kind::down : event_kind::up;
+            events.push_back(vote_event{t, account(rnd), kind, (last - 1 - age)->second, points});
+        }
+    }
+    std::stable_sort(events.begin(), events.end(), [](const auto& l, const auto& r) { return l.time < r.time; });
+    return events;
+}
+
+std::map<uint32_t, std::vector<vote_event>> load_events(const std::string& file_name) {
+    std::ifstream in(file_name);
+    if (!in) {
+        throw std::runtime_error("can't open " + file_name);
+    }
+    std::map<uint32_t, std::vector<vote_event>> ret;
+    std::string line;
+    size_t line_num = 0;
+    while (std::getline(in, line)) {
+        line_num++;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream ss(line);
+        std::string time, community, account, action, tracery, points;
+        if (!std::getline(ss, time, ',') || !std::getline(ss, community, ',') || !std::getline(ss, account, ',') ||
+            !std::getline(ss, action, ',') || !std::getline(ss, tracery, ',') || !std::getline(ss, points, ',')) {
+            throw std::runtime_error("invalid line " + std::to_string(line_num));
+        }
+        static const std::map<std::string, event_kind> kinds = {
+            {"post", event_kind::post}, {"up", event_kind::up}, {"down", event_kind::down}, {"ban", event_kind::ban}};
+        auto kind = kinds.find(action);
+        if (kind == kinds.end()) {
+            throw std::runtime_error("unknown action at line " + std::to_string(line_num));
+        }
+        ret[std::stoul(community)].push_back(vote_event{std::stoll(time), static_cast<uint32_t>(std::stoul(account)), kind->second,
+                                                        std::stoull(tracery), std::stoll(points)});
+    }
+    for (auto& c : ret) {
+        std::stable_sort(c.second.begin(), c.second.end(), [](const auto& l, const auto& r) { return l.time < r.time; });
+    }
+    return ret;
+}
+
+void print_usage() {
+    sim_params d;
+    std::cout << "commun_sim [--name=value ...]\n"
+        << "  --communities=" << d.communities << "  --threads=<cores>  --days=" << d.days << "  --seed=" << d.seed << "\n"
+        << "  --accounts=" << d.accounts << "  --posts_per_day=" << d.posts_per_day << "  --votes_per_day=" << d.votes_per_day << "\n"
+        << "  --down_percent=" << d.down_percent << "  --ban_percent=" << d.ban_percent
+        << "  --min_vote=" << d.min_vote << "  --max_vote=" << d.max_vote << "\n"
+        << "  --initial_supply=" << d.initial_supply << "  --emission_rate=" << d.emission_rate
+        << "  --leaders_percent=" << d.leaders_percent << "  --author_percent=" << d.author_percent << "\n"
+        << "  --rewarded_mosaic_num=" << d.rewarded_mosaic_num << "  --leaders_num=" << d.leaders_num
+        << "  --leader_candidates=" << d.leader_candidates << "\n"
+        << "  --collection_period=" << d.collection_period << "  --moderation_period=" << d.moderation_period << "\n"
+        << "  --reward_mosaics_period=" << d.reward_mosaics_period << "  --reward_leaders_period=" << d.reward_leaders_period << "\n"
+        << "  --damned_gem_reward_enabled=0  --votes=<recorded stream csv>\n"
+        << "Percents are in 1/100 of percent as in c.list.\n";
+}
+
+sim_params parse_params(int argc, char** argv) {
+    sim_params p;
+    std::map<std::string, int64_t*> ints = {
+        {"days", &p.days}, {"down_percent", &p.down_percent}, {"ban_percent", &p.ban_percent},
+        {"min_vote", &p.min_vote}, {"max_vote", &p.max_vote}, {"initial_supply", &p.initial_supply},
+        {"emission_rate", &p.emission_rate}, {"leaders_percent", &p.leaders_percent}, {"author_percent", &p.author_percent},
+        {"collection_period", &p.collection_period}, {"moderation_period", &p.moderation_period},
+        {"reward_mosaics_period", &p.reward_mosaics_period}, {"reward_leaders_period", &p.reward_leaders_period}};
+    std::map<std::string, size_t*> sizes = {
+        {"communities", &p.communities}, {"threads", &p.threads}, {"accounts", &p.accounts},
+        {"posts_per_day", &p.posts_per_day}, {"votes_per_day", &p.votes_per_day},
+        {"rewarded_mosaic_num", &p.rewarded_mosaic_num}, {"leaders_num", &p.leaders_num},
+        {"leader_candidates", &p.leader_candidates}};
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto eq = arg.find('=');
+        if (arg.compare(0, 2, "--") || eq == std::string::npos) {
+            throw std::invalid_argument(arg);
+        }
+        auto key = arg.substr(2, eq - 2);
+        auto value = arg.substr(eq + 1);
+        if (ints.count(key)) {
+            *ints[key] = std::stoll(value);
+        } else if (sizes.count(key)) {
+            *sizes[key] = std::stoull(value);
+        } else if (key == "seed") {
+            p.seed = std::stoull(value);
+        } else if (key == "votes") {
+            p.votes_file = value;
+        } else if (key == "damned_gem_reward_enabled") {
+            p.damned_gem_reward_enabled = value != "0";
+        } else {
+            throw std::invalid_argument(arg);
+        }
+    }
+    if (p.reward_mosaics_period <= 0 || p.reward_leaders_period <= 0 || p.days <= 0 || !p.accounts ||
+        p.min_vote <= 0 || p.max_vote < p.min_vote || p.leaders_percent < 0 || p.leaders_percent > math::pct_base) {
+        throw std::invalid_argument("inconsistent parameters");
+    }
+    if (!p.threads) {
+        p.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return p;
+}
+
+int64_t percentile(const std::vector<int64_t>& sorted, double q) {
+    return sorted.empty() ? 0 : sorted[std::min(sorted.size() - 1, static_cast<size_t>(q * sorted.size()))];
+}
+
+double gini(const std::vector<int64_t>& sorted) {
+    long double weighted = 0, sum = 0;
+    for (size_t i = 0; i < sorted.size(); i++) {
+        weighted += static_cast<long double>(i + 1) * sorted[i];
+        sum += sorted[i];
+    }
+    auto n = static_cast<long double>(sorted.size());
+    return sum > 0 ? static_cast<double>((2 * weighted) / (n * sum) - (n + 1) / n) : 0.0;
+}
+
+void print_cost(const char* action, const action_cost& c) {
+    std::cout << "  " << std::left << std::setw(16) << action << std::right
+              << " calls " << std::setw(10) << c.calls
+              << "  rows/call " << std::setw(8) << std::fixed << std::setprecision(2)
+              << (c.calls ? static_cast<double>(c.rows) / c.calls : 0.0)
+              << "  max rows " << c.max_rows << "\n";
+}
+
+void report(const sim_params& p, std::vector<community_result>& results, double seconds) {
+    community_result total;
+    std::vector<int64_t> rewards;
+    uint64_t max_peak_gems = 0, max_peak_mosaics = 0;
+    for (auto& r : results) {
+        total.supply_before += r.supply_before;
+        total.supply_after += r.supply_after;
+        total.mosaics_emission += r.mosaics_emission;
+        total.leaders_emission += r.leaders_emission;
+        total.paid_to_gems += r.paid_to_gems;
+        total.paid_to_leaders += r.paid_to_leaders;
+        total.gallery_retained += r.gallery_retained;
+        total.leaders_retained += r.leaders_retained;
+        total.unclaimed += r.unclaimed;
+        total.mosaics_created += r.mosaics_created;
+        total.gems_created += r.gems_created;
+        total.rejected_votes += r.rejected_votes;
+        total.peak_mosaics += r.peak_mosaics;
+        total.peak_gems += r.peak_gems;
+        max_peak_gems = std::max(max_peak_gems, r.peak_gems);
+        max_peak_mosaics = std::max(max_peak_mosaics, r.peak_mosaics);
+        total.post_cost.merge(r.post_cost);
+        total.vote_cost.merge(r.vote_cost);
+        total.mosaics_reward_cost.merge(r.mosaics_reward_cost);
+        total.leaders_reward_cost.merge(r.leaders_reward_cost);
+        total.chop_cost.merge(r.chop_cost);
+        rewards.insert(rewards.end(), r.account_rewards.begin(), r.account_rewards.end());
+    }
+    std::sort(rewards.begin(), rewards.end());
+    auto in_gems = total.mosaics_emission - total.paid_to_gems - total.unclaimed - total.gallery_retained;
+
+    std::cout << "communities " << results.size() << ", days " << p.days << ", threads " << p.threads
+              << ", simulated in " << std::fixed << std::setprecision(2) << seconds << " s\n"
+              << "emission\n"
+              << "  supply            " << total.supply_before << " -> " << total.supply_after << "\n"
+              << "  to mosaics        " << total.mosaics_emission << "\n"
+              << "  to leaders        " << total.leaders_emission << "\n"
+              << "rewards\n"
+              << "  paid to gems      " << total.paid_to_gems << "\n"
+              << "  in unchopped gems " << in_gems << "\n"
+              << "  unclaimed         " << total.unclaimed << "\n"
+              << "  gallery retained  " << total.gallery_retained << "\n"
+              << "  paid to leaders   " << total.paid_to_leaders << "\n"
+              << "  leaders retained  " << total.leaders_retained << "\n"
+              << "  rewarded accounts " << rewards.size()
+              << ", p50 " << percentile(rewards, 0.5) << ", p90 " << percentile(rewards, 0.9)
+              << ", p99 " << percentile(rewards, 0.99) << ", max " << (rewards.empty() ? 0 : rewards.back())
+              << ", gini " << std::setprecision(3) << gini(rewards) << "\n"
+              << "tables\n"
+              << "  mosaics created   " << total.mosaics_created << ", peak " << total.peak_mosaics
+              << " (max per community " << max_peak_mosaics << ")\n"
+              << "  gems created      " << total.gems_created << ", peak " << total.peak_gems
+              << " (max per community " << max_peak_gems << ")\n"
+              << "  rejected events   " << total.rejected_votes << "\n"
+              << "rows touched per action\n";
+    print_cost("create mosaic", total.post_cost);
+    print_cost("add to mosaic", total.vote_cost);
+    print_cost("mosaics reward", total.mosaics_reward_cost);
+    print_cost("leaders reward", total.leaders_reward_cost);
+    print_cost("chop gem", total.chop_cost);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    sim_params p;
+    std::map<uint32_t, std::vector<vote_event>> recorded;
+    try {
+        if (argc > 1 && (std::string(argv[1]) == "--help" || std::string(argv[1]) == "-h")) {
+            print_usage();
+            return 0;
+        }
+        p = parse_params(argc, argv);
+        if (!p.votes_file.empty()) {
+            recorded = load_events(p.votes_file);
+            p.communities = recorded.size();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << "\n";
+        print_usage();
+        return 1;
+    }
+
+    std::vector<uint32_t> ids;
+    for (const auto& c : recorded) {
+        ids.push_back(c.first);
+    }
+    std::vector<community_result> results(p.communities);
+    std::atomic<size_t> next{0};
+    auto started = std::chrono::steady_clock::now();
+
+    auto worker = [&]() {
+        for (size_t i = next++; i < p.communities; i = next++) {
+            // results don't depend on the number of threads
+            std::mt19937_64 rnd(p.seed + i);
+            community_sim sim(p, results[i], rnd);
+            if (recorded.empty()) {
+                sim.run(generate_events(p, rnd));
+            } else {
+                sim.run(recorded.at(ids[i]));
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < std::min(p.threads, p.communities); t++) {
+        workers.emplace_back(worker);
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+    report(p, results, elapsed.count());
+    return 0;
+}